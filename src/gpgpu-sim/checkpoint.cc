@@ -0,0 +1,152 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "checkpoint.h"
+#include "mem_fetch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define CHECKPOINT_MAGIC "GPGPU-Sim timing checkpoint v2"
+
+checkpoint_file::checkpoint_file( const char *filename, bool save, gpgpu_sim *gpu )
+{
+    m_filename = filename;
+    m_save = save;
+    m_gpu = gpu;
+    m_fp = fopen(filename, save?"wb":"rb");
+    if( m_fp == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** could not open timing checkpoint \"%s\" for %s\n",
+               filename, save?"writing":"reading");
+        abort();
+    }
+    section(CHECKPOINT_MAGIC);
+}
+
+checkpoint_file::~checkpoint_file()
+{
+    assert( m_unbound.empty() );
+    section("end");
+    if( fclose(m_fp) != 0 )
+        fail("close");
+}
+
+void checkpoint_file::fail( const char *what )
+{
+    printf("GPGPU-Sim uArch: ERROR ** timing checkpoint \"%s\": %s failed\n", m_filename, what);
+    abort();
+}
+
+void checkpoint_file::raw( void *data, size_t size )
+{
+    if( size == 0 )
+        return;
+    if( m_save ) {
+        if( fwrite(data,size,1,m_fp) != 1 )
+            fail("write");
+    } else {
+        if( fread(data,size,1,m_fp) != 1 )
+            fail("read (truncated file?)");
+    }
+}
+
+void checkpoint_file::section( const char *name )
+{
+    char tag[64];
+    memset(tag,0,sizeof(tag));
+    strncpy(tag,name,sizeof(tag)-1);
+    char found[64];
+    memcpy(found,tag,sizeof(tag));
+    raw(found,sizeof(found));
+    if( !m_save && memcmp(found,tag,sizeof(tag)) != 0 ) {
+        found[sizeof(found)-1] = 0;
+        printf("GPGPU-Sim uArch: ERROR ** timing checkpoint \"%s\": expected section \"%s\", found \"%s\"\n",
+               m_filename, tag, found);
+        printf("GPGPU-Sim uArch:          (was the checkpoint taken with a different configuration?)\n");
+        abort();
+    }
+}
+
+void checkpoint_file::check_size( size_t n, const char *what )
+{
+    size_t found = n;
+    pod(found);
+    if( found != n ) {
+        printf("GPGPU-Sim uArch: ERROR ** timing checkpoint \"%s\": %s has %zu entries, this configuration has %zu\n",
+               m_filename, what, found, n);
+        abort();
+    }
+}
+
+bool checkpoint_file::ref_raw( void *&p, unsigned id, const char *kind )
+{
+    bool present = p != NULL;
+    pod(present);
+    if( !present ) {
+        p = NULL;
+        return false;
+    }
+    pod(id);
+    ref_key key(kind,id);
+    bool first = m_save && m_saved.insert(key).second;
+    pod(first);
+    if( m_save ) 
+        return first;
+    if( first ) {
+        p = NULL;
+        m_unbound.push_back(key);
+        return true;
+    }
+    std::map<ref_key,void*>::iterator r = m_restored.find(key);
+    if( r == m_restored.end() ) {
+        printf("GPGPU-Sim uArch: ERROR ** timing checkpoint \"%s\": %s %u referenced before it was restored\n", 
+               m_filename, kind, id);
+        abort();
+    }
+    p = r->second;
+    return false;
+}
+
+void checkpoint_file::bind( void *p )
+{
+    assert( !m_save && !m_unbound.empty() && p );
+    m_restored[m_unbound.back()] = p;
+    m_unbound.pop_back();
+}
+
+void checkpoint_file::mem_fetch_ref( mem_fetch *&mf )
+{
+    if( ref(mf, mf? mf->get_request_uid() : 0, "mem_fetch") ) {
+        if( m_save ) {
+            mf->checkpoint(*this);
+        } else {
+            mf = new mem_fetch(*this);
+            bind(mf);
+        }
+    }
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <list>
+#include <string>
+
+class mem_fetch;
+
+// Binary file holding the timing model state, between two grid launches or 
+// in the middle of a grid.
+//
+// The same checkpoint( checkpoint_file &cp ) method of each component is used
+// to save and to restore its state: the direction is decided by the file, so
+// the two can never disagree about the layout. Each component starts with a
+// section() marker so a checkpoint taken with a different configuration is
+// detected at the point where it diverges instead of silently misloading.
+class checkpoint_file {
+public:
+    checkpoint_file( const char *filename, bool save, class gpgpu_sim *gpu );
+    ~checkpoint_file();
+
+    bool saving() const { return m_save; }
+    // simulator being saved or restored, restored objects are bound to it
+    class gpgpu_sim *gpu() const { return m_gpu; }
+
+    void section( const char *name );
+    void raw( void *data, size_t size );
+    template<class T> void pod( T &v ) { raw(&v,sizeof(T)); }
+    template<class T> void array( T *v, size_t n ) { raw(v,n*sizeof(T)); }
+
+    // sizes are checked on restore: the restoring simulator is built from the
+    // same configuration and has already allocated the arrays
+    void check_size( size_t n, const char *what );
+
+    template<class T> void vector( std::vector<T> &v )
+    {
+        size_t n = v.size();
+        pod(n);
+        v.resize(n);
+        if( n )
+            array(&v[0],n);
+    }
+    template<class T> void vector2d( std::vector< std::vector<T> > &v )
+    {
+        size_t n = v.size();
+        pod(n);
+        v.resize(n);
+        for( size_t i=0; i < n; i++ )
+            vector(v[i]);
+    }
+    void string( std::string &s )
+    {
+        std::vector<char> v(s.begin(),s.end());
+        vector(v);
+        if( !m_save )
+            s.assign(v.begin(),v.end());
+    }
+    template<class T> void set( std::set<T> &s )
+    {
+        std::vector<T> v(s.begin(),s.end());
+        vector(v);
+        if( !m_save )
+            s = std::set<T>(v.begin(),v.end());
+    }
+    template<class K, class V> void map( std::map<K,V> &m )
+    {
+        std::vector< std::pair<K,V> > v(m.begin(),m.end());
+        vector(v);
+        if( !m_save )
+            m = std::map<K,V>(v.begin(),v.end());
+    }
+
+    // A request in flight is reached from several places at once (an MSHR 
+    // and the miss queue, a DRAM bank and the write pipeline, ...). The first 
+    // reference writes the object, later ones only its id, and a restore 
+    // hands the one object it rebuilt to every reference. ref() returns true 
+    // when the caller has to checkpoint the object itself; on restore p is 
+    // then NULL and the caller registers the new object with bind().
+    template<class T> bool ref( T *&p, unsigned id, const char *kind )
+    {
+        void *v = p;
+        bool first = ref_raw(v,id,kind);
+        p = (T*)v;
+        return first;
+    }
+    void bind( void *p );
+    // requests are identified by their uid
+    void mem_fetch_ref( mem_fetch *&mf );
+    // a queue of requests, NULL entries (pipeline delay slots) included
+    void mem_fetch_refs( std::vector<mem_fetch*> &v )
+    {
+        size_t n = v.size();
+        pod(n);
+        v.resize(n);
+        for( size_t i=0; i < n; i++ )
+            mem_fetch_ref(v[i]);
+    }
+    void mem_fetch_refs( std::list<mem_fetch*> &l )
+    {
+        std::vector<mem_fetch*> v(l.begin(),l.end());
+        mem_fetch_refs(v);
+        if( !m_save )
+            l.assign(v.begin(),v.end());
+    }
+    // a fifo_pipeline<mem_fetch>
+    template<class Q> void mem_fetch_pipeline( Q &q )
+    {
+        std::vector<mem_fetch*> v = q.get_slots();
+        unsigned n_element = q.get_n_element();
+        unsigned min_len = q.get_min_length();
+        mem_fetch_refs(v);
+        pod(n_element);
+        pod(min_len);
+        if( !m_save )
+            q.set_slots(v,n_element,min_len);
+    }
+    // bookkeeping kept per request, V is plain data
+    template<class V> void mem_fetch_map( std::map<mem_fetch*,V> &m )
+    {
+        std::vector<mem_fetch*> keys;
+        std::vector<V> values;
+        for( typename std::map<mem_fetch*,V>::iterator i=m.begin(); i != m.end(); ++i ) {
+            keys.push_back(i->first);
+            values.push_back(i->second);
+        }
+        mem_fetch_refs(keys);
+        vector(values);
+        if( !m_save ) {
+            m.clear();
+            for( size_t i=0; i < keys.size(); i++ )
+                m[keys[i]] = values[i];
+        }
+    }
+
+private:
+    void fail( const char *what );
+    bool ref_raw( void *&p, unsigned id, const char *kind );
+
+    FILE *m_fp;
+    bool m_save;
+    const char *m_filename;
+    class gpgpu_sim *m_gpu;
+
+    typedef std::pair<std::string,unsigned> ref_key;
+    std::set<ref_key> m_saved;             // objects already written
+    std::map<ref_key,void*> m_restored;    // objects already rebuilt
+    std::vector<ref_key> m_unbound;        // rebuilt objects awaiting bind()
+};
+
+#endif
@@ -34,6 +34,7 @@
 
 #include "../statwrapper.h"
 #include "gpu-misc.h"
+#include <vector>
 
 template <class T>
 struct fifo_data {
@@ -165,6 +166,41 @@ public:
    unsigned get_n_element() const { return m_n_element; }
    unsigned get_length() const { return m_length; }
    unsigned get_max_len() const { return m_max_len; }
+   unsigned get_min_length() const { return m_min_len; }
+
+   // mid-kernel timing checkpoints: the slots from head to tail, the NULL 
+   // delay slots included, get_n_element() and get_min_length()
+   std::vector<T*> get_slots() const
+   {
+      std::vector<T*> slots;
+      for (fifo_data<T>* ddp = m_head; ddp; ddp = ddp->m_next) 
+         slots.push_back(ddp->m_data);
+      return slots;
+   }
+   void set_slots( const std::vector<T*> &slots, unsigned n_element, unsigned min_len )
+   {
+      assert(slots.size() <= m_max_len);
+      while (m_head) {
+         m_tail = m_head;
+         m_head = m_head->m_next;
+         delete m_tail;
+      }
+      m_tail = NULL;
+      m_length = 0;
+      for (unsigned i=0;i<slots.size();i++) {
+         fifo_data<T> *node = new fifo_data<T>();
+         node->m_data = slots[i];
+         node->m_next = NULL;
+         if (m_tail) 
+            m_tail->m_next = node;
+         else 
+            m_head = node;
+         m_tail = node;
+         m_length++;
+      }
+      m_n_element = n_element;
+      m_min_len = min_len;
+   }
 
    void print() const
    {
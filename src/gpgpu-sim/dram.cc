@@ -33,6 +33,9 @@
 #include "dram_sched.h"
 #include "mem_fetch.h"
 #include "l2cache.h"
+#include "checkpoint.h"
+
+#include <algorithm>
 
 #ifdef DRAM_VERIFY
 int PRINT_CYCLE = 0;
@@ -42,10 +45,11 @@ template class fifo_pipeline<mem_fetch>;
 template class fifo_pipeline<dram_req_t>;
 
 dram_t::dram_t( unsigned int partition_id, const struct memory_config *config, memory_stats_t *stats,
-                memory_partition_unit *mp )
+                memory_partition_unit *mp, gpgpu_sim *gpu )
 {
    id = partition_id;
    m_memory_partition_unit = mp;
+   m_gpu = gpu;
    m_stats = stats;
    m_config = config;
 
@@ -159,9 +163,9 @@ dram_req_t::dram_req_t( class mem_fetch *mf )
    col = tlx.col; 
    nbytes = mf->get_data_size();
 
-   timestamp = gpu_tot_sim_cycle + gpu_sim_cycle;
+   timestamp = mf->get_gpu()->gpu_tot_sim_cycle + mf->get_gpu()->gpu_sim_cycle;
    addr = mf->get_addr();
-   insertion_time = (unsigned) gpu_sim_cycle;
+   insertion_time = (unsigned) mf->get_gpu()->gpu_sim_cycle;
    rw = data->get_is_write()?WRITE:READ;
 }
 
@@ -170,7 +174,7 @@ void dram_t::push( class mem_fetch *data )
    assert(id == data->get_tlx_addr().chip); // Ensure request is in correct memory partition
 
    dram_req_t *mrq = new dram_req_t(data);
-   data->set_status(IN_PARTITION_MC_INTERFACE_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+   data->set_status(IN_PARTITION_MC_INTERFACE_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
    mrqq->push(mrq);
 
    // stats...
@@ -183,7 +187,18 @@ void dram_t::push( class mem_fetch *data )
    } else {
       max_mrqs_temp = (max_mrqs_temp > mrqq->get_length())? max_mrqs_temp : mrqq->get_length();
    }
-   m_stats->memlatstat_dram_access(data);
+   // memlatstat_dram_access() also updates per-shader and per-source-line logs
+   if (m_memory_partition_unit->defer_shared_updates()) 
+      m_deferred_dram_access.push_back(data);
+   else 
+      m_stats->memlatstat_dram_access(data);
+}
+
+void dram_t::merge_deferred()
+{
+   for (unsigned i=0; i < m_deferred_dram_access.size(); i++) 
+      m_stats->memlatstat_dram_access(m_deferred_dram_access[i]);
+   m_deferred_dram_access.clear();
 }
 
 void dram_t::scheduler_fifo()
@@ -191,7 +206,7 @@ void dram_t::scheduler_fifo()
    if (!mrqq->empty()) {
       unsigned int bkn;
       dram_req_t *head_mrqq = mrqq->top();
-      head_mrqq->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+      head_mrqq->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
       bkn = head_mrqq->bk;
       if (!bk[bkn]->mrq) 
          bk[bkn]->mrq = mrqq->pop();
@@ -214,7 +229,7 @@ void dram_t::cycle()
            cmd->dqbytes += m_config->dram_atom_size; 
            if (cmd->dqbytes >= cmd->nbytes) {
               mem_fetch *data = cmd->data; 
-              data->set_status(IN_PARTITION_MC_RETURNQ,gpu_sim_cycle+gpu_tot_sim_cycle); 
+              data->set_status(IN_PARTITION_MC_RETURNQ,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle); 
               if( data->get_access_type() != L1_WRBK_ACC && data->get_access_type() != L2_WRBK_ACC ) {
                  data->set_reply();
                  returnq->push(data);
@@ -263,7 +278,7 @@ void dram_t::cycle()
       unsigned j = (i + prio) % m_config->nbk;
 	  unsigned grp = j>>m_config->bk_tag_length;
       if (bk[j]->mrq) { //if currently servicing a memory request
-          bk[j]->mrq->data->set_status(IN_PARTITION_DRAM,gpu_sim_cycle+gpu_tot_sim_cycle);
+          bk[j]->mrq->data->set_status(IN_PARTITION_DRAM,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
          // correct row activated for a READ
          if ( !issued && !CCDc && !bk[j]->RCDc &&
               !(bkgrp[grp]->CCDLc) &&
@@ -396,7 +411,16 @@ void dram_t::cycle()
    n_cmd++;
    n_cmd_partial++;
 
-   // decrements counters once for each time dram_issueCMD is called
+   decrement_timers();
+
+#ifdef DRAM_VISUALIZE
+   visualize();
+#endif
+}
+
+// decrements counters once for each time dram_issueCMD is called
+void dram_t::decrement_timers()
+{
    DEC2ZERO(RRDc);
    DEC2ZERO(CCDc);
    DEC2ZERO(RTWc);
@@ -414,10 +438,61 @@ void dram_t::cycle()
 	   DEC2ZERO(bkgrp[j]->CCDLc);
 	   DEC2ZERO(bkgrp[j]->RTPLc);
    }
+}
 
-#ifdef DRAM_VISUALIZE
-   visualize();
-#endif
+static unsigned max_timer( unsigned a, unsigned b, unsigned c, unsigned d )
+{
+   return std::max(std::max(a,b),std::max(c,d));
+}
+
+// Every command cycle() can issue waits for the timers of its bank to reach 
+// zero, so until the earliest of them does cycle() only counts down.
+unsigned dram_t::blocked_cycles() const
+{
+   if ( rwq->get_n_element() || returnq->get_n_element() || rwq->full() ) 
+      return 0;
+   if ( !mrqq->empty() || (m_frfcfs_scheduler && m_frfcfs_scheduler->num_pending()) ) 
+      return 0;
+   unsigned blocked = ~0u;
+   for (unsigned j=0;j<m_config->nbk;j++) {
+      if (!bk[j]->mrq) 
+         continue;
+      unsigned grp = j>>m_config->bk_tag_length;
+      unsigned wait;
+      if (bk[j]->state == BANK_IDLE) 
+         wait = max_timer(RRDc, bk[j]->RPc, bk[j]->RCc, 0);
+      else if (bk[j]->curr_row != bk[j]->mrq->row) 
+         wait = max_timer(bk[j]->RASc, bk[j]->WTPc, bk[j]->RTPc, bkgrp[grp]->RTPLc);
+      else if (bk[j]->mrq->rw == READ) 
+         wait = max_timer(CCDc, bk[j]->RCDc, bkgrp[grp]->CCDLc, WTRc);
+      else 
+         wait = max_timer(CCDc, bk[j]->RCDWRc, bkgrp[grp]->CCDLc, RTWc);
+      blocked = std::min(blocked, wait);
+   }
+   return blocked;
+}
+
+void dram_t::skip_cycle()
+{
+   unsigned k=m_config->nbk;
+   for (unsigned j=0;j<m_config->nbk;j++) {
+      if (bk[j]->mrq) {
+         bk[j]->mrq->data->set_status(IN_PARTITION_DRAM,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
+      } else {
+         if (!CCDc && !RRDc && !RTWc && !WTRc && !bk[j]->RCDc && !bk[j]->RASc
+             && !bk[j]->RCc && !bk[j]->RPc  && !bk[j]->RCDWRc) k--;
+         bk[j]->n_idle++;
+      }
+   }
+   n_nop++;
+   n_nop_partial++;
+   if (k) {
+      n_activity++;
+      n_activity_partial++;
+   }
+   n_cmd++;
+   n_cmd_partial++;
+   decrement_timers();
 }
 
 //if mrq is being serviced by dram, gets popped after CL latency fulfilled
@@ -553,3 +628,91 @@ void dram_t::set_dram_power_stats(	unsigned &cmd,
 	wr = n_wr;
 	req = n_req;
 }
+
+void dram_t::checkpoint_req( checkpoint_file &cp, dram_req_t *&req )
+{
+   if ( !cp.ref(req, req? req->data->get_request_uid() : 0, "dram_req_t") ) 
+      return;
+   mem_fetch *data = req? req->data : NULL;
+   cp.mem_fetch_ref(data);
+   if ( !cp.saving() ) {
+      req = new dram_req_t(data);
+      cp.bind(req);
+   }
+   cp.pod(req->row);
+   cp.pod(req->col);
+   cp.pod(req->bk);
+   cp.pod(req->nbytes);
+   cp.pod(req->txbytes);
+   cp.pod(req->dqbytes);
+   cp.pod(req->age);
+   cp.pod(req->timestamp);
+   cp.pod(req->rw);
+   cp.pod(req->addr);
+   cp.pod(req->insertion_time);
+}
+
+void dram_t::checkpoint_req_pipeline( checkpoint_file &cp, fifo_pipeline<dram_req_t> &q )
+{
+   std::vector<dram_req_t*> slots = q.get_slots();
+   unsigned n_element = q.get_n_element();
+   unsigned min_len = q.get_min_length();
+   size_t n = slots.size();
+   cp.pod(n);
+   slots.resize(n);
+   for (size_t i=0;i<n;i++) 
+      checkpoint_req(cp,slots[i]);
+   cp.pod(n_element);
+   cp.pod(min_len);
+   if ( !cp.saving() ) 
+      q.set_slots(slots,n_element,min_len);
+}
+
+void dram_t::checkpoint( checkpoint_file &cp )
+{
+   cp.section("dram");
+   cp.check_size(m_config->nbk,"dram banks");
+   for (unsigned i=0;i<m_config->nbk;i++) {
+      dram_req_t *mrq = bk[i]->mrq;
+      cp.pod(*bk[i]);
+      bk[i]->mrq = mrq;
+      checkpoint_req(cp,bk[i]->mrq);
+   }
+   cp.array(bkgrp[0],m_config->nbkgrp);
+   checkpoint_req_pipeline(cp,*rwq);
+   checkpoint_req_pipeline(cp,*mrqq);
+   cp.mem_fetch_pipeline(*returnq);
+   if ( m_frfcfs_scheduler ) 
+      m_frfcfs_scheduler->checkpoint(cp);
+   cp.pod(prio);
+   cp.pod(RRDc);
+   cp.pod(CCDc);
+   cp.pod(RTWc);
+   cp.pod(WTRc);
+   cp.pod(rw);
+   cp.pod(dram_util_bins);
+   cp.pod(dram_eff_bins);
+   cp.pod(last_n_cmd);
+   cp.pod(last_n_activity);
+   cp.pod(last_bwutil);
+   cp.pod(n_cmd);
+   cp.pod(n_activity);
+   cp.pod(n_nop);
+   cp.pod(n_act);
+   cp.pod(n_pre);
+   cp.pod(n_rd);
+   cp.pod(n_wr);
+   cp.pod(n_req);
+   cp.pod(max_mrqs_temp);
+   cp.pod(bwutil);
+   cp.pod(max_mrqs);
+   cp.pod(ave_mrqs);
+   cp.pod(n_cmd_partial);
+   cp.pod(n_activity_partial);
+   cp.pod(n_nop_partial);
+   cp.pod(n_act_partial);
+   cp.pod(n_pre_partial);
+   cp.pod(n_req_partial);
+   cp.pod(ave_mrqs_partial);
+   cp.pod(bwutil_partial);
+}
@@ -31,6 +31,7 @@
 
 #include "delayqueue.h"
 #include <set>
+#include <vector>
 #include <zlib.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -93,7 +94,7 @@ class dram_t
 {
 public:
    dram_t( unsigned int parition_id, const struct memory_config *config, class memory_stats_t *stats, 
-           class memory_partition_unit *mp );
+           class memory_partition_unit *mp, class gpgpu_sim *gpu );
 
    bool full() const;
    void print( FILE* simFile ) const;
@@ -109,6 +110,17 @@ public:
    void push( class mem_fetch *data );
    void cycle();
    void dram_log (int task);
+   // DRAM cycles before a command can issue: 0 if the DRAM has work now, 
+   // ~0u if it holds no request
+   unsigned blocked_cycles() const;
+   // equivalent of cycle() while blocked_cycles() > 0
+   void skip_cycle();
+
+   // save/restore bank state, counters and the requests in flight
+   void checkpoint( class checkpoint_file &cp );
+   // records the memory statistics of requests accepted while the memory 
+   // partitions were stepped on multiple host threads
+   void merge_deferred();
 
    class memory_partition_unit *m_memory_partition_unit;
    unsigned int id;
@@ -124,7 +136,12 @@ public:
 								unsigned &req) const;
 
 private:
+   // a request shared by a bank and the bursts in the read/write pipeline
+   static void checkpoint_req( class checkpoint_file &cp, dram_req_t *&req );
+   void checkpoint_req_pipeline( class checkpoint_file &cp, fifo_pipeline<dram_req_t> &q );
+
    void scheduler_fifo();
+   void decrement_timers();
    void scheduler_frfcfs();
 
    const struct memory_config *m_config;
@@ -179,7 +196,9 @@ private:
    unsigned int bwutil_partial;
 
    struct memory_stats_t *m_stats;
+   class gpgpu_sim *m_gpu;
    class Stats* mrqq_Dist; //memory request queue inside DRAM  
+   std::vector<class mem_fetch*> m_deferred_dram_access;
 
    friend class frfcfs_scheduler;
 };
@@ -30,6 +30,8 @@
 #include "gpu-sim.h"
 #include "../abstract_hardware_model.h"
 #include "mem_latency_stat.h"
+#include "checkpoint.h"
+#include "host_profile.h"
 
 frfcfs_scheduler::frfcfs_scheduler( const memory_config *config, dram_t *dm, memory_stats_t *stats )
 {
@@ -62,13 +64,13 @@ void frfcfs_scheduler::add_req( dram_req_t *req )
 
 void frfcfs_scheduler::data_collection(unsigned int bank)
 {
-   if (gpu_sim_cycle > row_service_timestamp[bank]) {
-      curr_row_service_time[bank] = gpu_sim_cycle - row_service_timestamp[bank];
+   if (m_dram->m_gpu->gpu_sim_cycle > row_service_timestamp[bank]) {
+      curr_row_service_time[bank] = m_dram->m_gpu->gpu_sim_cycle - row_service_timestamp[bank];
       if (curr_row_service_time[bank] > m_stats->max_servicetime2samerow[m_dram->id][bank])
          m_stats->max_servicetime2samerow[m_dram->id][bank] = curr_row_service_time[bank];
    }
    curr_row_service_time[bank] = 0;
-   row_service_timestamp[bank] = gpu_sim_cycle;
+   row_service_timestamp[bank] = m_dram->m_gpu->gpu_sim_cycle;
    if (m_stats->concurrent_row_access[m_dram->id][bank] > m_stats->max_conc_access2samerow[m_dram->id][bank]) {
       m_stats->max_conc_access2samerow[m_dram->id][bank] = m_stats->concurrent_row_access[m_dram->id][bank];
    }
@@ -78,6 +80,7 @@ void frfcfs_scheduler::data_collection(unsigned int bank)
 
 dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 {
+   HOST_PROFILE_SCOPE(HOST_PROF_DRAM_SCHED);
    if ( m_last_row[bank] == NULL ) {
       if ( m_queue[bank].empty() )
          return NULL;
@@ -109,7 +112,7 @@ dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 #ifdef DEBUG_FAST_IDEAL_SCHED
    if ( req )
       printf("%08u : DRAM(%u) scheduling memory request to bank=%u, row=%u\n", 
-             (unsigned)gpu_sim_cycle, m_dram->id, req->bk, req->row );
+             (unsigned)m_dram->m_gpu->gpu_sim_cycle, m_dram->id, req->bk, req->row );
 #endif
    assert( req != NULL && m_num_pending != 0 ); 
    m_num_pending--;
@@ -118,6 +121,35 @@ dram_req_t *frfcfs_scheduler::schedule( unsigned bank, unsigned curr_row )
 }
 
 
+// The queues are saved oldest first and rebuilt through add_req(), which 
+// also rebuilds the row bins: a bin lists the requests of its row in queue 
+// order. The row being served is saved by number.
+void frfcfs_scheduler::checkpoint( checkpoint_file &cp )
+{
+   cp.array(curr_row_service_time,m_config->nbk);
+   cp.array(row_service_timestamp,m_config->nbk);
+   for ( unsigned b=0; b < m_config->nbk; b++ ) {
+      assert( cp.saving() || (m_queue[b].empty() && m_last_row[b] == NULL) );
+      std::vector<dram_req_t*> queue(m_queue[b].rbegin(),m_queue[b].rend());
+      size_t n = queue.size();
+      cp.pod(n);
+      queue.resize(n);
+      for ( size_t i=0; i < n; i++ ) {
+         dram_t::checkpoint_req(cp,queue[i]);
+         if ( !cp.saving() ) 
+            add_req(queue[i]);
+      }
+      bool serving = m_last_row[b] != NULL;
+      unsigned row = serving? (*m_last_row[b]->back())->row : 0;
+      cp.pod(serving);
+      cp.pod(row);
+      if ( !cp.saving() && serving ) {
+         assert( m_bins[b].find(row) != m_bins[b].end() );
+         m_last_row[b] = &m_bins[b][row];
+      }
+   }
+}
+
 void frfcfs_scheduler::print( FILE *fp )
 {
    for ( unsigned b=0; b < m_config->nbk; b++ ) {
@@ -129,20 +161,21 @@ void dram_t::scheduler_frfcfs()
 {
    unsigned mrq_latency;
    frfcfs_scheduler *sched = m_frfcfs_scheduler;
+   memory_stats_t::dram_sched_shard &stats = m_stats->dram_shard(id);
    while ( !mrqq->empty() && (!m_config->gpgpu_frfcfs_dram_sched_queue_size || sched->num_pending() < m_config->gpgpu_frfcfs_dram_sched_queue_size)) {
       dram_req_t *req = mrqq->pop();
 
       // Power stats
       //if(req->data->get_type() != READ_REPLY && req->data->get_type() != WRITE_ACK)
-      m_stats->total_n_access++;
+      stats.n_access++;
 
       if(req->data->get_type() == WRITE_REQUEST){
-    	  m_stats->total_n_writes++;
+    	  stats.n_writes++;
       }else if(req->data->get_type() == READ_REQUEST){
-    	  m_stats->total_n_reads++;
+    	  stats.n_reads++;
       }
 
-      req->data->set_status(IN_PARTITION_MC_INPUT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+      req->data->set_status(IN_PARTITION_MC_INPUT_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
       sched->add_req(req);
    }
 
@@ -155,15 +188,15 @@ void dram_t::scheduler_frfcfs()
          req = sched->schedule(b, bk[b]->curr_row);
 
          if ( req ) {
-            req->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+            req->data->set_status(IN_PARTITION_MC_BANK_ARB_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
             prio = (prio+1)%m_config->nbk;
             bk[b]->mrq = req;
             if (m_config->gpgpu_memlatency_stat) {
-               mrq_latency = gpu_sim_cycle + gpu_tot_sim_cycle - bk[b]->mrq->timestamp;
-               bk[b]->mrq->timestamp = gpu_tot_sim_cycle + gpu_sim_cycle;
-               m_stats->mrq_lat_table[LOGB2(mrq_latency)]++;
-               if (mrq_latency > m_stats->max_mrq_latency) {
-                  m_stats->max_mrq_latency = mrq_latency;
+               mrq_latency = m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle - bk[b]->mrq->timestamp;
+               bk[b]->mrq->timestamp = m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle;
+               stats.mrq_lat_table[LOGB2(mrq_latency)]++;
+               if (mrq_latency > stats.max_mrq_latency) {
+                  stats.max_mrq_latency = mrq_latency;
                }
             }
 
@@ -42,6 +42,7 @@ public:
    void data_collection(unsigned bank);
    dram_req_t *schedule( unsigned bank, unsigned curr_row );
    void print( FILE *fp );
+   void checkpoint( class checkpoint_file &cp );
    unsigned num_pending() const { return m_num_pending;}
 
 private:
@@ -27,8 +27,13 @@
 
 #include "gpu-cache.h"
 #include "stat-tool.h"
+#include "checkpoint.h"
+#include "host_profile.h"
 #include <algorithm>
 #include <assert.h>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
 
 #define MAX_DEFAULT_CACHE_SIZE_MULTIBLIER 4
 #define USE_PREFETCH 1
@@ -126,6 +131,7 @@ tag_array::~tag_array()
 {
     delete[] m_lines;
     delete m_wle;
+    delete m_cache_prefetch;
 }
 
 tag_array::tag_array(cache_config &config,
@@ -141,6 +147,9 @@ tag_array::tag_array(cache_config &config,
 void tag_array::update_cache_parameters(cache_config &config)
 {
     m_config = config;
+    // the replacement policy picks the time stamp probe compares
+    for (unsigned i = 0; i < m_line_tag.size(); i++)
+        update_line(i);
 }
 
 tag_array::tag_array(cache_config &config,
@@ -166,12 +175,90 @@ void tag_array::init(int core_id, int type_id)
     m_core_id = core_id;
     m_type_id = type_id;
 
-    m_wle = new warp_locality_evaluation();
-    m_cache_prefetch = new cache_prefetch();
+    m_wle = NULL;
+    m_cache_prefetch = NULL;
     prefetch_hit_num = 0;
     prefetch_hit_res_num = 0;
     useless_prefetch = 0;
+    m_last_alloc_time.assign(MAX_DEFAULT_CACHE_SIZE_MULTIBLIER * m_config.get_num_lines(), 0);
+    m_last_fill_time.assign(MAX_DEFAULT_CACHE_SIZE_MULTIBLIER * m_config.get_num_lines(), 0);
+    m_tot_interval = 0;
+    m_interval_times = 0;
+    m_line_tag.resize(MAX_DEFAULT_CACHE_SIZE_MULTIBLIER * m_config.get_num_lines());
+    m_line_status.resize(m_line_tag.size());
+    m_line_stamp.resize(m_line_tag.size());
+    for (unsigned i = 0; i < m_line_tag.size(); i++)
+        update_line(i);
 }
+void tag_array::enable_locality_monitor(unsigned n_leaders, unsigned n_entries, unsigned window_size, unsigned n_warps)
+{
+    assert(m_wle == NULL);
+    m_wle = new warp_locality_evaluation(m_config.m_nset, n_leaders, n_entries, window_size, n_warps);
+}
+
+void tag_array::enable_prefetcher(unsigned n_pcs, unsigned n_ctas, unsigned n_warps, unsigned n_records)
+{
+    assert(m_cache_prefetch == NULL);
+    m_cache_prefetch = new cache_prefetch(n_pcs, n_ctas, n_warps, n_records);
+}
+
+cache_prefetch::cache_prefetch(unsigned n_pcs, unsigned n_ctas, unsigned n_warps, unsigned n_records)
+{
+    fill_counter = 0;
+    m_prefetch_req.valid = false;
+    m_prefetch_req.addr = (unsigned)-1;
+    m_prefetch_req.warp_id = (unsigned)-1;
+    m_prefetch_req.put_time = 0;
+    last_pc_index = -1;
+    last_cta_id = -1;
+    m_n_records = n_records;
+    is_positive = 0;
+
+    cta_entry c;
+    c.cta_last_warp_id = -1;
+    c.cta_last_addr = (unsigned)-1;
+    c.stride_hit = 0;
+    c.stride_miss = 0;
+    c.last_stride = 0;
+    c.active = false;
+    c.warp_offset = 0;
+    warp_entry w;
+    w.intra_warp_last_addr = (unsigned)-1;
+    w.inter_warp_last_addr = (unsigned)-1;
+    w.warp_ld_inst_num = 0;
+    w.active = false;
+    w.valid_intra_stride = false;
+    w.intra_stride = 0;
+    w.intra_stride_hit = 0;
+    w.intra_stride_miss = 0;
+    stride_buffer b;
+    b.pc = -1;
+    b.active_cta_num = 0;
+    b.active_warp_num = 0;
+    b.cta_offset = 2;
+    b.m_last_stride = 0;
+    b.valid_stride = false;
+    b.m_stride_hit = 0;
+    b.m_stride_miss = 0;
+    b.prefetch_hit = 0;
+    b.prefetch_miss = 0;
+    b.m_cta_entry.assign(n_ctas, c);
+    b.m_warp_entry.assign(n_warps, w);
+    m_stride_buffer.assign(n_pcs, b);
+}
+
+// pref_addr_record only grows up to the load instruction a prefetch was 
+// predicted for, so warps that are never prefetched for cost nothing
+void cache_prefetch::record_pref_addr(unsigned warp_id, int pref_ld_num, new_addr_type addr)
+{
+    if (pref_ld_num <= 0 || (unsigned)pref_ld_num >= m_n_records)
+        return;
+    std::vector<new_addr_type> &record = m_stride_buffer[last_pc_index].m_warp_entry[warp_id].pref_addr_record;
+    if ((unsigned)pref_ld_num >= record.size())
+        record.resize(pref_ld_num + 1, (unsigned)-1);
+    record[pref_ld_num] = addr;
+}
+
 bool cache_prefetch::warp_find(int pc_index, unsigned cta_id, unsigned warp_id){
     std::vector<int>::iterator it;
     for(it = m_stride_buffer[pc_index].m_cta_entry[cta_id].warp_set.begin(); it != m_stride_buffer[pc_index].m_cta_entry[cta_id].warp_set.end();it++){
@@ -262,9 +349,6 @@ void cache_prefetch::calculate_inter_pref_addr(int sid, int wid, int cta_id){
     //     calcu_addr(sid, wid, pref_cta_id);
     // }
 }
-int ldst_num_diff = 0;
-int stride_problem = 0;
-int calcu_addr_times = 0;
 void cache_prefetch::calcu_addr(int sid, int wid, int cta_id, int lead_wid){
     int pref_cta_id = cta_id;
     if(!m_stride_buffer[last_pc_index].m_cta_entry[pref_cta_id].active){
@@ -339,8 +423,7 @@ void cache_prefetch::calcu_addr(int sid, int wid, int cta_id, int lead_wid){
                     if(m_prefetch_req.addr != temp_addr){
                         m_prefetch_req.addr = temp_addr;
                         int pref_ld_num = m_stride_buffer[last_pc_index].m_warp_entry[lead_warp_id].warp_ld_inst_num;
-                        if(pref_ld_num < 500 && pref_ld_num > 0)
-                            m_stride_buffer[last_pc_index].m_warp_entry[*it].pref_addr_record[pref_ld_num] = m_prefetch_req.addr;
+                        record_pref_addr(*it, pref_ld_num, m_prefetch_req.addr);
                         m_prefetch_req.warp_id = *it;
                         m_prefetch_req.valid = true;
                         m_prefetch_req.put_time = 0;
@@ -372,8 +455,7 @@ void cache_prefetch::calcu_addr(int sid, int wid, int cta_id, int lead_wid){
                     if(m_prefetch_req.addr != temp_addr){
                         m_prefetch_req.addr = temp_addr;
                         int pref_ld_num = m_stride_buffer[last_pc_index].m_warp_entry[lead_warp_id].warp_ld_inst_num;
-                        if(pref_ld_num < 500 && pref_ld_num > 0)
-                            m_stride_buffer[last_pc_index].m_warp_entry[*it].pref_addr_record[pref_ld_num] = m_prefetch_req.addr;
+                        record_pref_addr(*it, pref_ld_num, m_prefetch_req.addr);
                         m_prefetch_req.warp_id = *it;
                         m_prefetch_req.valid = true;
                         m_prefetch_req.put_time = 0;
@@ -402,6 +484,7 @@ void cache_prefetch::calcu_addr(int sid, int wid, int cta_id, int lead_wid){
 
 void cache_prefetch::calculate_inter_warp_stride(int sid, unsigned cta_id, unsigned warp_id, new_addr_type warp_addr, int pc_index)
 {
+    assert(warp_id < m_stride_buffer[pc_index].m_warp_entry.size() && cta_id < m_stride_buffer[pc_index].m_cta_entry.size());
     if(!m_stride_buffer[pc_index].m_cta_entry[cta_id].active){
         m_stride_buffer[pc_index].m_cta_entry[cta_id].active = true;
         m_stride_buffer[pc_index].active_cta_num++;
@@ -410,7 +493,8 @@ void cache_prefetch::calculate_inter_warp_stride(int sid, unsigned cta_id, unsig
     // if(sid == 0)
     //     printf("ld_inst_num:%d\n", m_stride_buffer[pc_index].m_warp_entry[warp_id].warp_ld_inst_num);
     int pref_ld_num = m_stride_buffer[pc_index].m_warp_entry[warp_id].warp_ld_inst_num;
-    if(m_stride_buffer[pc_index].m_warp_entry[warp_id].pref_addr_record[pref_ld_num] != (unsigned)-1 && pref_ld_num < 500){
+    if((unsigned)pref_ld_num < m_stride_buffer[pc_index].m_warp_entry[warp_id].pref_addr_record.size() && 
+       m_stride_buffer[pc_index].m_warp_entry[warp_id].pref_addr_record[pref_ld_num] != (unsigned)-1){
         if(m_stride_buffer[pc_index].m_warp_entry[warp_id].pref_addr_record[pref_ld_num] == warp_addr)
             m_stride_buffer[pc_index].prefetch_hit++;
         else    
@@ -515,13 +599,13 @@ void cache_prefetch::calculate_intra_pref_addr(int sid, int wid, int cta_id){
 }
 void cache_prefetch::fill_entry(address_type pc)
 {
-    assert(fill_counter < 32);
+    assert(fill_counter < (int)m_stride_buffer.size());
     m_stride_buffer[fill_counter].pc = pc;
     fill_counter++;
 }
 bool cache_prefetch::full_entry()
 {
-    return (fill_counter == 32) ? true : false;
+    return (fill_counter == (int)m_stride_buffer.size()) ? true : false;
 }
 int cache_prefetch::probe_entry(address_type pc)
 {
@@ -532,79 +616,55 @@ int cache_prefetch::probe_entry(address_type pc)
     }
     return -1;
 }
-enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx) const
+unsigned long long tag_array::match_ways(unsigned set_index, new_addr_type tag) const
 {
-    //assert( m_config.m_write_policy == READ_ONLY );
-    unsigned set_index = m_config.set_index(addr);
-    new_addr_type tag = m_config.tag(addr);
+    assert(m_config.m_assoc <= 64);
+    const new_addr_type *tags = &m_line_tag[set_index * m_config.m_assoc];
+    unsigned long long match = 0;
+    unsigned way = 0;
+#if defined(__AVX2__)
+    const __m256i key = _mm256_set1_epi64x((long long)tag);
+    for (; way + 4 <= m_config.m_assoc; way += 4)
+    {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)&tags[way]), key);
+        match |= (unsigned long long)_mm256_movemask_pd(_mm256_castsi256_pd(eq)) << way;
+    }
+#elif defined(__SSE4_1__)
+    const __m128i key = _mm_set1_epi64x((long long)tag);
+    for (; way + 2 <= m_config.m_assoc; way += 2)
+    {
+        __m128i eq = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i *)&tags[way]), key);
+        match |= (unsigned long long)_mm_movemask_pd(_mm_castsi128_pd(eq)) << way;
+    }
+#endif
+    for (; way < m_config.m_assoc; way++)
+        match |= (unsigned long long)(tags[way] == tag) << way;
+    return match;
+}
 
+enum cache_request_status tag_array::find_victim(unsigned set_index, unsigned &idx) const
+{
     unsigned invalid_line = (unsigned)-1;
     unsigned valid_line = (unsigned)-1;
     unsigned valid_timestamp = (unsigned)-1;
-
     bool all_reserved = true;
-    //printf("access_num:%d\n",access_num++);/*cory*/
-    // check for hit or pending hit
+    // the last invalid line, else the first valid line with the oldest time 
+    // stamp, selected without branching on the line states
     for (unsigned way = 0; way < m_config.m_assoc; way++)
     {
-        //printf("m_config.m_assoc:%d\n",m_config.m_assoc); //m_config.m_assoc 4 8
         unsigned index = set_index * m_config.m_assoc + way;
-        cache_block_t *line = &m_lines[index];
-        if (line->m_tag == tag)
-        {
-            if (line->m_status == RESERVED)
-            {
-                idx = index;
-                return HIT_RESERVED;
-            }
-            else if (line->m_status == VALID)
-            {
-                idx = index;
-                return HIT;
-            }
-            else if (line->m_status == MODIFIED)
-            {
-                idx = index;
-                return HIT;
-            }
-            else
-            {
-                assert(line->m_status == INVALID);
-            }
-        }
-        if (line->m_status != RESERVED)
-        {
-            all_reserved = false;
-            if (line->m_status == INVALID)
-            {
-                invalid_line = index;
-            }
-            else
-            {
-                // valid line : keep track of most appropriate replacement candidate
-                if (m_config.m_replacement_policy == LRU)
-                {
-                    if (line->m_last_access_time < valid_timestamp)
-                    {
-                        valid_timestamp = line->m_last_access_time;
-                        valid_line = index;
-                    }
-                }
-                else if (m_config.m_replacement_policy == FIFO)
-                {
-                    if (line->m_alloc_time < valid_timestamp)
-                    {
-                        valid_timestamp = line->m_alloc_time;
-                        valid_line = index;
-                    }
-                }
-            }
-        }
+        unsigned char status = m_line_status[index];
+        bool invalid = status == INVALID;
+        bool older = (status == VALID || status == MODIFIED) & (m_line_stamp[index] < valid_timestamp);
+        all_reserved &= status == RESERVED;
+        invalid_line = invalid ? index : invalid_line;
+        valid_timestamp = older ? m_line_stamp[index] : valid_timestamp;
+        valid_line = older ? index : valid_line;
     }
     if (all_reserved)
     {
         assert(m_config.m_alloc_policy == ON_MISS);
-        return RESERVATION_FAIL; // miss and not enough space in cache to allocate on miss
+        return RESERVATION_FAIL;
     }
 
     if (invalid_line != (unsigned)-1)
@@ -617,7 +677,39 @@ enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx) co
     }
     else
         abort(); // if an unreserved block exists, it is either invalid or replaceable
+    return MISS;
+}
 
+enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx) const
+{
+    //assert( m_config.m_write_policy == READ_ONLY );
+    unsigned set_index = m_config.set_index(addr);
+    new_addr_type tag = m_config.tag(addr);
+
+    // check for hit or pending hit
+    unsigned long long match = match_ways(set_index, tag);
+    for (unsigned way = 0; match; way++, match >>= 1)
+    {
+        if (!(match & 1))
+            continue;
+        unsigned index = set_index * m_config.m_assoc + way;
+        if (m_line_status[index] == RESERVED)
+        {
+            idx = index;
+            return HIT_RESERVED;
+        }
+        else if (m_line_status[index] == VALID || m_line_status[index] == MODIFIED)
+        {
+            idx = index;
+            return HIT;
+        }
+        else
+        {
+            assert(m_line_status[index] == INVALID);
+        }
+    }
+    if (find_victim(set_index, idx) == RESERVATION_FAIL)
+        return RESERVATION_FAIL; // miss and not enough space in cache to allocate on miss
     assert(m_lines[idx].m_status != RESERVED);
     return MISS;
 }
@@ -626,21 +718,19 @@ enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx) co
 /*add by cory*/
 enum cache_request_status tag_array::probe_locality(new_addr_type addr, unsigned &idx, mem_fetch *mf, unsigned time)
 {
+    HOST_PROFILE_SCOPE(HOST_PROF_PROBE_LOCALITY);
+    if (!m_wle && !m_cache_prefetch)
+        return probe(addr, idx);
     unsigned set_index = m_config.set_index(addr);
     new_addr_type tag = m_config.tag(addr);
 
-    unsigned invalid_line = (unsigned)-1;
-    unsigned valid_line = (unsigned)-1;
-    unsigned valid_timestamp = (unsigned)-1;
-
-    bool all_reserved = true;
     unsigned warp_id = mf->get_wid();
-    int tag_buffer_index = m_wle->probe_entry(tag, mf, set_index);
-    int tag_buffer_num = m_wle->m_tag_entry[set_index].fill_counter;
+    int leader = m_wle ? m_wle->leader_set(set_index) : -1; // -1 if the set is not monitored
+    int tag_buffer_index = leader >= 0 ? m_wle->probe_entry(tag, mf, leader) : -1;
     int is_odd = warp_id % 2;
     int is_hit;
-    int stride_buffer_index = m_cache_prefetch->probe_entry(mf->get_pc());
-    if (USE_PREFETCH && stride_buffer_index == -1 && !m_cache_prefetch->full_entry() && mf->get_thread0_active())
+    int stride_buffer_index = m_cache_prefetch ? m_cache_prefetch->probe_entry(mf->get_pc()) : -1;
+    if (USE_PREFETCH && m_cache_prefetch && stride_buffer_index == -1 && !m_cache_prefetch->full_entry() && mf->get_thread0_active())
         m_cache_prefetch->fill_entry(mf->get_pc());
     else if (USE_PREFETCH && stride_buffer_index != -1 && mf->get_thread0_active())
     {
@@ -656,118 +746,61 @@ enum cache_request_status tag_array::probe_locality(new_addr_type addr, unsigned
     }
 
     /*cory*/
-    for (unsigned way = 0; way < m_config.m_assoc; way++)
+    unsigned long long match = match_ways(set_index, tag);
+    for (unsigned way = 0; match; way++, match >>= 1)
     {
+        if (!(match & 1))
+            continue;
         unsigned index = set_index * m_config.m_assoc + way;
-        cache_block_t *line = &m_lines[index];
-
-        if (line->m_tag == tag)
+        /*cory*/
+        is_hit = 1;
+        if (tag_buffer_index >= 0)
         {
-            /*cory*/
-            is_hit = 1;
-            if (tag_buffer_index >= 0 && tag_buffer_index < tag_buffer_num)
-            {
-                if (m_wle->window_valid(set_index, tag_buffer_index, is_odd))
-                {
-                    m_wle->evaluate_locality(warp_id, set_index, tag_buffer_index, is_odd, is_hit);
-                }
-                m_wle->update_window(warp_id, set_index, tag_buffer_index, is_odd);
-                m_wle->m_tag_entry[set_index].warp_record[tag_buffer_index].push_back(warp_id);
-            }
-            else if (tag_buffer_index == -1 && !m_wle->full_entry(set_index))
-            {
-                m_wle->fill_entry(tag, warp_id, set_index);
-                m_wle->update_window(warp_id, set_index, tag_buffer_num, is_odd);
-                m_wle->m_tag_entry[set_index].warp_record[tag_buffer_num].push_back(warp_id);
-            }
-            // else
-            //     assert(0);
-            //     printf("tag_buffer_index:%d\n",tag_buffer_index);
+            m_wle->evaluate_locality(warp_id, leader, tag_buffer_index, is_odd, is_hit);
+            m_wle->update_window(warp_id, leader, tag_buffer_index, is_odd);
+        }
+        else if (leader >= 0)
+        {
+            int filled = m_wle->fill_entry(tag, warp_id, leader);
+            m_wle->update_window(warp_id, leader, filled, is_odd);
+        }
+        // else
+        //     assert(0);
+        //     printf("tag_buffer_index:%d\n",tag_buffer_index);
+        if (m_wle)
             m_wle->cache_hit_num++;
 
-            if (line->m_status == RESERVED)
-            {
-                idx = index;
-                return HIT_RESERVED;
-            }
-            else if (line->m_status == VALID)
-            {
-                idx = index;
-                return HIT;
-            }
-            else if (line->m_status == MODIFIED)
-            {
-                idx = index;
-                return HIT;
-            }
-            else
-            {
-                assert(line->m_status == INVALID);
-            }
+        if (m_line_status[index] == RESERVED)
+        {
+            idx = index;
+            return HIT_RESERVED;
         }
-        if (line->m_status != RESERVED)
+        else if (m_line_status[index] == VALID || m_line_status[index] == MODIFIED)
         {
-            all_reserved = false;
-            if (line->m_status == INVALID)
-            {
-                invalid_line = index;
-            }
-            else
-            {
-                // valid line : keep track of most appropriate replacement candidate
-                if (m_config.m_replacement_policy == LRU)
-                {
-                    if (line->m_last_access_time < valid_timestamp)
-                    {
-                        valid_timestamp = line->m_last_access_time;
-                        valid_line = index;
-                    }
-                }
-                else if (m_config.m_replacement_policy == FIFO)
-                {
-                    if (line->m_alloc_time < valid_timestamp)
-                    {
-                        valid_timestamp = line->m_alloc_time;
-                        valid_line = index;
-                    }
-                }
-            }
+            idx = index;
+            return HIT;
+        }
+        else
+        {
+            assert(m_line_status[index] == INVALID);
         }
     }
-    if (all_reserved)
-    {
-        assert(m_config.m_alloc_policy == ON_MISS);
+    if (find_victim(set_index, idx) == RESERVATION_FAIL)
         return RESERVATION_FAIL; // miss and not enough space in cache to allocate on miss
-    }
-
-    if (invalid_line != (unsigned)-1)
-    {
-        idx = invalid_line;
-    }
-    else if (valid_line != (unsigned)-1)
-    {
-        idx = valid_line;
-    }
-    else
-        abort(); // if an unreserved block exists, it is either invalid or replaceable
 
     /*cory*/
     is_hit = 0;
-    if (tag_buffer_index >= 0 && tag_buffer_index < tag_buffer_num)
+    if (tag_buffer_index >= 0)
     {
-        if (m_wle->window_valid(set_index, tag_buffer_index, is_odd))
-        {
-            m_wle->evaluate_locality(warp_id, set_index, tag_buffer_index, is_odd, is_hit);
-        }
-        m_wle->update_window(warp_id, set_index, tag_buffer_index, is_odd);
-        m_wle->m_tag_entry[set_index].warp_record[tag_buffer_index].push_back(warp_id);
+        m_wle->evaluate_locality(warp_id, leader, tag_buffer_index, is_odd, is_hit);
+        m_wle->update_window(warp_id, leader, tag_buffer_index, is_odd);
     }
-    else if (tag_buffer_index == -1 && !m_wle->full_entry(set_index))
+    else if (leader >= 0)
     {
-        m_wle->fill_entry(tag, warp_id, set_index);
-        m_wle->m_tag_entry[set_index].warp_record[tag_buffer_num].push_back(warp_id);
+        m_wle->fill_entry(tag, warp_id, leader);
     }
-    m_wle->cache_miss_num++;
+    if (m_wle)
+        m_wle->cache_miss_num++;
     /*cory*/
     return MISS;
 }
@@ -780,9 +813,6 @@ enum cache_request_status tag_array::access(new_addr_type addr, unsigned time, u
     assert(!wb);
     return result;
 }
-unsigned last_alloc_time[512] = {0};
-float tot_interval = 0;
-float interval_times = 0;
 enum cache_request_status tag_array::access(new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted)
 {
     m_access++;
@@ -804,15 +834,16 @@ enum cache_request_status tag_array::access(new_addr_type addr, unsigned time, u
         break;
     case HIT:
         m_lines[idx].m_last_access_time = time;
+        update_line(idx);
         assert(m_lines[idx].m_status == VALID || m_lines[idx].m_status == MODIFIED);
         if(m_lines[idx].m_prefetch_line && !m_lines[idx].m_used){
             prefetch_hit_num++;
             int interval = time - m_lines[idx].m_fill_time;
             float avg_interval = 0;
             if( m_core_id == 0 ){
-                tot_interval += interval;
-                interval_times++;
-                avg_interval = tot_interval/interval_times;
+                m_tot_interval += interval;
+                m_interval_times++;
+                avg_interval = m_tot_interval/m_interval_times;
                 printf("hit_pref:%d addr:%x\n", prefetch_hit_num, addr);
             }
             if( m_core_id == 0 && m_lines[idx].m_used==false)
@@ -841,7 +872,8 @@ enum cache_request_status tag_array::access(new_addr_type addr, unsigned time, u
             //if(idx==2)
             //printf("alloc line_index:%d time:%d last_alloc_time:%d alloc_status:%d\n",idx, time, last_alloc_time[idx], m_lines[idx].m_status );
             m_lines[idx].allocate(m_config.tag(addr), m_config.block_addr(addr), time);
-            last_alloc_time[idx] = time;
+            update_line(idx);
+            m_last_alloc_time[idx] = time;
         }
 
         break;
@@ -890,7 +922,8 @@ enum cache_request_status tag_array::pref_access(new_addr_type addr, unsigned ti
             //if(idx==2)
                 //printf("pref_alloc line_index:%d time:%d last_alloc_time:%d alloc_status:%d\n",idx, time, last_alloc_time[idx], m_lines[idx].m_status );
             m_lines[idx].allocate(m_config.tag(addr), m_config.block_addr(addr), time);
-            last_alloc_time[idx] = time;
+            update_line(idx);
+            m_last_alloc_time[idx] = time;
         }
         break;
     case RESERVATION_FAIL:
@@ -915,29 +948,49 @@ void tag_array::fill(new_addr_type addr, unsigned time)
     assert(status == MISS); // MSHR should have prevented redundant memory request
     m_lines[idx].allocate(m_config.tag(addr), m_config.block_addr(addr), time);
     m_lines[idx].fill(time);
+    update_line(idx);
 }
-unsigned last_fill_time[512] = {0};
 void tag_array::pref_fill(unsigned index, unsigned time, bool is_prefetch)
 {
     assert(m_config.m_alloc_policy == ON_MISS);
     //if(index==2)
     //printf("line index:%d time:%d last_fill_time:%d fill_status:%d\n", index, time, last_fill_time[index], m_lines[index].m_status);
-    last_fill_time[index] = time;
+    m_last_fill_time[index] = time;
     m_lines[index].pref_fill(time, is_prefetch);
+    update_line(index);
 }
 void tag_array::fill(unsigned index, unsigned time)
 {
     assert(m_config.m_alloc_policy == ON_MISS);
     //if(index==2)
     //printf("line index:%d time:%d last_fill_time:%d fill_status:%d\n", index, time, last_fill_time[index], m_lines[index].m_status);
-    last_fill_time[index] = time;
+    m_last_fill_time[index] = time;
     m_lines[index].fill(time);
+    update_line(index);
+}
+
+enum cache_request_status tag_array::warm(new_addr_type addr, unsigned time, unsigned &idx, bool allocate)
+{
+    enum cache_request_status status = probe(addr, idx);
+    if (status == HIT)
+    {
+        m_lines[idx].m_last_access_time = time;
+        update_line(idx);
+    }
+    else if (status == MISS && allocate)
+    {
+        // a dirty victim is dropped: fast-forwarding does not model write-backs
+        m_lines[idx].allocate(m_config.tag(addr), m_config.block_addr(addr), time);
+        m_lines[idx].fill(time);
+        update_line(idx);
+    }
+    return status;
 }
 
 void tag_array::flush()
 {
     for (unsigned i = 0; i < m_config.get_num_lines(); i++)
-        m_lines[i].m_status = INVALID;
+        set_status(i, INVALID);
 }
 
 float tag_array::windowed_miss_rate() const
@@ -978,6 +1031,146 @@ void tag_array::get_stats(unsigned &total_access, unsigned &total_misses, unsign
     total_res_fail = m_res_fail;
 }
 
+void tag_array::checkpoint(checkpoint_file &cp)
+{
+    cp.section("tag_array");
+    cp.check_size(size(), "tag array");
+    cp.array(m_lines, size());
+    for (unsigned i = 0; i < size(); i++)
+        update_line(i);
+    cp.pod(m_access);
+    cp.pod(m_miss);
+    cp.pod(m_pending_hit);
+    cp.pod(m_res_fail);
+    cp.pod(m_prev_snapshot_access);
+    cp.pod(m_prev_snapshot_miss);
+    cp.pod(m_prev_snapshot_pending_hit);
+    cp.pod(prefetch_hit_num);
+    cp.pod(prefetch_hit_res_num);
+    cp.pod(useless_prefetch);
+    cp.pod(m_tot_interval);
+    cp.pod(m_interval_times);
+    if (m_wle)
+        m_wle->checkpoint(cp);
+    if (m_cache_prefetch)
+        m_cache_prefetch->checkpoint(cp);
+}
+
+void warp_locality_evaluation::checkpoint(checkpoint_file &cp)
+{
+    cp.section("warp_locality_evaluation");
+    cp.check_size(m_n_entries, "locality monitor entries");
+    cp.check_size(m_window_size, "locality monitor window");
+    cp.check_size(m_tag_entry.size(), "locality monitor leader sets");
+    cp.check_size(m_leader_stride, "locality monitor leader stride");
+    cp.check_size(m_n_warps, "locality monitor warps");
+    cp.pod(m_radius);
+    cp.pod(m_access_stamp);
+    for (unsigned i = 0; i < m_tag_entry.size(); i++)
+    {
+        tag_entry &e = m_tag_entry[i];
+        cp.array(&e.m_tag[0], m_n_entries);
+        cp.array(&e.m_last_use[0], m_n_entries);
+        cp.array(&e.m_warp_id_even[0], m_n_entries * m_window_size);
+        cp.array(&e.m_warp_id_odd[0], m_n_entries * m_window_size);
+        cp.array(&e.m_window_head[0], 2 * m_n_entries);
+        cp.pod(e.fill_counter);
+    }
+    cp.pod(cache_hit_num);
+    cp.pod(cache_miss_num);
+    cp.pod(tot_fill);
+    cp.pod(m_inter_warp_locality);
+    cp.pod(m_intra_warp_locality);
+    cp.pod(m_miss_intra_warp_locality);
+    cp.pod(m_miss_inter_warp_locality);
+    cp.array(m_parity_locality, 2);
+}
+
+void cache_prefetch::checkpoint(checkpoint_file &cp)
+{
+    cp.section("cache_prefetch");
+    cp.pod(m_prefetch_req);
+    cp.pod(fill_counter);
+    cp.pod(last_pc_index);
+    cp.pod(last_cta_id);
+    cp.pod(is_positive);
+    cp.check_size(m_stride_buffer.size(), "prefetcher load instructions");
+    cp.check_size(m_stride_buffer[0].m_warp_entry.size(), "prefetcher warps");
+    cp.check_size(m_stride_buffer[0].m_cta_entry.size(), "prefetcher CTAs");
+    cp.check_size(m_n_records, "prefetcher records");
+    for (unsigned i = 0; i < m_stride_buffer.size(); i++)
+    {
+        stride_buffer &b = m_stride_buffer[i];
+        cp.pod(b.pc);
+        cp.pod(b.active_cta_num);
+        cp.pod(b.active_warp_num);
+        cp.pod(b.cta_offset);
+        cp.vector(b.m_inter_warp_stride);
+        cp.pod(b.m_last_stride);
+        cp.pod(b.valid_stride);
+        cp.pod(b.prefetch_hit);
+        cp.pod(b.prefetch_miss);
+        cp.pod(b.m_stride_hit);
+        cp.pod(b.m_stride_miss);
+        for (unsigned j = 0; j < b.m_warp_entry.size(); j++)
+        {
+            warp_entry &w = b.m_warp_entry[j];
+            cp.vector(w.addr_record);
+            cp.vector(w.pref_addr_record);
+            cp.vector(w.intra_warp_stride);
+            cp.pod(w.intra_stride);
+            cp.pod(w.valid_intra_stride);
+            cp.pod(w.inter_warp_last_addr);
+            cp.pod(w.intra_warp_last_addr);
+            cp.pod(w.warp_ld_inst_num);
+            cp.pod(w.active);
+            cp.pod(w.intra_stride_hit);
+            cp.pod(w.intra_stride_miss);
+        }
+        for (unsigned j = 0; j < b.m_cta_entry.size(); j++)
+        {
+            cta_entry &c = b.m_cta_entry[j];
+            cp.pod(c.warp_offset);
+            cp.pod(c.last_stride);
+            cp.pod(c.stride_hit);
+            cp.pod(c.stride_miss);
+            cp.vector(c.warp_set);
+            cp.vector(c.inter_warp_stride);
+            cp.pod(c.cta_last_warp_id);
+            cp.pod(c.cta_last_addr);
+            cp.pod(c.active);
+        }
+    }
+    cp.vector(m_targets);
+}
+
+void cache_prefetch::target_sent(unsigned warp_id, new_addr_type block_addr)
+{
+    if (warp_id >= m_targets.size())
+    {
+        prefetch_target none;
+        none.block_addr = 0;
+        none.state = PREFETCH_TARGET_NONE;
+        m_targets.resize(warp_id + 1, none);
+    }
+    m_targets[warp_id].block_addr = block_addr;
+    m_targets[warp_id].state = PREFETCH_TARGET_IN_FLIGHT;
+}
+
+void cache_prefetch::target_filled(unsigned warp_id, new_addr_type block_addr)
+{
+    // a later prefetch for the warp replaces the target
+    if (warp_id < m_targets.size() && m_targets[warp_id].state == PREFETCH_TARGET_IN_FLIGHT && 
+        m_targets[warp_id].block_addr == block_addr)
+        m_targets[warp_id].state = PREFETCH_TARGET_FILLED;
+}
+
+void cache_prefetch::target_demand_load(unsigned warp_id)
+{
+    if (warp_id < m_targets.size())
+        m_targets[warp_id].state = PREFETCH_TARGET_NONE;
+}
+
 bool was_write_sent(const std::list<cache_event> &events)
 {
     for (std::list<cache_event>::const_iterator e = events.begin(); e != events.end(); e++)
@@ -1067,6 +1260,28 @@ mem_fetch *mshr_table::next_access()
     return result;
 }
 
+void mshr_table::checkpoint(checkpoint_file &cp)
+{
+    assert(cp.saving() || m_data.empty());
+    size_t n = m_data.size();
+    cp.pod(n);
+    table::iterator e = m_data.begin();
+    for (size_t i = 0; i < n; i++)
+    {
+        new_addr_type block_addr = cp.saving() ? e->first : 0;
+        cp.pod(block_addr);
+        mshr_entry &entry = cp.saving() ? e->second : m_data[block_addr];
+        cp.mem_fetch_refs(entry.m_list);
+        cp.pod(entry.m_has_atomic);
+        if (cp.saving())
+            ++e;
+    }
+    cp.pod(m_current_response_ready);
+    std::vector<new_addr_type> response(m_current_response.begin(), m_current_response.end());
+    cp.vector(response);
+    m_current_response.assign(response.begin(), response.end());
+}
+
 void mshr_table::display(FILE *fp) const
 {
     fprintf(fp, "MSHR contents\n");
@@ -1313,6 +1528,15 @@ void cache_stats::sample_cache_port_utility(bool data_port_busy, bool fill_port_
     }
 }
 
+void cache_stats::checkpoint(checkpoint_file &cp)
+{
+    cp.section("cache_stats");
+    cp.vector2d(m_stats);
+    cp.pod(m_cache_port_available_cycles);
+    cp.pod(m_cache_data_port_busy_cycles);
+    cp.pod(m_cache_fill_port_busy_cycles);
+}
+
 baseline_cache::bandwidth_management::bandwidth_management(cache_config &config)
     : m_config(config)
 {
@@ -1389,6 +1613,12 @@ bool baseline_cache::bandwidth_management::fill_port_free() const
     return (m_fill_port_occupied_cycles == 0);
 }
 
+void baseline_cache::bandwidth_management::checkpoint(checkpoint_file &cp)
+{
+    cp.pod(m_data_port_occupied_cycles);
+    cp.pod(m_fill_port_occupied_cycles);
+}
+
 /// Sends next request to lower level of memory
 void baseline_cache::cycle()
 {
@@ -1450,13 +1680,14 @@ void baseline_cache::fill(mem_fetch *mf, unsigned time)
         m_tag_array->fill(e->second.m_block_addr, time);
     else
         abort();
+    if (mf->get_is_prefetch() && m_tag_array->m_cache_prefetch)
+        m_tag_array->m_cache_prefetch->target_filled(mf->get_wid(), e->second.m_block_addr);
     bool has_atomic = false;
     m_mshrs.mark_ready(e->second.m_block_addr, has_atomic);
     if (has_atomic)
     {
         assert(m_config.m_alloc_policy == ON_MISS);
-        cache_block_t &block = m_tag_array->get_block(e->second.m_cache_index);
-        block.m_status = MODIFIED; // mark line as dirty for atomic operation
+        m_tag_array->set_status(e->second.m_cache_index, MODIFIED); // mark line as dirty for atomic operation
     }
     m_extra_mf_fields.erase(mf);
     m_bandwidth_management.use_fill_port(mf);
@@ -1482,6 +1713,19 @@ void baseline_cache::display_state(FILE *fp) const
     fprintf(fp, "\n");
 }
 
+void baseline_cache::checkpoint(checkpoint_file &cp)
+{
+    cp.section(m_name.c_str());
+    m_tag_array->checkpoint(cp);
+    m_stats.checkpoint(cp);
+    // outstanding misses, only a mid-kernel checkpoint has any
+    m_mshrs.checkpoint(cp);
+    cp.mem_fetch_refs(m_miss_queue);
+    cp.mem_fetch_refs(m_pref_miss_queue);
+    cp.mem_fetch_map(m_extra_mf_fields);
+    m_bandwidth_management.checkpoint(cp);
+}
+
 /// Read miss handler without writeback
 void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_addr, unsigned cache_index, mem_fetch *mf,
                                        unsigned time, bool &do_miss, std::list<cache_event> &events, bool read_only, bool wa)
@@ -1530,11 +1774,6 @@ void baseline_cache::send_read_request(new_addr_type addr, new_addr_type block_a
         do_miss = true;
     }
 }
-int delete_pref = 0;
-int actual_push_time = 0;
-int mshr_full = 0;
-int mshr_hit = 0;
-int cache_hit = 0;
 void baseline_cache::send_read_request_pref(new_addr_type pref_addr, new_addr_type pref_block_addr, unsigned pref_cache_index, mem_fetch *pref_mf,
                                            unsigned time, bool &pref_do_miss, bool &pref_wb, cache_block_t &pref_evicted, std::list<cache_event> &events, bool read_only, bool wa)
 {
@@ -1559,7 +1798,7 @@ void baseline_cache::send_read_request_pref(new_addr_type pref_addr, new_addr_ty
             // if(pref_block_addr == 0x80059200)
             //     printf("pref_block_addr:%x cache_index:%d\n", pref_block_addr, pref_cache_index);
             if(pref_mf->get_sid() == 0)
-              printf("actual_push_addr:%x times:%d time:%d\n", pref_block_addr, actual_push_time++, time);
+              printf("actual_push_addr:%x times:%d time:%d\n", pref_block_addr, m_actual_push_time++, time);
             m_extra_mf_fields[pref_mf] = extra_mf_fields(pref_block_addr, pref_cache_index, pref_mf->get_data_size());
             pref_mf->set_data_size(m_config.get_line_sz());
             //printf("push into pref_miss_queue\n");
@@ -1680,8 +1919,7 @@ cache_request_status data_cache::wr_hit_wb(new_addr_type addr, unsigned cache_in
 {
     new_addr_type block_addr = m_config.block_addr(addr);
     m_tag_array->access(block_addr, time, cache_index); // update LRU state
-    cache_block_t &block = m_tag_array->get_block(cache_index);
-    block.m_status = MODIFIED;
+    m_tag_array->set_status(cache_index, MODIFIED);
 
     return HIT;
 }
@@ -1694,8 +1932,7 @@ cache_request_status data_cache::wr_hit_wt(new_addr_type addr, unsigned cache_in
 
     new_addr_type block_addr = m_config.block_addr(addr);
     m_tag_array->access(block_addr, time, cache_index); // update LRU state
-    cache_block_t &block = m_tag_array->get_block(cache_index);
-    block.m_status = MODIFIED;
+    m_tag_array->set_status(cache_index, MODIFIED);
 
     // generate a write-through
     send_write_request(mf, WRITE_REQUEST_SENT, time, events);
@@ -1710,11 +1947,10 @@ cache_request_status data_cache::wr_hit_we(new_addr_type addr, unsigned cache_in
         return RESERVATION_FAIL; // cannot handle request this cycle
 
     // generate a write-through/evict
-    cache_block_t &block = m_tag_array->get_block(cache_index);
     send_write_request(mf, WRITE_REQUEST_SENT, time, events);
 
     // Invalidate block
-    block.m_status = INVALID;
+    m_tag_array->set_status(cache_index, INVALID);
 
     return HIT;
 }
@@ -1766,7 +2002,8 @@ data_cache::wr_miss_wa(new_addr_type addr,
                                     mf->get_wid(),
                                     mf->get_sid(),
                                     mf->get_tpc(),
-                                    mf->get_mem_config());
+                                    mf->get_mem_config(),
+                                    mf->get_gpu());
 
     bool do_miss = false;
     bool wb = false;
@@ -1830,8 +2067,7 @@ data_cache::rd_hit_base(new_addr_type addr,
     if (mf->isatomic())
     {
         assert(mf->get_access_type() == GLOBAL_ACC_R);
-        cache_block_t &block = m_tag_array->get_block(cache_index);
-        block.m_status = MODIFIED; // mark line as dirty
+        m_tag_array->set_status(cache_index, MODIFIED); // mark line as dirty
     }
     return HIT;
 }
@@ -2031,7 +2267,6 @@ data_cache::process_tag_probe(bool wr,
 // of caching policies.
 // Both the L1 and L2 override this function to provide a means of
 // performing actions specific to each cache when such actions are implemnted.
-int actual_pref_times = 0;
 enum cache_request_status
 data_cache::access(new_addr_type addr,
                    mem_fetch *mf,
@@ -2060,9 +2295,11 @@ data_cache::access(new_addr_type addr,
         probe_status = m_tag_array->probe(block_addr, cache_index);
     }
     enum cache_request_status access_status = process_tag_probe(wr, probe_status, addr, cache_index, mf, time, events, is_l1_cache);
+    if ((mf->get_access_type() == GLOBAL_ACC_R || mf->get_access_type() == LOCAL_ACC_R) && is_l1_cache && m_tag_array->m_cache_prefetch)
+        m_tag_array->m_cache_prefetch->target_demand_load(mf->get_wid());
 
     //if(is_l1_cache && (mf->get_access_type() == GLOBAL_ACC_R || mf->get_access_type() == LOCAL_ACC_R)){
-    if(USE_PREFETCH && is_l1_cache && (mf->get_access_type() == GLOBAL_ACC_R || mf->get_access_type() == LOCAL_ACC_R ) ){
+    if(USE_PREFETCH && is_l1_cache && m_tag_array->m_cache_prefetch && (mf->get_access_type() == GLOBAL_ACC_R || mf->get_access_type() == LOCAL_ACC_R ) ){
         if(scheduler_policy_gto == 0)
             m_tag_array->m_cache_prefetch->calculate_inter_pref_addr(mf->get_sid(), mf->get_wid(), mf->get_ctaid());
         else
@@ -2074,7 +2311,7 @@ data_cache::access(new_addr_type addr,
     }
     //if(USE_PREFETCH && pref_mf != NULL && is_l1_cache){
     if(USE_PREFETCH && pref_mf != NULL && is_l1_cache){
-        assert(pref_mf != NULL);
+        assert(pref_mf != NULL && m_tag_array->m_cache_prefetch);
         bool pref_do_miss = false;
         bool pref_wb = false;
         cache_block_t pref_evicted;
@@ -2098,6 +2335,7 @@ data_cache::access(new_addr_type addr,
                         pref_do_miss, pref_wb, pref_evicted, events, false, false);
             if(pref_do_miss)
             {
+                m_tag_array->m_cache_prefetch->target_sent(m_tag_array->get_prefetch_warp_id(), pref_block_addr);
                 if (pref_wb && (m_config.m_write_policy != WRITE_THROUGH))
                 {
                     mem_fetch *pref_wb = m_memfetch_creator->alloc(pref_evicted.m_block_addr,
@@ -2122,6 +2360,41 @@ data_cache::access(new_addr_type addr,
     return access_status;
 }
 
+bool data_cache::warm(mem_fetch *mf, unsigned time, bool is_l1_cache)
+{
+    bool wr = mf->get_is_write();
+    new_addr_type block_addr = m_config.block_addr(mf->get_addr());
+    unsigned cache_index = (unsigned)-1;
+    if ((mf->get_access_type() == GLOBAL_ACC_R || mf->get_access_type() == LOCAL_ACC_R) && is_l1_cache)
+        m_tag_array->probe_locality(block_addr, cache_index, mf, time); // trains the locality monitor and prefetcher
+    bool allocate = !wr || m_config.m_write_alloc_policy == WRITE_ALLOCATE;
+    enum cache_request_status status = m_tag_array->warm(block_addr, time, cache_index, allocate);
+    if (!wr)
+        return status != HIT;
+    if (status != HIT)
+        return true;
+    switch (m_config.m_write_policy)
+    {
+    case WRITE_BACK:
+        m_tag_array->set_status(cache_index, MODIFIED);
+        return false;
+    case WRITE_EVICT:
+        m_tag_array->set_status(cache_index, INVALID);
+        return true;
+    case LOCAL_WB_GLOBAL_WT:
+        if (mf->get_access_type() == GLOBAL_ACC_W)
+        {
+            m_tag_array->set_status(cache_index, INVALID);
+            return true;
+        }
+        m_tag_array->set_status(cache_index, MODIFIED);
+        return false;
+    default:
+        m_tag_array->set_status(cache_index, MODIFIED);
+        return true;
+    }
+}
+
 /// This is meant to model the first level data cache in Fermi.
 /// It is write-evict (global) or write-back (local) at the
 /// granularity of individual blocks (Set by GPGPU-Sim configuration file)
@@ -2135,7 +2408,126 @@ l1_cache::access(new_addr_type addr,
                  std::list<cache_event> &events)
 {
     //printf("access_num:%d addr:%X time:%d \n",access_num++,addr,time);/*cory*/
-    return data_cache::access(addr, mf, pref_mf, time, events, 1);
+    if (!m_victim_tags || (mf->get_access_type() != GLOBAL_ACC_R && mf->get_access_type() != LOCAL_ACC_R))
+        return data_cache::access(addr, mf, pref_mf, time, events, 1);
+
+    // find the line a miss replaces before the access allocates it
+    new_addr_type tag = m_config.tag(addr);
+    unsigned idx = (unsigned)-1;
+    enum cache_request_status probe_status = m_tag_array->probe(m_config.block_addr(addr), idx);
+    cache_block_t victim;
+    if (probe_status == MISS)
+        victim = m_tag_array->get_block(idx);
+
+    enum cache_request_status status = data_cache::access(addr, mf, pref_mf, time, events, 1);
+    if (status == MISS && probe_status == MISS)
+    {
+        unsigned warp_id = mf->get_wid();
+        m_victim_tags->miss(warp_id, tag, time);
+        const cache_block_t &line = m_tag_array->get_block(idx);
+        if (line.m_tag == tag && line.m_status == RESERVED && line.m_alloc_time == time)
+        {
+            // the owner is only known if a demand load allocated the victim
+            if ((victim.m_status == VALID || victim.m_status == MODIFIED) && m_line_owner[idx].first == victim.m_tag)
+                m_victim_tags->evicted(m_line_owner[idx].second, victim.m_tag);
+            m_line_owner[idx] = std::make_pair(tag, warp_id);
+        }
+    }
+    return status;
+}
+
+victim_tag_array *l1_cache::enable_victim_tags(unsigned n_warps, unsigned entries_per_warp,
+                                               unsigned base_score, unsigned k_throttle)
+{
+    if (m_victim_tags)
+    {
+        assert(m_victim_tags->same_config(n_warps, entries_per_warp, base_score, k_throttle));
+        return m_victim_tags;
+    }
+    m_victim_tags = new victim_tag_array(n_warps, entries_per_warp, base_score, k_throttle);
+    m_line_owner.assign(m_config.get_num_lines(), std::make_pair((new_addr_type)-1, (unsigned)-1));
+    return m_victim_tags;
+}
+
+void l1_cache::checkpoint(checkpoint_file &cp)
+{
+    data_cache::checkpoint(cp);
+    if (m_victim_tags)
+    {
+        m_victim_tags->checkpoint(cp);
+        cp.vector(m_line_owner);
+    }
+}
+
+victim_tag_array::victim_tag_array(unsigned n_warps, unsigned entries_per_warp, unsigned base_score, unsigned k_throttle)
+{
+    assert(entries_per_warp > 0);
+    m_n_warps = n_warps;
+    m_entries = entries_per_warp;
+    m_base_score = base_score;
+    m_k_throttle = k_throttle;
+    m_tags.resize(n_warps * entries_per_warp, 0);
+    m_valid.resize(n_warps * entries_per_warp, false);
+    m_next.resize(n_warps, 0);
+    m_score.resize(n_warps, 0);
+    m_score_time.resize(n_warps, 0);
+    m_hits = 0;
+}
+
+bool victim_tag_array::same_config(unsigned n_warps, unsigned entries_per_warp, unsigned base_score, unsigned k_throttle) const
+{
+    return m_n_warps == n_warps && m_entries == entries_per_warp && 
+           m_base_score == base_score && m_k_throttle == k_throttle;
+}
+
+void victim_tag_array::evicted(unsigned warp_id, new_addr_type tag)
+{
+    assert(warp_id < m_n_warps);
+    unsigned entry = warp_id * m_entries + m_next[warp_id];
+    m_tags[entry] = tag;
+    m_valid[entry] = true;
+    m_next[warp_id] = (m_next[warp_id] + 1) % m_entries;
+}
+
+bool victim_tag_array::miss(unsigned warp_id, new_addr_type tag, unsigned time)
+{
+    assert(warp_id < m_n_warps);
+    for (unsigned e = warp_id * m_entries; e < (warp_id + 1) * m_entries; e++)
+    {
+        if (m_valid[e] && m_tags[e] == tag)
+        {
+            // the line is back in the cache, so it can be lost again
+            m_valid[e] = false;
+            m_score[warp_id] = score(warp_id, time) - m_base_score + m_k_throttle;
+            m_score_time[warp_id] = time;
+            m_hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned victim_tag_array::score(unsigned warp_id, unsigned time) const
+{
+    unsigned elapsed = time - m_score_time[warp_id];
+    return m_base_score + (m_score[warp_id] > elapsed ? m_score[warp_id] - elapsed : 0);
+}
+
+void victim_tag_array::checkpoint(checkpoint_file &cp)
+{
+    cp.section("victim_tag_array");
+    cp.check_size(m_n_warps * m_entries, "victim tag array entries");
+    cp.vector(m_tags);
+    for (unsigned e = 0; e < m_valid.size(); e++)
+    {
+        bool valid = m_valid[e];
+        cp.pod(valid);
+        m_valid[e] = valid;
+    }
+    cp.vector(m_next);
+    cp.vector(m_score);
+    cp.vector(m_score_time);
+    cp.pod(m_hits);
 }
 
 // The l2 cache access function calls the base data_cache access
@@ -2259,6 +2651,41 @@ void tex_cache::fill(mem_fetch *mf, unsigned time)
     assert(r.m_block_addr == m_config.block_addr(mf->get_addr()));
 }
 
+void tex_cache::checkpoint(checkpoint_file &cp)
+{
+    cp.section(m_name.c_str());
+    m_tags.checkpoint(cp);
+    cp.array(m_cache, m_config.get_num_lines());
+    m_stats.checkpoint(cp);
+    // fetches in flight, only a mid-kernel checkpoint has any
+    m_fragment_fifo.checkpoint_indices(cp);
+    for (unsigned n = 0; n < m_fragment_fifo.size(); n++)
+    {
+        fragment_entry &f = m_fragment_fifo.peek(m_fragment_fifo.index(n));
+        cp.mem_fetch_ref(f.m_request);
+        cp.pod(f.m_cache_index);
+        cp.pod(f.m_miss);
+        cp.pod(f.m_data_size);
+    }
+    m_request_fifo.checkpoint_indices(cp);
+    for (unsigned n = 0; n < m_request_fifo.size(); n++)
+        cp.mem_fetch_ref(m_request_fifo.peek(m_request_fifo.index(n)));
+    m_rob.checkpoint_indices(cp);
+    for (unsigned n = 0; n < m_rob.size(); n++)
+    {
+        rob_entry &r = m_rob.peek(m_rob.index(n));
+        cp.pod(r.m_ready);
+        cp.pod(r.m_time);
+        cp.pod(r.m_index);
+        cp.mem_fetch_ref(r.m_request);
+        cp.pod(r.m_block_addr);
+    }
+    m_result_fifo.checkpoint_indices(cp);
+    for (unsigned n = 0; n < m_result_fifo.size(); n++)
+        cp.mem_fetch_ref(m_result_fifo.peek(m_result_fifo.index(n)));
+    cp.mem_fetch_map(m_extra_mf_fields);
+}
+
 void tex_cache::display_state(FILE *fp) const
 {
     fprintf(fp, "%s (texture cache) state:\n", m_name.c_str());
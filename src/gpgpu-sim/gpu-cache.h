@@ -28,13 +28,10 @@
 #ifndef GPU_CACHE_H
 #define GPU_CACHE_H
 
-#define TAG_BUFFER_ENTRY_SIZE 64
-#define TAG_BUFFER_WINDOW_SIZE 4
-#define SET_SIZE 64
-
-
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
 #include "gpu-misc.h"
 #include "mem_fetch.h"
 #include "../abstract_hardware_model.h"
@@ -42,6 +39,8 @@
 
 #include "addrdec.h"
 
+class checkpoint_file;
+
 enum cache_block_state {
     INVALID,
     RESERVED,
@@ -249,6 +248,16 @@ public:
         assert( m_valid );
         return m_nset * m_assoc;
     }
+    unsigned get_nset() const
+    {
+        assert( m_valid );
+        return m_nset;
+    }
+    unsigned get_assoc() const
+    {
+        assert( m_valid );
+        return m_assoc;
+    }
 
     void print( FILE *fp ) const
     {
@@ -352,184 +361,189 @@ private:
 	linear_to_raw_address_translation *m_address_mapping;
 };
 
+// Locality classification counts of warp_locality_evaluation
+struct warp_locality_counts {
+    warp_locality_counts() { clear(); }
+    void clear() { intra=0; inter=0; miss_intra=0; miss_inter=0; }
+    unsigned long long intra;
+    unsigned long long inter;
+    unsigned long long miss_intra;
+    unsigned long long miss_inter;
+};
+
+// Samples <n_leaders> sets of the cache, spread evenly over its sets, and
+// for the <n_entries> most recently used tags of each tracks the warp ids of
+// the last <window_size> accesses to the tag, separately for even and odd 
+// warps, to classify each access as intra- or inter-warp locality. Tags are 
+// replaced LRU and windows are ring buffers, so the monitor keeps following
+// the working set of each kernel phase in constant memory. Only allocated for
+// the caches that train it (see tag_array::enable_locality_monitor).
 class warp_locality_evaluation {
 public:
-    warp_locality_evaluation(){
+    // n_leaders of 0 or above n_sets samples every set
+    warp_locality_evaluation( unsigned n_sets, unsigned n_leaders, unsigned n_entries, unsigned window_size, unsigned n_warps ){
+        if(n_leaders == 0 || n_leaders > n_sets)
+            n_leaders = n_sets;
+        m_n_warps = n_warps;
+        m_radius = 1;
+        m_leader_stride = n_sets / n_leaders;
+        m_n_entries=n_entries;
+        m_window_size=window_size;
         m_inter_warp_locality=0;
         m_intra_warp_locality=0;
         m_miss_inter_warp_locality=0;
         m_miss_intra_warp_locality=0;
+        m_parity_locality[0].clear();
+        m_parity_locality[1].clear();
         tot_fill=0;
         cache_hit_num=0;
         cache_miss_num=0;
-        for(int i=0;i<SET_SIZE;i++){
-            m_tag_entry[i].fill_counter=0;
-            for(int j=0;j<TAG_BUFFER_ENTRY_SIZE;j++){
-                for(int k=0;k<TAG_BUFFER_WINDOW_SIZE;k++){
-                    m_tag_entry[i].m_tag[j]=-1;
-                    m_tag_entry[i].m_warp_id_even[j][k]=-1;
-                    m_tag_entry[i].m_warp_id_odd[j][k]=-1;
-                }
-            }
-            m_tag_entry[i].warp_record.resize(64);
-        }
+        m_access_stamp=0;
+        tag_entry e;
+        e.m_tag.assign(m_n_entries, -1);
+        e.m_last_use.assign(m_n_entries, 0);
+        e.m_warp_id_even.assign(m_n_entries*m_window_size, -1);
+        e.m_warp_id_odd.assign(m_n_entries*m_window_size, -1);
+        e.m_window_head.assign(2*m_n_entries, 0);
+        e.fill_counter=0;
+        m_tag_entry.assign(n_leaders, e);
+    }
+    // the monitored set a cache set maps to, -1 if it is not sampled (sets 
+    // added by a cache reconfiguration never are)
+    int leader_set(unsigned set_index) const{
+        if(set_index % m_leader_stride)
+            return -1;
+        unsigned leader = set_index / m_leader_stride;
+        return leader < m_tag_entry.size() ? (int)leader : -1;
     }
     void flush_tag_array_inter_warp_locality(){
         m_inter_warp_locality=0;
         m_intra_warp_locality=0;
         m_miss_inter_warp_locality=0;
         m_miss_intra_warp_locality=0;
+        m_parity_locality[0].clear();
+        m_parity_locality[1].clear();
     }
-    void fill_entry(new_addr_type tag, int warp_id, unsigned set_index){
-        assert(m_tag_entry[set_index].fill_counter < TAG_BUFFER_ENTRY_SIZE);
-        int index = m_tag_entry[set_index].fill_counter;
-        m_tag_entry[set_index].m_tag[index] = tag;
-        if(warp_id%2==0)
-            m_tag_entry[set_index].m_warp_id_even[index][0] = warp_id;
-        else
-            m_tag_entry[set_index].m_warp_id_odd[index][0] = warp_id;
-        m_tag_entry[set_index].fill_counter++;
+    void checkpoint( checkpoint_file &cp );
+    // records tag in a free or the least recently used entry of the leader 
+    // set, and returns the entry
+    int fill_entry(new_addr_type tag, int warp_id, unsigned leader){
+        tag_entry &e = m_tag_entry[leader];
+        int index = e.fill_counter;
+        if(e.fill_counter < (int)m_n_entries){
+            e.fill_counter++;
+        }
+        else{
+            index = 0;
+            for(unsigned i=1;i<m_n_entries;i++){
+                if(e.m_last_use[i] < e.m_last_use[index])
+                    index = i;
+            }
+            std::fill(e.m_warp_id_even.begin()+index*m_window_size, e.m_warp_id_even.begin()+(index+1)*m_window_size, -1);
+            std::fill(e.m_warp_id_odd.begin()+index*m_window_size, e.m_warp_id_odd.begin()+(index+1)*m_window_size, -1);
+            e.m_window_head[2*index] = 0;
+            e.m_window_head[2*index+1] = 0;
+        }
+        e.m_tag[index] = tag;
+        e.m_last_use[index] = ++m_access_stamp;
+        update_window(warp_id, leader, index, warp_id%2);
         tot_fill++;
+        return index;
     }
-
-    bool full_entry(int set_index){
-        return (m_tag_entry[set_index].fill_counter == TAG_BUFFER_ENTRY_SIZE) ? true:false;
-    }
-    int probe_entry(new_addr_type tag, mem_fetch *mf, unsigned set_index){
-        for(int i=0;i<m_tag_entry[set_index].fill_counter;i++){
-            if(m_tag_entry[set_index].m_tag[i] == tag){
+    int probe_entry(new_addr_type tag, mem_fetch *mf, unsigned leader){
+        tag_entry &e = m_tag_entry[leader];
+        for(int i=0;i<e.fill_counter;i++){
+            if(e.m_tag[i] == tag){
+                e.m_last_use[i] = ++m_access_stamp;
                 return i;
             }
         }
         return -1;
     }
-    void evaluate_locality(int warp_id, int set_index, int tag_buffer_index, bool is_odd, bool is_hit){
-        int temp_inter=0;
-        int temp_intra=0;
-        if(is_odd){
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(warp_id == m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i]){
-                    temp_intra++;
-                }
-                //else{
-                 else if(abs(warp_id - m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i]) <= 4 ||
-                 abs(warp_id - m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i]) >= 46){
-                    temp_inter++;
-                }
-            }
-            if(temp_intra > temp_inter)
-                if(is_hit)
-                    m_intra_warp_locality++;
-                else
-                    m_miss_intra_warp_locality++;
-            else if(temp_intra < temp_inter)
-                if(is_hit)
-                    m_inter_warp_locality++;
-                else    
-                    m_miss_inter_warp_locality++;
+    // warps of the running kernel closer than half a CTA are neighbours
+    void set_warps_per_cta(unsigned warps_per_cta){
+        m_radius = std::max(1, (int)warps_per_cta / 2);
+    }
+    // classifies the access by the warps in the window of its tag; an empty 
+    // window counts as neither
+    void evaluate_locality(int warp_id, int leader, int tag_buffer_index, bool is_odd, bool is_hit){
+        int intra=0;
+        int inter=0;
+        const int *w = window(leader, tag_buffer_index, is_odd);
+        switch(m_window_size){
+        case 4: count_window<4>(w, warp_id, intra, inter); break;
+        case 8: count_window<8>(w, warp_id, intra, inter); break;
+        case 16: count_window<16>(w, warp_id, intra, inter); break;
+        default: count_window<0>(w, warp_id, intra, inter); break;
         }
-        else{
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(warp_id == m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i]){
-                    temp_intra++;
-                }
-                //else{
-                 else if(abs(warp_id - m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i]) <= 4 ||
-                 abs(warp_id - m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i]) >= 46){
-                    temp_inter++;
-                }
-            }
-            if(temp_intra > temp_inter)
-                if(is_hit)
-                    m_intra_warp_locality++;
-                else
-                    m_miss_intra_warp_locality++;
-            else if(temp_intra < temp_inter)
-                if(is_hit)
-                    m_inter_warp_locality++;
-                else    
-                    m_miss_inter_warp_locality++;
+        if(intra != inter)
+            count_locality(is_odd, intra > inter, is_hit);
+    }
+    // one branch-free pass over the window, unrolled and vectorized for a 
+    // window of W warps (0: any window size): the same warp is intra-warp
+    // locality, a warp within m_radius (wrapping around the warps of the 
+    // core) inter-warp, empty slots (-1) neither
+    template<unsigned W>
+    void count_window(const int *w, int warp_id, int &intra, int &inter) const{
+        const unsigned n = W ? W : m_window_size;
+        const int wrap = m_n_warps - m_radius;
+        for(unsigned i=0;i<n;i++){
+            int d = abs(warp_id - w[i]);
+            intra += d == 0;
+            inter += (w[i] >= 0) & (d != 0) & ((d <= m_radius) | (d >= wrap));
         }
     }
-    void update_window(int warp_id, int set_index, int tag_buffer_index, bool is_odd){
-        if(is_odd){
-            if(window_full(set_index, tag_buffer_index, is_odd)){
-                for(int i=0;i<TAG_BUFFER_WINDOW_SIZE-1;i++){
-                    m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i] = m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i+1];
-                }
-                m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][TAG_BUFFER_WINDOW_SIZE-1] = warp_id;
+    void count_locality(bool is_odd, bool intra, bool is_hit){
+        warp_locality_counts &parity = m_parity_locality[is_odd?1:0];
+        if(intra){
+            if(is_hit){
+                m_intra_warp_locality++;
+                parity.intra++;
             }
-            else {
-                for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                    if(m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i] == -1){
-                        m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i] = warp_id;
-                        break;
-                    }
-                }
+            else{
+                m_miss_intra_warp_locality++;
+                parity.miss_intra++;
             }
         }
         else{
-            if(window_full(set_index, tag_buffer_index, is_odd)){
-                for(int i=0;i<TAG_BUFFER_WINDOW_SIZE-1;i++){
-                    m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i] = m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i+1];
-                }
-                m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][TAG_BUFFER_WINDOW_SIZE-1] = warp_id;
+            if(is_hit){
+                m_inter_warp_locality++;
+                parity.inter++;
             }
-            else {
-                for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                    if(m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i] == -1){
-                        m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i] = warp_id;
-                        break;
-                    }
-                }
+            else{
+                m_miss_inter_warp_locality++;
+                parity.miss_inter++;
             }
         }
-        return ;
     }
-    bool window_valid(int set_index, int tag_buffer_index, bool is_odd){
-        if(is_odd){
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i] != -1)
-                    return true;
-            }
-            return false;
-        }
-        else{
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i] != -1)
-                    return true;
-            }
-            return false;
-        }
-    }
-    bool window_full(int set_index, int tag_buffer_index, bool is_odd){
-        if(is_odd){
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(m_tag_entry[set_index].m_warp_id_odd[tag_buffer_index][i] == -1)
-                    return false;
-            }
-            return true;
-        }
-        else{
-            for(int i=0;i<TAG_BUFFER_WINDOW_SIZE;i++){
-                if(m_tag_entry[set_index].m_warp_id_even[tag_buffer_index][i] == -1)
-                    return false;
-            }
-            return true;
-        }
+    // the window keeps the last window_size warp ids, oldest overwritten first
+    void update_window(int warp_id, int leader, int tag_buffer_index, bool is_odd){
+        unsigned &head = m_tag_entry[leader].m_window_head[2*tag_buffer_index + (is_odd?1:0)];
+        window(leader, tag_buffer_index, is_odd)[head] = warp_id;
+        head = (head + 1) % m_window_size;
     }
 //protected:
     struct tag_entry
     {
-        new_addr_type m_tag[TAG_BUFFER_ENTRY_SIZE];
-        int m_warp_id_even[TAG_BUFFER_ENTRY_SIZE][TAG_BUFFER_WINDOW_SIZE];
-        int m_warp_id_odd[TAG_BUFFER_ENTRY_SIZE][TAG_BUFFER_WINDOW_SIZE];
-        int times;
-        int set_index;
+        std::vector<new_addr_type> m_tag;           // n_entries
+        std::vector<unsigned long long> m_last_use; // access stamp of each entry
+        std::vector<int> m_warp_id_even;            // n_entries windows of window_size warp ids
+        std::vector<int> m_warp_id_odd;
+        std::vector<unsigned> m_window_head;        // next slot to write, even and odd window of each entry
         int fill_counter;
-        std::vector<std::vector<int>> warp_record;
     };
-    tag_entry m_tag_entry[SET_SIZE]; // set nums: 32
+    // the warp ids window of a tag entry
+    int *window(int leader, int tag_buffer_index, bool is_odd){
+        tag_entry &e = m_tag_entry[leader];
+        return &(is_odd ? e.m_warp_id_odd : e.m_warp_id_even)[tag_buffer_index*m_window_size];
+    }
+    unsigned m_leader_stride;
+    unsigned m_n_entries;
+    unsigned m_window_size;
+    int m_n_warps;  // warps per core, the inter-warp distance wraps around
+    int m_radius;   // inter-warp distance of neighbouring warps
+    unsigned long long m_access_stamp;
+    std::vector<tag_entry> m_tag_entry; // by leader set
     int cache_hit_num;
     int cache_miss_num;
     int tot_fill;
@@ -537,59 +551,39 @@ public:
     int m_intra_warp_locality;
     int m_miss_intra_warp_locality;
     int m_miss_inter_warp_locality;
+    // the counts above split by warp id parity, as the tag windows are
+    warp_locality_counts m_parity_locality[2];
+};
+
+// state of the prefetch issued on behalf of a (trailing) warp
+enum prefetch_target_state {
+    PREFETCH_TARGET_NONE = 0,
+    PREFETCH_TARGET_IN_FLIGHT,
+    PREFETCH_TARGET_FILLED
 };
 
+// Stride prefetcher trained on the warp loads of up to <n_pcs> load 
+// instructions, for <n_ctas> CTAs and <n_warps> warps of a core, predicting
+// the addresses of trailing warps. Only allocated for the caches that issue
+// prefetches (see tag_array::enable_prefetcher).
 class cache_prefetch{
 public:
-    cache_prefetch(){
-        fill_counter = 0;
-        m_prefetch_req.valid = false;
-        m_prefetch_req.addr = (unsigned)-1;
-        m_prefetch_req.warp_id = (unsigned)-1;
-        m_prefetch_req.put_time = 0;
-        last_pc_index = -1;
-        last_cta_id = -1;
-        for(int i=0;i<32;i++){
-            m_stride_buffer[i].pc = -1;
-            m_stride_buffer[i].active_cta_num = 0;
-            m_stride_buffer[i].active_warp_num = 0;
-            m_stride_buffer[i].cta_offset = 2;
-            m_stride_buffer[i].m_last_stride = 0;
-            m_stride_buffer[i].valid_stride = false;
-            m_stride_buffer[i].m_stride_hit = 0;
-            m_stride_buffer[i].m_stride_miss = 0;
-            for(int j=0;j<8;j++){
-                m_stride_buffer[i].m_cta_entry[j].cta_last_warp_id = -1;
-                m_stride_buffer[i].m_cta_entry[j].cta_last_addr = (unsigned)-1;
-                m_stride_buffer[i].m_cta_entry[j].stride_hit = 0;
-                m_stride_buffer[i].m_cta_entry[j].stride_miss = 0;
-                m_stride_buffer[i].m_cta_entry[j].last_stride = 0;
-                m_stride_buffer[i].m_cta_entry[j].active = false;
-                m_stride_buffer[i].m_cta_entry[j].warp_offset = 0;
-            }
-            for(int j=0;j<48;j++){
-                m_stride_buffer[i].m_warp_entry[j].intra_warp_last_addr = (unsigned)-1;
-                m_stride_buffer[i].m_warp_entry[j].inter_warp_last_addr = (unsigned)-1;
-                m_stride_buffer[i].m_warp_entry[j].warp_ld_inst_num = 0;
-                m_stride_buffer[i].m_warp_entry[j].active = false;
-                m_stride_buffer[i].m_warp_entry[j].valid_intra_stride = false;
-                m_stride_buffer[i].m_warp_entry[j].intra_stride = 0;
-                m_stride_buffer[i].m_warp_entry[j].intra_stride_hit = 0;
-                m_stride_buffer[i].m_warp_entry[j].intra_stride_miss = 0;
-                m_stride_buffer[i].prefetch_hit = 0;
-                m_stride_buffer[i].prefetch_miss = 0;
-                for(int k=0;k<500;k++){
-                    m_stride_buffer[i].m_warp_entry[j].pref_addr_record[k] = (unsigned)-1;
-                }
-            }
-        }
-    }
+    // n_records: load instructions per warp whose prefetch address is kept
+    cache_prefetch( unsigned n_pcs, unsigned n_ctas, unsigned n_warps, unsigned n_records );
     void calculate_inter_warp_stride(int sid, unsigned cta_id, unsigned warp_id, new_addr_type warp_addr, int pc_index);
     void calculate_inter_pref_addr(int sid, int wid, int cta_id);
     void calculate_intra_pref_addr(int sid, int wid, int cta_id);
     void calcu_addr(int sid, int wid, int cta_id, int lead_wid);
     void trace_warp_addr(int sid, unsigned cta_id, unsigned warp_id, new_addr_type warp_addr, int pc_index);
     void calculate_intra_warp_stride(int sid, unsigned warp_id, new_addr_type warp_addr, int index);
+    // The prefetch sent for each warp is tracked until the warp's next demand 
+    // load, which is the load it was predicted for
+    void target_sent( unsigned warp_id, new_addr_type block_addr );
+    void target_filled( unsigned warp_id, new_addr_type block_addr );
+    void target_demand_load( unsigned warp_id );
+    prefetch_target_state target_state( unsigned warp_id ) const {
+        return warp_id < m_targets.size() ? m_targets[warp_id].state : PREFETCH_TARGET_NONE;
+    }
     void select_inter_stride(int sid, unsigned cta_id, unsigned warp_id, new_addr_type warp_addr, int pc_index){
         std::map<long long, int> stride_stat;
         std::vector<long long>::iterator it;
@@ -657,15 +651,18 @@ public:
             m_stride_buffer[pc_index].m_warp_entry[warp_id].intra_warp_stride.clear();
     }
     void find_warp_id(int &lead_warp_id, int &least_Warp_id, int pref_cta_id);
+    void record_pref_addr(unsigned warp_id, int pref_ld_num, new_addr_type addr);
     void fill_entry(address_type pc);
     bool full_entry();
     int probe_entry(address_type pc);
     bool warp_find(int pc_index, unsigned cta_id, unsigned warp_id);
+    void checkpoint( checkpoint_file &cp );
     friend class warp_inst_t;
 //protected:
     struct warp_entry{
         std::vector<unsigned long long> addr_record;
-        new_addr_type pref_addr_record[500];
+        // by load instruction number, grown as prefetches are predicted
+        std::vector<new_addr_type> pref_addr_record;
         std::vector<long long> intra_warp_stride;
         long long intra_stride;
         bool valid_intra_stride;
@@ -693,8 +690,8 @@ public:
     struct stride_buffer
     {
         address_type pc;
-        warp_entry m_warp_entry[48];
-        cta_entry m_cta_entry[8]; 
+        std::vector<warp_entry> m_warp_entry; // by warp id
+        std::vector<cta_entry> m_cta_entry;   // by hardware CTA id
         int active_cta_num;
         int active_warp_num;
         int cta_offset;
@@ -714,10 +711,17 @@ public:
         int put_time;
     };
     prefetch_req m_prefetch_req;
+    struct prefetch_target
+    {
+        new_addr_type block_addr;
+        prefetch_target_state state;
+    };
+    std::vector<prefetch_target> m_targets; // by warp id, grown on demand
     int fill_counter;
     int last_pc_index;
     int last_cta_id;
-    stride_buffer m_stride_buffer[32];
+    std::vector<stride_buffer> m_stride_buffer; // by load instruction, in fill order
+    unsigned m_n_records;
     int is_positive;
 };
 
@@ -735,16 +739,26 @@ public:
     enum cache_request_status pref_access( new_addr_type addr, unsigned time, unsigned &idx, bool &wb, cache_block_t &evicted, bool read_only );
 
 
+    // zero-latency access of a fast-forwarded request: updates the LRU state and 
+    // (if allocate) fills a missing line at once, leaving the access counters alone
+    enum cache_request_status warm( new_addr_type addr, unsigned time, unsigned &idx, bool allocate );
+
     void fill( new_addr_type addr, unsigned time );
     void fill( unsigned idx, unsigned time );
     void pref_fill( unsigned idx, unsigned time, bool is_prefetch );
 
 
     unsigned size() const { return m_config.get_num_lines();}
-    cache_block_t &get_block(unsigned idx) { return m_lines[idx];}
+    const cache_block_t &get_block(unsigned idx) const { return m_lines[idx];}
+    void set_status( unsigned idx, enum cache_block_state status )
+    {
+        m_lines[idx].m_status = status;
+        update_line(idx);
+    }
 
     void flush(); // flash invalidate all entries
     void new_window();
+    void checkpoint( checkpoint_file &cp );
 
     void print( FILE *stream, unsigned &total_access, unsigned &total_misses ) const;
     float windowed_miss_rate( ) const;
@@ -763,6 +777,9 @@ public:
     int get_put_time(){
         return m_cache_prefetch->m_prefetch_req.put_time;
     }
+    // Both are NULL until enabled for the caches that use them
+    void enable_locality_monitor( unsigned n_leaders, unsigned n_entries, unsigned window_size, unsigned n_warps );
+    void enable_prefetcher( unsigned n_pcs, unsigned n_ctas, unsigned n_warps, unsigned n_records );
     warp_locality_evaluation* m_wle;
     cache_prefetch* m_cache_prefetch;
     friend class warp_inst_t;
@@ -779,12 +796,33 @@ protected:
                cache_block_t* new_lines );
     void init( int core_id, int type_id );
 
+    // ways of the set whose tag matches, bit i for way i
+    unsigned long long match_ways( unsigned set_index, new_addr_type tag ) const;
+    // replacement candidate of the set on a miss: MISS, or RESERVATION_FAIL if
+    // every line is reserved
+    enum cache_request_status find_victim( unsigned set_index, unsigned &idx ) const;
+    // copies what probe looks at from m_lines[idx], after every change to it
+    void update_line( unsigned idx )
+    {
+        const cache_block_t &line = m_lines[idx];
+        m_line_tag[idx] = line.m_tag;
+        m_line_status[idx] = line.m_status;
+        m_line_stamp[idx] = m_config.m_replacement_policy == FIFO ? line.m_alloc_time : line.m_last_access_time;
+    }
+
 protected:
 
     cache_config &m_config;
 
     cache_block_t *m_lines; /* nbanks x nset x assoc lines in total */
 
+    // the tag, state and replacement time stamp (LRU: last access, FIFO: 
+    // allocation) of m_lines as contiguous arrays, so that all the ways of a
+    // set are compared at once instead of walking the line records
+    std::vector<new_addr_type> m_line_tag;
+    std::vector<unsigned char> m_line_status;
+    std::vector<unsigned> m_line_stamp;
+
     unsigned m_access;
     unsigned m_miss;
     unsigned m_pending_hit; // number of cache miss that hit a line that is allocated but not filled
@@ -798,6 +836,13 @@ protected:
     int m_core_id; // which shader core is using this
     int m_type_id; // what kind of cache is this (normal, texture, constant)
 
+    // prefetch debugging: time of the last allocation/fill of each line and 
+    // the mean first-use interval of prefetched lines (printed for core 0)
+    std::vector<unsigned> m_last_alloc_time;
+    std::vector<unsigned> m_last_fill_time;
+    float m_tot_interval;
+    float m_interval_times;
+
 
 };
 
@@ -827,6 +872,11 @@ public:
     /// Returns next ready access
     mem_fetch *next_access();
     void display( FILE *fp ) const;
+    void checkpoint( checkpoint_file &cp );
+    bool empty() const { return m_data.empty() && m_current_response.empty(); }
+    /// Entries tracking a pending request, out of num_entries()
+    unsigned num_used() const { return m_data.size(); }
+    unsigned num_entries() const { return m_num_entries; }
 
     void check_mshr_parameters( unsigned num_entries, unsigned max_merged )
     {
@@ -868,6 +918,12 @@ struct cache_sub_stats{
     unsigned long long data_port_busy_cycles; 
     unsigned long long fill_port_busy_cycles; 
 
+    // prefetched lines first used after the fill, before it (HIT_RESERVED)
+    // or evicted unused
+    unsigned prefetch_on_time;
+    unsigned prefetch_late;
+    unsigned prefetch_evicted;
+
     cache_sub_stats(){
         clear();
     }
@@ -879,6 +935,9 @@ struct cache_sub_stats{
         port_available_cycles = 0; 
         data_port_busy_cycles = 0; 
         fill_port_busy_cycles = 0; 
+        prefetch_on_time = 0;
+        prefetch_late = 0;
+        prefetch_evicted = 0;
     }
     cache_sub_stats &operator+=(const cache_sub_stats &css){
         ///
@@ -891,6 +950,9 @@ struct cache_sub_stats{
         port_available_cycles += css.port_available_cycles; 
         data_port_busy_cycles += css.data_port_busy_cycles; 
         fill_port_busy_cycles += css.fill_port_busy_cycles; 
+        prefetch_on_time += css.prefetch_on_time;
+        prefetch_late += css.prefetch_late;
+        prefetch_evicted += css.prefetch_evicted;
         return *this;
     }
 
@@ -906,6 +968,9 @@ struct cache_sub_stats{
         ret.port_available_cycles = port_available_cycles + cs.port_available_cycles; 
         ret.data_port_busy_cycles = data_port_busy_cycles + cs.data_port_busy_cycles; 
         ret.fill_port_busy_cycles = fill_port_busy_cycles + cs.fill_port_busy_cycles; 
+        ret.prefetch_on_time = prefetch_on_time + cs.prefetch_on_time;
+        ret.prefetch_late = prefetch_late + cs.prefetch_late;
+        ret.prefetch_evicted = prefetch_evicted + cs.prefetch_evicted;
         return ret;
     }
 
@@ -935,6 +1000,7 @@ public:
     void get_sub_stats(struct cache_sub_stats &css) const;
 
     void sample_cache_port_utility(bool data_port_busy, bool fill_port_busy); 
+    void checkpoint( checkpoint_file &cp );
 private:
     bool check_valid(int type, int status) const;
 
@@ -982,6 +1048,7 @@ public:
         assert(config.m_mshr_type == ASSOC);
         m_memport=memport;
         m_miss_queue_status = status;
+        m_actual_push_time = 0;
     }
 
     virtual ~baseline_cache()
@@ -1021,48 +1088,92 @@ public:
     }
     void get_sub_stats(struct cache_sub_stats &css) const {
         m_stats.get_sub_stats(css);
+        css.prefetch_on_time = m_tag_array->prefetch_hit_num;
+        css.prefetch_late = m_tag_array->prefetch_hit_res_num;
+        css.prefetch_evicted = m_tag_array->useless_prefetch;
     }
 
     // accessors for cache bandwidth availability 
     bool data_port_free() const { return m_bandwidth_management.data_port_free(); } 
     bool fill_port_free() const { return m_bandwidth_management.fill_port_free(); } 
 
+    /// True if cycle() would do nothing but sample the (idle) port utilization
+    bool quiescent() const 
+    {
+        return m_miss_queue.empty() && m_pref_miss_queue.empty() && !access_ready() && 
+               data_port_free() && fill_port_free(); 
+    }
+    /// Equivalent of cycle() for a quiescent cache
+    void skip_cycle() { m_stats.sample_cache_port_utility(false, false); }
+    /// Save/restore tags, prefetcher and locality tables and stats (cache must be drained)
+    void checkpoint( checkpoint_file &cp );
+
+    /// Allocate the locality monitor and prefetcher of the tag array (L1D only)
+    void enable_locality_monitor( unsigned n_leaders, unsigned n_entries, unsigned window_size, unsigned n_warps ){
+        m_tag_array->enable_locality_monitor(n_leaders, n_entries, window_size, n_warps);
+    }
+    void enable_prefetcher( unsigned n_pcs, unsigned n_ctas, unsigned n_warps, unsigned n_records ){
+        m_tag_array->enable_prefetcher(n_pcs, n_ctas, n_warps, n_records);
+    }
+    bool prefetcher_enabled() const { return m_tag_array->m_cache_prefetch != NULL; }
+
     int get_tag_array_inter_warp_locality() const{
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->m_inter_warp_locality;
         return -1;
     }
     int get_tag_array_intra_warp_locality() const{
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->m_intra_warp_locality;
         return -1;
     }
     int get_tag_array_miss_inter_warp_locality() const{
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->m_miss_inter_warp_locality;
         return -1;
     }
     int get_tag_array_miss_intra_warp_locality() const{
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->m_miss_intra_warp_locality;
         return -1;
     }
+    const warp_locality_counts *get_tag_array_parity_locality() const{
+        if(m_tag_array->m_wle)
+            return m_tag_array->m_wle->m_parity_locality;
+        return NULL;
+    }
+    prefetch_target_state get_prefetch_target_state( unsigned warp_id ) const{
+        if(m_tag_array->m_cache_prefetch)
+            return m_tag_array->m_cache_prefetch->target_state(warp_id);
+        return PREFETCH_TARGET_NONE;
+    }
+    /// Percentage of the MSHRs or of the miss queue in use, whichever is fuller
+    unsigned miss_resource_utilization() const{
+        unsigned mshr = 100 * m_mshrs.num_used() / m_mshrs.num_entries();
+        unsigned miss_queue = 100 * m_miss_queue.size() / m_config.m_miss_queue_size;
+        return mshr > miss_queue ? mshr : miss_queue;
+    }
+    void set_locality_warps_per_cta( unsigned warps_per_cta ){
+        if(m_tag_array->m_wle)
+            m_tag_array->m_wle->set_warps_per_cta(warps_per_cta);
+    }
     void flush_tag_array_inter_warp_locality(){
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             m_tag_array->m_wle->flush_tag_array_inter_warp_locality();
     }
     int get_L1Dcache_hit_num(){
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->cache_hit_num;
         return -1;
     }
     int get_L1Dcache_miss_num(){
-        if(m_tag_array)
+        if(m_tag_array->m_wle)
             return m_tag_array->m_wle->cache_miss_num;
         return -1;
     }
     void flush_L1Dcache_hit_num(){
-        m_tag_array->m_wle->cache_hit_num=0;
+        if(m_tag_array->m_wle)
+            m_tag_array->m_wle->cache_hit_num=0;
     }
     //void send_write_request_pref(mem_fetch *pref_mf, cache_event request, unsigned time, std::list<cache_event> &events);
 
@@ -1112,6 +1223,7 @@ protected:
     extra_mf_fields_lookup m_extra_mf_fields;
 
     cache_stats m_stats;
+    int m_actual_push_time; // prefetches sent to the miss queue (debug print)
 
     /// Checks whether this request can be handled on this cycle. num_miss equals max # of misses to be handled on this cycle
     bool miss_queue_full(unsigned num_miss){
@@ -1147,6 +1259,8 @@ protected:
         bool data_port_free() const; 
         /// query for fill port availability 
         bool fill_port_free() const; 
+
+        void checkpoint( checkpoint_file &cp );
     protected: 
         const cache_config &m_config; 
 
@@ -1232,6 +1346,11 @@ public:
                                               unsigned time,
                                               std::list<cache_event> &events,
                                               bool is_l1_cache );
+    // Functional access used by sampled simulation to warm the tags (and, for 
+    // the L1, the locality monitor and prefetcher) of a fast-forwarded request 
+    // without timing or statistics. Returns true if the request continues to 
+    // the next level of the hierarchy.
+    bool warm( mem_fetch *mf, unsigned time, bool is_l1_cache );
 protected:
     data_cache( const char *name,
                 cache_config &config,
@@ -1382,6 +1501,37 @@ protected:
 
 };
 
+/// Victim tag array of cache-conscious wavefront scheduling (CCWS): the tags
+/// of the lines each warp allocated in the L1D and lost to an eviction, and a
+/// lost-locality score per warp. A miss on a tag the same warp lost raises its
+/// score by k_throttle; scores decay by one per cycle down to base_score.
+class victim_tag_array {
+public:
+    victim_tag_array( unsigned n_warps, unsigned entries_per_warp, unsigned base_score, unsigned k_throttle );
+
+    /// warp_id's line with this tag was evicted
+    void evicted( unsigned warp_id, new_addr_type tag );
+    /// warp_id missed on tag, returns true if it had lost the line
+    bool miss( unsigned warp_id, new_addr_type tag, unsigned time );
+    unsigned score( unsigned warp_id, unsigned time ) const;
+    unsigned base_score() const { return m_base_score; }
+    bool same_config( unsigned n_warps, unsigned entries_per_warp, unsigned base_score, unsigned k_throttle ) const;
+    unsigned long long hits() const { return m_hits; }
+    void checkpoint( checkpoint_file &cp );
+
+private:
+    unsigned m_n_warps;
+    unsigned m_entries;
+    unsigned m_base_score;
+    unsigned m_k_throttle;
+    std::vector<new_addr_type> m_tags; // m_entries per warp, replaced FIFO
+    std::vector<bool> m_valid;
+    std::vector<unsigned> m_next;      // next FIFO entry of each warp
+    std::vector<unsigned> m_score;     // score above base_score at m_score_time
+    std::vector<unsigned> m_score_time;
+    unsigned long long m_hits;
+};
+
 /// This is meant to model the first level data cache in Fermi.
 /// It is write-evict (global) or write-back (local) at
 /// the granularity of individual blocks
@@ -1391,9 +1541,10 @@ public:
     l1_cache(const char *name, cache_config &config,
             int core_id, int type_id, mem_fetch_interface *memport,
             mem_fetch_allocator *mfcreator, enum mem_fetch_status status )
-            : data_cache(name,config,core_id,type_id,memport,mfcreator,status, L1_WR_ALLOC_R, L1_WRBK_ACC){}
+            : data_cache(name,config,core_id,type_id,memport,mfcreator,status, L1_WR_ALLOC_R, L1_WRBK_ACC),
+              m_victim_tags(NULL){}
 
-    virtual ~l1_cache(){}
+    virtual ~l1_cache(){ delete m_victim_tags; }
 
     virtual enum cache_request_status
         access( new_addr_type addr,
@@ -1402,6 +1553,12 @@ public:
                 unsigned time,
                 std::list<cache_event> &events );
 
+    /// Track the lines evicted from the warps that allocated them (CCWS);
+    /// every caller must ask for the same configuration
+    victim_tag_array *enable_victim_tags( unsigned n_warps, unsigned entries_per_warp, 
+                                          unsigned base_score, unsigned k_throttle );
+    void checkpoint( checkpoint_file &cp );
+
 protected:
     l1_cache( const char *name,
               cache_config &config,
@@ -1413,8 +1570,12 @@ protected:
               tag_array* new_tag_array )
     : data_cache( name,
                   config,
-                  core_id,type_id,memport,mfcreator,status, new_tag_array, L1_WR_ALLOC_R, L1_WRBK_ACC ){}
+                  core_id,type_id,memport,mfcreator,status, new_tag_array, L1_WR_ALLOC_R, L1_WRBK_ACC ),
+      m_victim_tags(NULL){}
 
+    victim_tag_array *m_victim_tags;
+    // tag and warp of the demand load that allocated each line
+    std::vector< std::pair<new_addr_type,unsigned> > m_line_owner;
 };
 
 /// Models second level shared cache with global write-back
@@ -1484,6 +1645,16 @@ public:
     bool data_port_free() const { return true; }
     bool fill_port_free() const { return true; }
 
+    /// True if cycle() would do nothing (no pending requests or fragments)
+    bool quiescent() const 
+    {
+        return m_request_fifo.empty() && m_fragment_fifo.empty() && m_result_fifo.empty(); 
+    }
+    /// Equivalent of cycle() for a quiescent cache
+    void skip_cycle() { }
+    /// Save/restore tags, data block state and stats (cache must be drained)
+    void checkpoint( checkpoint_file &cp );
+
     // Stat collection
     const cache_stats &get_stats() const {
         return m_stats;
@@ -1585,6 +1756,20 @@ private:
         {
             return m_tail;
         }
+        /// index of the n-th oldest entry
+        unsigned index( unsigned n ) const
+        {
+            return (m_tail+n)%m_size;
+        }
+        /// entries keep their index across a checkpoint, the reorder buffer 
+        /// index of a request refers to it
+        template<class CP> void checkpoint_indices( CP &cp )
+        {
+            cp.check_size(m_size,"texture cache fifo");
+            cp.pod(m_head);
+            cp.pod(m_tail);
+            cp.pod(m_num);
+        }
     private:
         void inc_head() { m_head = (m_head+1)%m_size; m_num++;}
         void inc_tail() { assert(m_num>0); m_tail = (m_tail+1)%m_size; m_num--;}
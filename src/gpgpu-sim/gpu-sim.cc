@@ -61,6 +61,10 @@
 #include "power_stat.h"
 #include "visualizer.h"
 #include "stats.h"
+#include "sim_thread_pool.h"
+#include "checkpoint.h"
+#include "warp_trace.h"
+#include "host_profile.h"
 
 #ifdef GPGPUSIM_POWER_MODEL
 #include "power_interface.h"
@@ -79,14 +83,10 @@ class  gpgpu_sim_wrapper {};
 
 bool g_interactive_debugger_enabled=false;
 
-unsigned long long  gpu_sim_cycle = 0;
-unsigned long long  gpu_tot_sim_cycle = 0;
+__thread unsigned long long  gpu_sim_cycle = 0;
+__thread unsigned long long  gpu_tot_sim_cycle = 0;
 
 
-// performance counter for stalls due to congestion.
-unsigned int gpu_stall_dramfull = 0; 
-unsigned int gpu_stall_icnt2sh = 0;
-
 /* Clock Domains */
 
 #define  CORE  0x01
@@ -94,6 +94,10 @@ unsigned int gpu_stall_icnt2sh = 0;
 #define  DRAM  0x04
 #define  ICNT  0x08  
 
+// limits of the integer clock model (see gpgpu_sim::build_clock_schedule())
+#define  CLOCK_MAX_TICK_KHZ        (1ULL<<40)
+#define  CLOCK_SCHEDULE_MAX_STEPS  65536
+
 
 #define MEM_LATENCY_STAT_IMPL
 
@@ -226,6 +230,21 @@ void shader_core_config::reg_options(class OptionParser * opp)
                    "per-shader L1 data cache config "
                    " {<nsets>:<bsize>:<assoc>,<rep>:<wr>:<alloc>:<wr_alloc>,<mshr>:<N>:<merge>,<mq> | none}",
                    "none" );
+    option_parser_register(opp, "-gpgpu_l1d_locality_monitor", OPT_CSTR, &gpgpu_l1d_locality_monitor_string,
+                   "L1D warp locality monitor: tags tracked per monitored set, warp ids per tag window and sets monitored (0 = all) "
+                   " {<entries>:<window>[:<leader_sets>] | none}",
+                   "64:4:16" );
+    option_parser_register(opp, "-gpgpu_l1d_prefetcher", OPT_CSTR, &gpgpu_l1d_prefetcher_string,
+                   "L1D stride prefetcher: load instructions tracked and prefetch addresses kept per warp and load instruction "
+                   " {<pcs>:<records> | none}",
+                   "32:500" );
+    option_parser_register(opp, "-gpgpu_caws_shadow_tags", OPT_CSTR, &gpgpu_caws_shadow_tags_string,
+                   "CAWS shadow tags (caws:<epoch>:<mode>:<hysteresis>:<warp_limit>:1): L1D sets sampled and loads reordered at a time "
+                   " {<sets>:<window>}",
+                   "8:64" );
+    option_parser_register(opp, "-gpgpu_caws_verbose", OPT_BOOL, &caws_verbose,
+                   "print the locality counts, shadow tag estimates and policy of every CAWS epoch of shader 0 (per-core and per-scheduler)",
+                   "0" );
     option_parser_register(opp, "-gmem_skip_L1D", OPT_BOOL, &gmem_skip_L1D, 
                    "global memory access skip L1D cache (implements -Xptxas -dlcm=cg, default=no skip)",
                    "0");
@@ -347,6 +366,9 @@ void shader_core_config::reg_options(class OptionParser * opp)
     option_parser_register(opp, "-gpgpu_simt_core_sim_order", OPT_INT32, &simt_core_sim_order,
                             "Select the simulation order of cores in a cluster (0=Fix, 1=Round-Robin)",
                             "1");
+    option_parser_register(opp, "-gpgpu_skip_idle_cores", OPT_BOOL, &gpgpu_skip_idle_cores,
+                            "Only update the statistics of SIMT cores that have no CTA and nothing in flight",
+                            "1");
     option_parser_register(opp, "-gpgpu_pipeline_widths", OPT_CSTR, &pipeline_widths_string,
                             "Pipeline widths "
                             "ID_OC_SP,ID_OC_SFU,ID_OC_MEM,OC_EX_SP,OC_EX_SFU,OC_EX_MEM,EX_WB",
@@ -361,8 +383,20 @@ void shader_core_config::reg_options(class OptionParser * opp)
                             "Number if ldst units (default=1) WARNING: not hooked up to anything",
                              "1");
     option_parser_register(opp, "-gpgpu_scheduler", OPT_CSTR, &gpgpu_scheduler_string,
-                                "Scheduler configuration: < lrr | gto | two_level_active | caws > " /*cory*/
+                                "Scheduler configuration: < lrr | gto | two_level_active | caws | ccws | cta_aware | barrier_aware | prefetch_aware | divergence_aware > " /*cory*/
                                 "If two_level_active:<num_active_warps>:<inner_prioritization>:<outer_prioritization>"
+                                "If caws:<epoch>:<mode>, mode 0/1 = one policy per core every <epoch> loads/cycles, "
+                                "2/3 = one policy per scheduler unit every <epoch> loads of its warps/cycles (caws = caws:2000:0). "
+                                "caws:<epoch>:<mode>:<hysteresis>:<warp_limit> only switches policy after it won <hysteresis>+1 epochs "
+                                "in a row and limits GTO to <warp_limit> warps when intra-warp misses dominate (0 = never)"
+                                "If ccws:<vta_entries>:<k_throttle>:<base_score>, GTO that holds back the global/local loads "
+                                "of warps by lost L1D locality, tracked in <vta_entries> victim tags per warp (ccws = ccws:8:100:100). "
+                                "cta_aware keeps issuing from the oldest CTA until all its warps wait on long operations. "
+                                "barrier_aware is GTO that boosts the lagging warps of CTAs with warps waiting at a barrier. "
+                                "prefetch_aware is LRR that deprioritizes the warps an L1D prefetch is in flight for and promotes them once it fills. "
+                                "If divergence_aware:<busy_pct>:<idle_pct>, warps with the fewest transactions per load go first while the L1D "
+                                "MSHRs or miss queue are >= <busy_pct> percent full and those with the most while they are <= <idle_pct> percent full "
+                                "(divergence_aware = divergence_aware:75:25). "
                                 "For complete list of prioritization values see shader.h enum scheduler_prioritization_type"
                                 "Default: gto",
                                  "gto");
@@ -409,8 +443,34 @@ void gpgpu_sim_config::reg_options(option_parser_t opp)
    option_parser_register(opp, "-gpgpu_clock_domains", OPT_CSTR, &gpgpu_clock_domains, 
                   "Clock Domain Frequencies in MhZ {<Core Clock>:<ICNT Clock>:<L2 Clock>:<DRAM Clock>}",
                   "500.0:2000.0:2000.0:2000.0");
+   option_parser_register(opp, "-gpgpu_dvfs_schedule", OPT_CSTR, &gpgpu_dvfs_schedule, 
+                  "Clock Domain Frequencies in MhZ set before the n-th grid of this run starts "
+                  "{<grid>:<Core Clock>:<ICNT Clock>:<L2 Clock>:<DRAM Clock>[,...] | none}",
+                  "none");
    option_parser_register(opp, "-gpgpu_max_concurrent_kernel", OPT_INT32, &max_concurrent_kernel,
                           "maximum kernels that can run concurrently on GPU", "8" );
+   option_parser_register(opp, "-gpgpu_sim_threads", OPT_UINT32, &gpgpu_sim_threads,
+                          "number of host threads used to step the SIMT core clusters and memory partitions (1 = single-threaded)", "1" );
+   option_parser_register(opp, "-gpgpu_skip_stalled_cycles", OPT_BOOL, &gpgpu_skip_stalled_cycles,
+                          "skip the pipeline of SIMT cores while every core is stalled waiting for memory", "0" );
+   option_parser_register(opp, "-gpgpu_timing_checkpoint_file", OPT_CSTR, &gpgpu_timing_checkpoint_file,
+                          "file used to save/restore the timing model state between grids", "gpgpusim_timing.ckpt" );
+   option_parser_register(opp, "-gpgpu_timing_checkpoint_save", OPT_UINT32, &gpgpu_timing_checkpoint_save,
+                          "save the timing model state after the n-th grid of this run completes, restored with -gpgpu_timing_checkpoint_restore n+1 (0 = never)", "0" );
+   option_parser_register(opp, "-gpgpu_timing_checkpoint_save_cycle", OPT_UINT32, &gpgpu_timing_checkpoint_save_cycle,
+                          "with -gpgpu_warp_trace 2, save in the middle of grid -gpgpu_timing_checkpoint_save n once it has run this many cycles, restored with -gpgpu_timing_checkpoint_restore n (0 = after the grid)", "0" );
+   option_parser_register(opp, "-gpgpu_timing_checkpoint_restore", OPT_UINT32, &gpgpu_timing_checkpoint_restore,
+                          "restore the timing model state before (or, for a mid-grid checkpoint, into) the n-th grid of this run; the grids before it are executed functionally, or skipped with -gpgpu_warp_trace 2 (0 = never)", "0" );
+   option_parser_register(opp, "-gpgpu_sample_detail_ctas", OPT_UINT32, &gpgpu_sample_detail_ctas,
+                          "sampled simulation: CTAs per detailed timing window (0 = simulate every CTA in detail)", "0" );
+   option_parser_register(opp, "-gpgpu_sample_ff_ctas", OPT_UINT32, &gpgpu_sample_ff_ctas,
+                          "sampled simulation: CTAs executed functionally (warming the caches) after each detailed window", "0" );
+   option_parser_register(opp, "-gpgpu_warp_trace", OPT_UINT32, &gpgpu_warp_trace,
+                          "warp trace of each kernel launch (0 = off, 1 = capture while executing functionally, 2 = replay instead of executing functionally)", "0" );
+   option_parser_register(opp, "-gpgpu_warp_trace_file", OPT_CSTR, &gpgpu_warp_trace_file,
+                          "warp trace file prefix, the trace of kernel launch <uid> is <prefix>.<uid>.gz", "gpgpusim_warp_trace" );
+   option_parser_register(opp, "-gpgpu_host_profile_interval", OPT_UINT32, &gpgpu_host_profile_interval,
+                          "time the simulator's components on every n-th core cycle (0 = off, needs a PROFILE=1 build)", "0" );
    option_parser_register(opp, "-gpgpu_cflog_interval", OPT_INT32, &gpgpu_cflog_interval, 
                "Interval between each snapshot in control flow logger", 
                "0");
@@ -475,6 +535,10 @@ void gpgpu_sim::launch( kernel_info_t *kinfo )
        }
    }
    assert(n < m_running_kernels.size());
+   if( m_checkpoint_restore_pending ) {
+       m_checkpoint_restore_pending = false;
+       restore_checkpoint(m_config.gpgpu_timing_checkpoint_file, kinfo);
+   }
 }
 
 bool gpgpu_sim::can_start_kernel()
@@ -518,6 +582,20 @@ kernel_info_t *gpgpu_sim::select_kernel()
     return NULL;
 }
 
+// opened when the first CTA of the kernel launch is issued, closed by set_kernel_done()
+warp_trace_file *gpgpu_sim::warp_trace( const kernel_info_t &kernel )
+{
+    std::map<unsigned,warp_trace_file*>::iterator t = m_warp_traces.find(kernel.get_uid());
+    if( t != m_warp_traces.end() ) 
+        return t->second;
+    char filename[1024];
+    snprintf(filename, sizeof(filename), "%s.%u.gz", m_config.gpgpu_warp_trace_file, kernel.get_uid());
+    warp_trace_file *trace = new warp_trace_file(filename, m_config.gpgpu_warp_trace == WARP_TRACE_CAPTURE, 
+                                                 kernel, m_shader_config->warp_size, gpu_tot_sim_cycle + gpu_sim_cycle);
+    m_warp_traces[kernel.get_uid()] = trace;
+    return trace;
+}
+
 unsigned gpgpu_sim::finished_kernel()
 {
     if( m_finished_kernel.empty() ) 
@@ -531,6 +609,12 @@ void gpgpu_sim::set_kernel_done( kernel_info_t *kernel )
 { 
     unsigned uid = kernel->get_uid();
     m_finished_kernel.push_back(uid);
+    std::map<unsigned,warp_trace_file*>::iterator t = m_warp_traces.find(uid);
+    if( t != m_warp_traces.end() ) {
+        t->second->finish(gpu_tot_sim_cycle + gpu_sim_cycle);
+        delete t->second;
+        m_warp_traces.erase(t);
+    }
     std::vector<kernel_info_t*>::iterator k;
     for( k=m_running_kernels.begin(); k!=m_running_kernels.end(); k++ ) {
         if( *k == kernel ) {
@@ -556,32 +640,114 @@ gpgpu_sim::gpgpu_sim( const gpgpu_sim_config &config )
 #endif
 
     m_shader_stats = new shader_core_stats(m_shader_config);
-    m_memory_stats = new memory_stats_t(m_config.num_shader(),m_shader_config,m_memory_config);
+    m_memory_stats = new memory_stats_t(m_config.num_shader(),m_shader_config,m_memory_config,this);
     average_pipeline_duty_cycle = (float *)malloc(sizeof(float));
     active_sms=(float *)malloc(sizeof(float));
     m_power_stats = new power_stat_t(m_shader_config,average_pipeline_duty_cycle,active_sms,m_shader_stats,m_memory_config,m_memory_stats);
 
+    gpu_sim_cycle = 0;
+    gpu_tot_sim_cycle = 0;
     gpu_sim_insn = 0;
     gpu_tot_sim_insn = 0;
     gpu_tot_issued_cta = 0;
+    gpu_stall_icnt2sh = 0;
+    m_next_mf_request_uid = 1;
+    m_single_step = 0;
     gpu_deadlock = false;
-
+    m_stat_tool = stat_tool_create();
+    stat_tool_bind(m_stat_tool);
+
+    core_khz = (unsigned long long) llround(m_config.core_freq/1000);
+    icnt_khz = (unsigned long long) llround(m_config.icnt_freq/1000);
+    l2_khz = (unsigned long long) llround(m_config.l2_freq/1000);
+    dram_khz = (unsigned long long) llround(m_config.dram_freq/1000);
+    m_clock_schedule_valid = false;
+    reinit_clock_domains();
+    if (strcmp(m_config.gpgpu_dvfs_schedule,"none") != 0) {
+        for (const char *s = m_config.gpgpu_dvfs_schedule; s; s = strchr(s,',')) {
+            if (*s == ',') 
+                s++;
+            dvfs_point p;
+            if (sscanf(s,"%u:%lf:%lf:%lf:%lf",&p.grid,&p.core_mhz,&p.icnt_mhz,&p.l2_mhz,&p.dram_mhz) != 5 || p.grid == 0
+                || p.core_mhz <= 0 || p.icnt_mhz <= 0 || p.l2_mhz <= 0 || p.dram_mhz <= 0) {
+                printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_dvfs_schedule \"%s\", expected "
+                       "<grid>:<core>:<icnt>:<l2>:<dram>[,...] with frequencies in MHz\n", m_config.gpgpu_dvfs_schedule);
+                abort();
+            }
+            m_dvfs_schedule.push_back(p);
+        }
+    }
 
     m_cluster = new simt_core_cluster*[m_shader_config->n_simt_clusters];
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
         m_cluster[i] = new simt_core_cluster(this,i,m_shader_config,m_memory_config,m_shader_stats,m_memory_stats);
 
+    m_thread_pool = NULL;
+    if (m_config.gpgpu_sim_threads > 1) {
+        unsigned n_threads = m_config.gpgpu_sim_threads;
+        unsigned max_units = m_shader_config->n_simt_clusters;
+        if (m_memory_config->m_n_mem_sub_partition > max_units) 
+            max_units = m_memory_config->m_n_mem_sub_partition;
+        if (n_threads > max_units) 
+            n_threads = max_units;
+        m_thread_pool = new sim_thread_pool(n_threads);
+        pthread_mutex_init(&m_functional_mutex,NULL);
+        pthread_cond_init(&m_functional_turn_cond,NULL);
+        pthread_mutex_init(&m_icnt_mutex,NULL);
+        printf("GPGPU-Sim uArch: stepping %u SIMT clusters and %u memory sub partitions on %u host threads\n", 
+               m_shader_config->n_simt_clusters, m_memory_config->m_n_mem_sub_partition, n_threads);
+    }
+    m_cluster_stepped.resize(m_shader_config->n_simt_clusters, false);
+    m_cluster_cycle_done.resize(m_shader_config->n_simt_clusters, true);
+    m_functional_turn = m_shader_config->n_simt_clusters; // unordered outside cluster_core_cycle_all()
+    m_cores_skipping = false;
+    m_skip_more_cta_left = false;
+    m_skip_cta_launched = 0;
+    m_skipped_core_cycles = 0;
+    m_grids_simulated = 0;
+    m_checkpoint_kernel = NULL;
+    m_checkpoint_restore_pending = false;
+    m_checkpoint_saved = false;
+    m_sample_phase = SAMPLE_DETAILED;
+    m_sample_window_ctas = 0;
+    m_sample_steady = false;
+    m_sample_running_ctas = 0;
+    m_sample_window_cycles = 0;
+    m_sample_window_done = 0;
+    m_sample_unsteady_windows = 0;
+    m_sample_detail_ctas = 0;
+    m_sample_ff_ctas = 0;
+    m_sample_ff_insn = 0;
+
+#ifndef GPGPUSIM_HOST_PROFILE
+    if (m_config.gpgpu_host_profile_interval) 
+        printf("GPGPU-Sim uArch: WARNING ** -gpgpu_host_profile_interval ignored, the simulator was built without PROFILE=1\n");
+#endif
+    if (m_config.gpgpu_warp_trace > WARP_TRACE_REPLAY) {
+        printf("GPGPU-Sim uArch: ERROR ** -gpgpu_warp_trace %u is not a valid mode\n", m_config.gpgpu_warp_trace);
+        abort();
+    }
+    if (m_config.gpgpu_warp_trace == WARP_TRACE_REPLAY && m_config.gpgpu_sample_detail_ctas) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace replay cannot fast-forward CTAs functionally (-gpgpu_sample_detail_ctas)\n");
+        abort();
+    }
+    if (m_config.gpgpu_timing_checkpoint_save_cycle && 
+        (m_config.gpgpu_warp_trace != WARP_TRACE_REPLAY || !m_config.gpgpu_timing_checkpoint_save)) {
+        printf("GPGPU-Sim uArch: ERROR ** -gpgpu_timing_checkpoint_save_cycle requires -gpgpu_warp_trace 2 and -gpgpu_timing_checkpoint_save\n");
+        abort();
+    }
+
     m_memory_partition_unit = new memory_partition_unit*[m_memory_config->m_n_mem];
     m_memory_sub_partition = new memory_sub_partition*[m_memory_config->m_n_mem_sub_partition];
     for (unsigned i=0;i<m_memory_config->m_n_mem;i++) {
-        m_memory_partition_unit[i] = new memory_partition_unit(i, m_memory_config, m_memory_stats);
+        m_memory_partition_unit[i] = new memory_partition_unit(i, m_memory_config, m_memory_stats, this, m_thread_pool != NULL);
         for (unsigned p = 0; p < m_memory_config->m_n_sub_partition_per_memory_channel; p++) {
             unsigned submpid = i * m_memory_config->m_n_sub_partition_per_memory_channel + p; 
             m_memory_sub_partition[submpid] = m_memory_partition_unit[i]->get_sub_partition(p); 
         }
     }
 
-    icnt_wrapper_init();
+    m_icnt = icnt_wrapper_init();
     icnt_create(m_shader_config->n_simt_clusters,m_memory_config->m_n_mem_sub_partition);
 
     time_vector_create(NUM_MEM_REQ_STAT);
@@ -633,12 +799,18 @@ enum divergence_support_t gpgpu_sim::simd_model() const
 
 void gpgpu_sim_config::init_clock_domains(void ) 
 {
+   double core_mhz, icnt_mhz, l2_mhz, dram_mhz;
    sscanf(gpgpu_clock_domains,"%lf:%lf:%lf:%lf", 
-          &core_freq, &icnt_freq, &l2_freq, &dram_freq);
-   core_freq = core_freq MhZ;
-   icnt_freq = icnt_freq MhZ;
-   l2_freq = l2_freq MhZ;
-   dram_freq = dram_freq MhZ;        
+          &core_mhz, &icnt_mhz, &l2_mhz, &dram_mhz);
+   set_clock_domains(core_mhz, icnt_mhz, l2_mhz, dram_mhz);
+}
+
+void gpgpu_sim_config::set_clock_domains( double core_mhz, double icnt_mhz, double l2_mhz, double dram_mhz ) const
+{
+   core_freq = core_mhz MhZ;
+   icnt_freq = icnt_mhz MhZ;
+   l2_freq = l2_mhz MhZ;
+   dram_freq = dram_mhz MhZ;        
    core_period = 1/core_freq;
    icnt_period = 1/icnt_freq;
    dram_period = 1/dram_freq;
@@ -649,10 +821,86 @@ void gpgpu_sim_config::init_clock_domains(void )
 
 void gpgpu_sim::reinit_clock_domains(void)
 {
+   if (!m_clock_schedule_valid) 
+      build_clock_schedule();
    core_time = 0;
    dram_time = 0;
    icnt_time = 0;
    l2_time = 0;
+   m_clock_schedule_pos = 0;
+}
+
+void gpgpu_sim::set_clock_domains( double core_mhz, double icnt_mhz, double l2_mhz, double dram_mhz )
+{
+   // the config keeps the frequencies shader_clock() and the power model read
+   m_config.set_clock_domains(core_mhz, icnt_mhz, l2_mhz, dram_mhz);
+   core_khz = (unsigned long long) llround(core_mhz*1000);
+   icnt_khz = (unsigned long long) llround(icnt_mhz*1000);
+   l2_khz = (unsigned long long) llround(l2_mhz*1000);
+   dram_khz = (unsigned long long) llround(dram_mhz*1000);
+   m_clock_schedule_valid = false;
+   reinit_clock_domains();
+}
+
+static unsigned long long gcd_ull( unsigned long long a, unsigned long long b )
+{
+   while (b) {
+      unsigned long long t = a % b;
+      a = b;
+      b = t;
+   }
+   return a;
+}
+
+// Clock edges are kept as integer multiples of a tick of 1/lcm(domain frequencies),
+// so every period is exact and simultaneous edges of different domains line up 
+// no matter how long the simulation runs. The order of edges repeats every 
+// hyperperiod (the lcm of the periods); when that is short enough, the masks 
+// returned by next_clock_domain() are precomputed for one hyperperiod.
+void gpgpu_sim::build_clock_schedule(void)
+{
+   assert(core_khz && icnt_khz && l2_khz && dram_khz);
+   unsigned long long khz[4] = { core_khz, icnt_khz, l2_khz, dram_khz };
+   unsigned long long tick_khz = 1;
+   for (unsigned i=0;i<4;i++) {
+      unsigned long long g = gcd_ull(tick_khz,khz[i]);
+      if (tick_khz/g > CLOCK_MAX_TICK_KHZ/khz[i]) {
+         tick_khz = 0;
+         break;
+      }
+      tick_khz = tick_khz/g*khz[i];
+   }
+   if (tick_khz) {
+      core_period = tick_khz/core_khz;
+      icnt_period = tick_khz/icnt_khz;
+      l2_period = tick_khz/l2_khz;
+      dram_period = tick_khz/dram_khz;
+      unsigned long long g = gcd_ull(gcd_ull(core_khz,icnt_khz),gcd_ull(l2_khz,dram_khz));
+      clock_hyperperiod = tick_khz/g;
+   } else {
+      // no common tick of reasonable size: use picoseconds, the periods are 
+      // rounded but still do not accumulate rounding errors
+      core_period = (unsigned long long) llround(1e9/core_khz);
+      icnt_period = (unsigned long long) llround(1e9/icnt_khz);
+      l2_period = (unsigned long long) llround(1e9/l2_khz);
+      dram_period = (unsigned long long) llround(1e9/dram_khz);
+      clock_hyperperiod = 0;
+   }
+
+   m_clock_schedule.clear();
+   if (clock_hyperperiod) {
+      unsigned long long n_edges = clock_hyperperiod/core_period + clock_hyperperiod/icnt_period
+                                 + clock_hyperperiod/l2_period + clock_hyperperiod/dram_period;
+      if (n_edges <= CLOCK_SCHEDULE_MAX_STEPS) {
+         core_time = icnt_time = l2_time = dram_time = 0;
+         do {
+            m_clock_schedule.push_back(clock_step());
+         } while (core_time || icnt_time || l2_time || dram_time);
+      }
+   }
+   m_clock_schedule_valid = true;
+   printf("GPGPU-Sim uArch: clock periods (ticks): %llu:%llu:%llu:%llu, %zu step schedule\n",
+          core_period, icnt_period, l2_period, dram_period, m_clock_schedule.size());
 }
 
 bool gpgpu_sim::active()
@@ -682,10 +930,32 @@ void gpgpu_sim::init()
 {
     // run a CUDA grid on the GPU microarchitecture simulator
     gpu_sim_cycle = 0;
+    bind_thread();
     gpu_sim_insn = 0;
     last_gpu_sim_insn = 0;
     m_total_cta_launched=0;
-
+    m_cores_skipping = false;
+    m_sample_phase = SAMPLE_DETAILED;
+    m_sample_window_ctas = 0;
+    m_sample_steady = false;
+    m_sample_running_ctas = 0;
+    m_sample_window_cycles = 0;
+    m_sample_window_done = 0;
+    m_sample_steady_cycles.clear();
+    m_sample_steady_ctas.clear();
+    m_sample_unsteady_windows = 0;
+    m_sample_detail_ctas = 0;
+    m_sample_ff_ctas = 0;
+    m_sample_ff_insn = 0;
+
+    for (unsigned i=0;i<m_dvfs_schedule.size();i++) {
+        const dvfs_point &p = m_dvfs_schedule[i];
+        if (p.grid == m_grids_simulated+1) {
+            printf("GPGPU-Sim uArch: DVFS: clock domains set to %.1f:%.1f:%.1f:%.1f MHz before grid %u\n", 
+                   p.core_mhz, p.icnt_mhz, p.l2_mhz, p.dram_mhz, p.grid);
+            set_clock_domains(p.core_mhz, p.icnt_mhz, p.l2_mhz, p.dram_mhz);
+        }
+    }
     reinit_clock_domains();
     set_param_gpgpu_num_shaders(m_config.num_shader());
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
@@ -708,6 +978,17 @@ void gpgpu_sim::init()
     if (g_network_mode)
        icnt_init();
 
+    if (m_config.gpgpu_timing_checkpoint_restore && m_grids_simulated+1 == m_config.gpgpu_timing_checkpoint_restore) {
+       if (m_config.gpgpu_warp_trace == WARP_TRACE_REPLAY) 
+          m_checkpoint_restore_pending = true; // possibly into the grid, see launch()
+       else
+          restore_checkpoint(m_config.gpgpu_timing_checkpoint_file, NULL);
+    } else if (checkpoint_prefix()) {
+       printf("GPGPU-Sim uArch: grid %u %s ahead of the timing checkpoint restored at grid %u\n", m_grids_simulated+1, 
+              m_config.gpgpu_warp_trace == WARP_TRACE_REPLAY ? "skipped" : "executed functionally", 
+              m_config.gpgpu_timing_checkpoint_restore);
+    }
+
     // McPAT initialization function. Called on first launch of GPU
 #ifdef GPGPUSIM_POWER_MODEL
     if(m_config.g_power_simulation_enabled){
@@ -719,7 +1000,204 @@ void gpgpu_sim::init()
 void gpgpu_sim::update_stats() {
     m_memory_stats->memlatstat_lat_pw();
     gpu_tot_sim_cycle += gpu_sim_cycle;
+    bind_thread();
     gpu_tot_sim_insn += gpu_sim_insn;
+    m_grids_simulated++;
+    if (m_config.gpgpu_timing_checkpoint_save && m_grids_simulated == m_config.gpgpu_timing_checkpoint_save) {
+       if (!m_config.gpgpu_timing_checkpoint_save_cycle) 
+          save_checkpoint(m_config.gpgpu_timing_checkpoint_file, NULL);
+       else if (!m_checkpoint_saved) 
+          printf("GPGPU-Sim uArch: WARNING ** grid %u completed before cycle %u, no timing checkpoint saved\n", 
+                 m_grids_simulated, m_config.gpgpu_timing_checkpoint_save_cycle);
+    }
+}
+
+// A checkpoint taken between grids is saved once every core has finished and 
+// the memory system and interconnect hold no request: what remains is the 
+// state that carries over from one grid to the next (caches, prefetcher and 
+// locality tables, DRAM banks, the scoreboards and all statistics).
+//
+// A checkpoint taken in the middle of a grid (-gpgpu_timing_checkpoint_save_cycle) 
+// also holds the CTAs, warps and pipelines of every core and the requests in 
+// flight in the caches, the memory partitions and the DRAM. Requests reached 
+// from several places are saved once and restored by their uid. Interconnect 
+// packets are not saved, so the checkpoint waits for a cycle with an empty 
+// interconnect. It needs warp trace replay: replayed warps have no functional 
+// thread state to save, their SIMT stacks are rebuilt from the trace, and the 
+// restore happens when the grid is launched, once its kernel is known.
+//
+// The functional state (device memory) is not part of the checkpoint, so the 
+// grids before the restored one still have to execute. They run functionally 
+// without the timing model (see checkpoint_prefix()), or are skipped under 
+// warp trace replay, which is where a restore saves its time; the timing state
+// they would have built is then replaced by the checkpoint.
+bool gpgpu_sim::checkpoint_prefix() const
+{
+    return m_config.gpgpu_timing_checkpoint_restore && 
+           m_grids_simulated+1 < m_config.gpgpu_timing_checkpoint_restore;
+}
+
+bool gpgpu_sim::drained() const
+{
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+       if( m_cluster[i]->get_not_completed()>0 ) 
+           return false;
+    for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+       if( m_memory_partition_unit[i]->busy() )
+           return false;
+    return !icnt_busy();
+}
+
+// Called at the end of each core cycle: saves the mid-grid checkpoint at the 
+// first cycle from -gpgpu_timing_checkpoint_save_cycle on where the 
+// interconnect is empty and no core is skipping cycles.
+void gpgpu_sim::try_mid_kernel_checkpoint()
+{
+    if (!m_config.gpgpu_timing_checkpoint_save_cycle || m_checkpoint_saved) 
+       return;
+    if (m_grids_simulated+1 != m_config.gpgpu_timing_checkpoint_save || 
+        gpu_sim_cycle < m_config.gpgpu_timing_checkpoint_save_cycle) 
+       return;
+    if (m_cores_skipping || icnt_busy()) 
+       return;
+    kernel_info_t *kernel = NULL;
+    for (unsigned n=0; n < m_running_kernels.size(); n++) {
+       if (m_running_kernels[n] == NULL || m_running_kernels[n]->done()) 
+          continue;
+       if (kernel) {
+          printf("GPGPU-Sim uArch: ERROR ** a timing checkpoint in the middle of a grid supports a single running kernel\n");
+          abort();
+       }
+       kernel = m_running_kernels[n];
+    }
+    if (kernel == NULL) 
+       return;
+    save_checkpoint(m_config.gpgpu_timing_checkpoint_file, kernel);
+    m_checkpoint_saved = true;
+}
+
+// kernel is the grid in flight for a mid-grid checkpoint, NULL between grids
+void gpgpu_sim::save_checkpoint( const char *filename, kernel_info_t *kernel )
+{
+    if (kernel == NULL && !drained()) {
+       printf("GPGPU-Sim uArch: ERROR ** cannot save timing checkpoint after grid %u: requests are still in flight\n", m_grids_simulated);
+       printf("GPGPU-Sim uArch:          (was the grid stopped by -gpgpu_max_cycle/-gpgpu_max_insn/-gpgpu_max_cta?)\n");
+       abort();
+    }
+    checkpoint_file cp(filename,true,this);
+    m_checkpoint_kernel = kernel;
+    checkpoint(cp);
+    m_checkpoint_kernel = NULL;
+    if (kernel) 
+       printf("GPGPU-Sim uArch: timing checkpoint saved to \"%s\" at cycle %lld of grid %u (gpu_tot_sim_cycle = %lld)\n", 
+              filename, gpu_sim_cycle, m_grids_simulated+1, gpu_tot_sim_cycle);
+    else
+       printf("GPGPU-Sim uArch: timing checkpoint saved to \"%s\" after grid %u (gpu_tot_sim_cycle = %lld)\n", 
+              filename, m_grids_simulated, gpu_tot_sim_cycle);
+}
+
+// kernel is the grid just launched when restoring under warp trace replay, 
+// which a mid-grid checkpoint is restored into
+void gpgpu_sim::restore_checkpoint( const char *filename, kernel_info_t *kernel )
+{
+    assert(drained());
+    checkpoint_file cp(filename,false,this);
+    m_checkpoint_kernel = kernel;
+    checkpoint(cp);
+    bool mid_kernel = m_checkpoint_kernel != NULL;
+    m_checkpoint_kernel = NULL;
+    bind_thread();
+    if (mid_kernel) 
+       printf("GPGPU-Sim uArch: timing checkpoint restored from \"%s\" at cycle %lld of grid %u (gpu_tot_sim_cycle = %lld)\n", 
+              filename, gpu_sim_cycle, m_grids_simulated+1, gpu_tot_sim_cycle);
+    else
+       printf("GPGPU-Sim uArch: timing checkpoint restored from \"%s\" before grid %u (gpu_tot_sim_cycle = %lld)\n", 
+              filename, m_grids_simulated+1, gpu_tot_sim_cycle);
+}
+
+void gpgpu_sim::checkpoint( checkpoint_file &cp )
+{
+    cp.section("gpgpu_sim");
+    cp.check_size(m_shader_config->n_simt_clusters,"SIMT clusters");
+    cp.check_size(m_shader_config->n_simt_cores_per_cluster,"SIMT cores per cluster");
+    cp.check_size(m_memory_config->m_n_mem,"memory partitions");
+    cp.check_size(m_memory_config->m_n_sub_partition_per_memory_channel,"sub partitions per channel");
+    // a checkpoint saved after grid n restores before grid n+1
+    cp.check_size(m_grids_simulated,"grids completed");
+    cp.pod(gpu_tot_sim_cycle);
+    cp.pod(gpu_tot_sim_insn);
+    cp.pod(gpu_tot_issued_cta);
+    cp.pod(gpu_stall_icnt2sh);
+    cp.pod(m_skipped_core_cycles);
+    cp.pod(m_last_cluster_issue);
+    // the next request uid is saved so that a restored run numbers its 
+    // requests exactly as the uninterrupted run did
+    cp.pod(m_next_mf_request_uid);
+    bool mid_kernel = m_checkpoint_kernel != NULL;
+    cp.pod(mid_kernel);
+    if (!cp.saving()) {
+       if (mid_kernel && m_checkpoint_kernel == NULL) {
+          printf("GPGPU-Sim uArch: ERROR ** timing checkpoint was saved in the middle of a grid, restoring it requires -gpgpu_warp_trace 2\n");
+          abort();
+       }
+       if (!mid_kernel) 
+          m_checkpoint_kernel = NULL;
+    }
+    if (mid_kernel) 
+       checkpoint_grid(cp);
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+       m_cluster[i]->checkpoint(cp);
+    for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+       m_memory_partition_unit[i]->checkpoint(cp);
+    m_shader_stats->checkpoint(cp);
+    m_memory_stats->checkpoint(cp);
+}
+
+// the progress of the grid in flight
+void gpgpu_sim::checkpoint_grid( checkpoint_file &cp )
+{
+    cp.section("grid");
+    kernel_info_t &kernel = *m_checkpoint_kernel;
+    std::string name = kernel.name();
+    cp.string(name);
+    if (name != kernel.name()) {
+       printf("GPGPU-Sim uArch: ERROR ** timing checkpoint was saved in kernel \'%s\', not \'%s\'\n", 
+              name.c_str(), kernel.name().c_str());
+       abort();
+    }
+    cp.check_size(kernel.get_uid(),"kernel launch uid");
+    cp.check_size(kernel.num_blocks(),"CTAs of the grid");
+    // CTAs are issued in increasing linear id order
+    unsigned issued = kernel.no_more_ctas_to_run() ? kernel.num_blocks() : 
+                      warp_trace_file::cta_id(kernel,kernel.get_next_cta_id());
+    cp.pod(issued);
+    if (!cp.saving()) {
+       for (unsigned i=0;i<issued;i++) 
+          kernel.increment_cta_id();
+    }
+    cp.pod(gpu_sim_cycle);
+    cp.pod(gpu_sim_insn);
+    cp.pod(last_gpu_sim_insn);
+    cp.pod(gpu_sim_insn_last_update);
+    cp.pod(gpu_sim_insn_last_update_sid);
+    cp.pod(m_total_cta_launched);
+    cp.pod(gpu_deadlock);
+    cp.pod(core_time);
+    cp.pod(icnt_time);
+    cp.pod(l2_time);
+    cp.pod(dram_time);
+    cp.pod(m_clock_schedule_pos);
+    cp.pod(m_last_issued_kernel);
+    cp.vector(m_executed_kernel_uids);
+    unsigned n_names = m_executed_kernel_names.size();
+    cp.pod(n_names);
+    m_executed_kernel_names.resize(n_names);
+    for (unsigned i=0;i<n_names;i++) 
+       cp.string(m_executed_kernel_names[i]);
+    bool has_trace = m_warp_traces.find(kernel.get_uid()) != m_warp_traces.end();
+    cp.pod(has_trace);
+    if (has_trace) 
+       warp_trace(kernel)->checkpoint(cp);
 }
 
 void gpgpu_sim::print_stats()
@@ -897,13 +1375,23 @@ void gpgpu_sim::gpu_print_stat()
 
 
    // performance counter for stalls due to congestion.
+   unsigned gpu_stall_dramfull = 0;
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+      gpu_stall_dramfull += m_memory_sub_partition[i]->get_stall_dramfull();
    printf("gpu_stall_dramfull = %d\n", gpu_stall_dramfull);
    printf("gpu_stall_icnt2sh    = %d\n", gpu_stall_icnt2sh );
+   if (m_config.gpgpu_skip_stalled_cycles) 
+      printf("gpu_skipped_core_cycles = %llu\n", m_skipped_core_cycles);
+   if (m_config.gpgpu_sample_detail_ctas) 
+      print_sample_stats(stdout);
 
    time_t curr_time;
    time(&curr_time);
    unsigned long long elapsed_time = MAX( curr_time - g_simulation_starttime, 1 );
    printf( "gpu_total_sim_rate=%u\n", (unsigned)( ( gpu_tot_sim_insn + gpu_sim_insn ) / elapsed_time ) );
+#ifdef GPGPUSIM_HOST_PROFILE
+   host_profiler::print( stdout, gpu_tot_sim_cycle + gpu_sim_cycle, gpu_tot_sim_insn + gpu_sim_insn );
+#endif
 
    //shader_print_l1_miss_stat( stdout );
    shader_print_cache_stats(stdout);
@@ -1046,9 +1534,11 @@ void shader_core_ctx::mem_instruction_stats(const warp_inst_t &inst)
  *  
  * @param kernel 
  *    object that tells us which kernel to ask for a CTA from 
+ * @return 
+ *    the hardware CTA slot the CTA was assigned to 
  */
 
-void shader_core_ctx::issue_block2core( kernel_info_t &kernel ) 
+unsigned shader_core_ctx::issue_block2core( kernel_info_t &kernel ) 
 {
     set_max_cta(kernel);
 
@@ -1081,16 +1571,36 @@ void shader_core_ctx::issue_block2core( kernel_info_t &kernel )
     // bind functional simulation state of threads to hardware resources (simulation) 
     warp_set_t warps;
     unsigned nthreads_in_block= 0;
-    for (unsigned i = start_thread; i<end_thread; i++) {
-        m_threadState[i].m_cta_id = free_cta_hw_id;
-        unsigned warp_id = i/m_config->warp_size;
-        nthreads_in_block += ptx_sim_init_thread(kernel,&m_thread[i],m_sid,i,cta_size-(i-start_thread),m_config->n_thread_per_shader,this,free_cta_hw_id,warp_id,m_cluster->get_gpu());
-        m_threadState[i].m_active = true; 
-        warps.set( warp_id );
+    unsigned trace_cta_id = warp_trace_file::cta_id(kernel,kernel.get_next_cta_id());
+    if( m_warp_trace_mode == WARP_TRACE_REPLAY ) {
+        // replayed threads have no functional state, only the hardware contexts are allocated
+        kernel.increment_cta_id();
+        for (unsigned i = start_thread; i<end_thread; i++) {
+            m_threadState[i].m_cta_id = free_cta_hw_id;
+            m_threadState[i].m_active = true; 
+            warps.set( i/m_config->warp_size );
+        }
+        nthreads_in_block = cta_size;
+    } else {
+        for (unsigned i = start_thread; i<end_thread; i++) {
+            m_threadState[i].m_cta_id = free_cta_hw_id;
+            unsigned warp_id = i/m_config->warp_size;
+            nthreads_in_block += ptx_sim_init_thread(kernel,&m_thread[i],m_sid,i,cta_size-(i-start_thread),m_config->n_thread_per_shader,this,free_cta_hw_id,warp_id,m_cluster->get_gpu());
+            m_threadState[i].m_active = true; 
+            warps.set( warp_id );
+        }
     }
     assert( nthreads_in_block > 0 && nthreads_in_block <= m_config->n_thread_per_shader); // should be at least one, but less than max
     m_cta_status[free_cta_hw_id]=nthreads_in_block;
 
+    if( m_warp_trace_mode != WARP_TRACE_OFF ) {
+        m_cta_trace_file[free_cta_hw_id] = m_gpu->warp_trace(kernel);
+        m_cta_trace_id[free_cta_hw_id] = trace_cta_id;
+        if( m_warp_trace_mode == WARP_TRACE_REPLAY ) 
+            m_cta_trace_file[free_cta_hw_id]->read_cta(trace_cta_id,&m_warp_trace[start_thread/m_config->warp_size],
+                                                       padded_cta_size/m_config->warp_size);
+    }
+
     // now that we know which warps are used in this CTA, we can allocate
     // resources for use in CTA-wide barrier operations
     m_barriers.allocate_barrier(free_cta_hw_id,warps);
@@ -1102,6 +1612,7 @@ void shader_core_ctx::issue_block2core( kernel_info_t &kernel )
     shader_CTA_count_log(m_sid, 1);
     /*cory*/
     //printf("GPGPU-Sim uArch: core:%3d, cta:%2u initialized @(%lld,%lld)\n", m_sid, free_cta_hw_id, gpu_sim_cycle, gpu_tot_sim_cycle );
+    return free_cta_hw_id;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -1116,53 +1627,467 @@ void dram_t::dram_log( int task )
 }
 
 //Find next clock domain and increment its time
-int gpgpu_sim::next_clock_domain(void) 
+int gpgpu_sim::clock_step(void) 
 {
-   double smallest = min3(core_time,icnt_time,dram_time);
+   unsigned long long smallest = min3(core_time,icnt_time,dram_time);
    int mask = 0x00;
    if ( l2_time <= smallest ) {
       smallest = l2_time;
       mask |= L2 ;
-      l2_time += m_config.l2_period;
+      l2_time += l2_period;
    }
    if ( icnt_time <= smallest ) {
       mask |= ICNT;
-      icnt_time += m_config.icnt_period;
+      icnt_time += icnt_period;
    }
    if ( dram_time <= smallest ) {
       mask |= DRAM;
-      dram_time += m_config.dram_period;
+      dram_time += dram_period;
    }
    if ( core_time <= smallest ) {
       mask |= CORE;
-      core_time += m_config.core_period;
+      core_time += core_period;
+   }
+   if ( clock_hyperperiod && core_time >= clock_hyperperiod && icnt_time >= clock_hyperperiod 
+        && l2_time >= clock_hyperperiod && dram_time >= clock_hyperperiod ) {
+      core_time -= clock_hyperperiod;
+      icnt_time -= clock_hyperperiod;
+      l2_time -= clock_hyperperiod;
+      dram_time -= clock_hyperperiod;
    }
    return mask;
 }
 
+// mask of the next next_clock_domain() call, without advancing the clocks
+int gpgpu_sim::peek_clock_domain(void) 
+{
+   if (!m_clock_schedule.empty()) 
+      return m_clock_schedule[m_clock_schedule_pos];
+   unsigned long long saved[4] = { core_time, icnt_time, l2_time, dram_time };
+   int mask = clock_step();
+   core_time = saved[0];
+   icnt_time = saved[1];
+   l2_time = saved[2];
+   dram_time = saved[3];
+   return mask;
+}
+
+int gpgpu_sim::next_clock_domain(void) 
+{
+   if (m_clock_schedule.empty()) 
+      return clock_step();
+   int mask = m_clock_schedule[m_clock_schedule_pos];
+   if (++m_clock_schedule_pos == m_clock_schedule.size()) 
+      m_clock_schedule_pos = 0;
+   return mask;
+}
+
 void gpgpu_sim::issue_block2core()
 {
+    if (checkpoint_prefix()) {
+        if (m_config.gpgpu_warp_trace != WARP_TRACE_REPLAY) {
+            fast_forward(~0u,false);
+            return;
+        }
+        // replayed grids have no functional effect, their CTAs are dropped
+        kernel_info_t *kernel;
+        while ((kernel = select_kernel()) != NULL) {
+            while (!kernel->no_more_ctas_to_run()) {
+                kernel->increment_cta_id();
+                m_total_cta_launched++;
+            }
+            if (!kernel->running()) 
+                set_kernel_done(kernel);
+        }
+        return;
+    }
+    bool sampling = m_config.gpgpu_sample_detail_ctas != 0;
+    if (sampling && m_sample_phase != SAMPLE_DETAILED) 
+        return;
     unsigned last_issued = m_last_cluster_issue; 
     for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+        if (sampling && m_sample_window_ctas == m_config.gpgpu_sample_detail_ctas) 
+            break;
         unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
         unsigned num = m_cluster[idx]->issue_block2core();
         if( num ) {
             m_last_cluster_issue=idx;
             m_total_cta_launched += num;
+            if (sampling) {
+                m_sample_running_ctas += num;
+                m_sample_window_ctas += num;
+                m_sample_detail_ctas += num;
+            }
+        }
+    }
+}
+
+// Sampled simulation: CTAs are simulated in detail in windows of 
+// -gpgpu_sample_detail_ctas CTAs, each followed by -gpgpu_sample_ff_ctas CTAs 
+// executed functionally in zero time, warming the caches for the next window. 
+// Functional execution needs idle cores, so each window is drained first. 
+// Only the steady state of a window is measured: from the cycle every core 
+// first runs as many CTAs as it can hold until the window's last CTA is 
+// issued, counting the cycles and the CTAs that complete in between. The 
+// ramp-up before full occupancy and the drain are left out, so a window only 
+// gives a sample if it holds more CTAs than the GPU runs concurrently. The 
+// partial window at the end of the grid is measured like the others.
+void gpgpu_sim::sample_cycle()
+{
+    unsigned running = 0;
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        running += m_cluster[i]->get_n_active_cta();
+    if (m_sample_steady) {
+        m_sample_window_cycles++;
+        m_sample_window_done += m_sample_running_ctas - running;
+    }
+    m_sample_running_ctas = running;
+
+    if (m_sample_phase == SAMPLE_DETAILED) {
+        if (m_sample_window_ctas < m_config.gpgpu_sample_detail_ctas && get_more_cta_left()) {
+            if (!m_sample_steady) {
+                bool full = true;
+                for (unsigned i=0;i<m_shader_config->n_simt_clusters && full;i++) 
+                    full = m_cluster[i]->fully_occupied();
+                m_sample_steady = full;
+            }
+            return;
+        }
+        if (m_sample_window_ctas == 0) 
+            return; // nothing left to issue, the grid is finishing
+        m_sample_phase = SAMPLE_DRAIN;
+        m_sample_steady = false;
+    }
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        if (m_cluster[i]->get_not_completed()) 
+            return;
+    if (m_sample_window_done) {
+        m_sample_steady_cycles.push_back(m_sample_window_cycles);
+        m_sample_steady_ctas.push_back(m_sample_window_done);
+    } else {
+        m_sample_unsteady_windows++;
+    }
+    m_sample_ff_ctas += fast_forward(m_config.gpgpu_sample_ff_ctas,true);
+    m_sample_phase = SAMPLE_DETAILED;
+    m_sample_window_ctas = 0;
+    m_sample_window_cycles = 0;
+    m_sample_window_done = 0;
+}
+
+// executes up to max_ctas CTAs functionally in zero time, returns how many
+unsigned gpgpu_sim::fast_forward( unsigned max_ctas, bool warm )
+{
+    unsigned n = 0;
+    while (n < max_ctas && get_more_cta_left()) {
+        unsigned issued = 0;
+        unsigned last_issued = m_last_cluster_issue; 
+        for (unsigned i=0;i<m_shader_config->n_simt_clusters && n < max_ctas;i++) {
+            unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
+            unsigned num = m_cluster[idx]->issue_block2core(&m_sample_ff_insn,warm);
+            m_cluster[idx]->merge_deferred();
+            if( num ) {
+                m_last_cluster_issue=idx;
+                m_total_cta_launched += num;
+                issued += num;
+                n += num;
+            }
         }
+        if (!issued) 
+            break; // no core can take a CTA of the remaining kernels
     }
+    return n;
+}
+
+// The cycles per CTA is the ratio estimator over the measured windows: the 
+// total steady-state cycles over the total CTAs completed in them, so windows 
+// weigh by their CTAs. Its 95% confidence interval uses the ratio estimator's 
+// variance across windows with Student t quantiles. The grid is extrapolated 
+// as that throughput times all its CTAs, detailed and fast-forwarded alike.
+void gpgpu_sim::print_sample_stats( FILE *fout ) const
+{
+    // two-sided 95% Student t quantiles for 1..30 degrees of freedom
+    static const double t95[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    unsigned n = m_sample_steady_cycles.size();
+    double sum_cycles = 0, sum_ctas = 0;
+    for (unsigned i=0;i<n;i++) {
+        sum_cycles += m_sample_steady_cycles[i];
+        sum_ctas += m_sample_steady_ctas[i];
+    }
+    double ratio = n? sum_cycles / sum_ctas : 0;
+    double half_width = 0; // of the 95% confidence interval of the ratio
+    if (n > 1) {
+        double var = 0;
+        for (unsigned i=0;i<n;i++) {
+            double r = m_sample_steady_cycles[i] - ratio * m_sample_steady_ctas[i];
+            var += r * r;
+        }
+        double mean_ctas = sum_ctas / n;
+        var /= (n - 1) * n * mean_ctas * mean_ctas;
+        half_width = ((n-1 <= 30)? t95[n-2] : 1.960) * sqrt(var);
+    }
+    double ctas = m_sample_detail_ctas + m_sample_ff_ctas;
+    double cycles = ratio * ctas;
+    double margin = half_width * ctas;
+    fprintf(fout, "gpu_sample_windows = %u\n", n);
+    fprintf(fout, "gpu_sample_windows_unsteady = %u\n", m_sample_unsteady_windows);
+    fprintf(fout, "gpu_sample_steady_cycles = %.0f\n", sum_cycles);
+    fprintf(fout, "gpu_sample_steady_ctas = %.0f\n", sum_ctas);
+    fprintf(fout, "gpu_sample_detail_ctas = %llu\n", m_sample_detail_ctas);
+    fprintf(fout, "gpu_sample_ff_ctas = %llu\n", m_sample_ff_ctas);
+    fprintf(fout, "gpu_sample_ff_insn = %llu\n", m_sample_ff_insn);
+    if (!n) {
+        fprintf(fout, "gpu_sim_cycle_extrapolated = n/a (no window reached full occupancy, raise -gpgpu_sample_detail_ctas)\n");
+        return;
+    }
+    fprintf(fout, "gpu_sample_cycles_per_cta = %.2f (+/- %.2f)\n", ratio, half_width);
+    fprintf(fout, "gpu_sim_cycle_extrapolated = %.0f\n", cycles);
+    if (n > 1) 
+        fprintf(fout, "gpu_sim_cycle_extrapolated_ci95 = [%.0f, %.0f]\n", MAX(cycles - margin, 0.0), cycles + margin);
+    else 
+        fprintf(fout, "gpu_sim_cycle_extrapolated_ci95 = n/a (fewer than 2 windows)\n");
+    fprintf(fout, "gpu_sample_ci_method = ratio estimator over windows (steady-state cycles / CTAs completed), Student t 95%%, scaled by %.0f CTAs\n", ctas);
+    fprintf(fout, "gpu_ipc_extrapolated = %12.4f\n", (gpu_sim_insn + m_sample_ff_insn) / cycles);
+}
+
+void gpgpu_sim::warm_l2( mem_fetch *mf )
+{
+    m_memory_sub_partition[mf->get_sub_partition_id()]->warm(mf);
+}
+
+void gpgpu_sim::bind_thread()
+{
+    ::gpu_sim_cycle = gpu_sim_cycle;
+    ::gpu_tot_sim_cycle = gpu_tot_sim_cycle;
+    icnt_bind(m_icnt);
+    stat_tool_bind(m_stat_tool);
+}
+
+void gpgpu_sim::cluster_icnt_cycle_task( void *ctx, unsigned i )
+{
+    gpgpu_sim *gpu = (gpgpu_sim*) ctx;
+    gpu->bind_thread();
+    gpu->m_cluster[i]->icnt_cycle();
+}
+
+void gpgpu_sim::cluster_core_cycle_task( void *ctx, unsigned i )
+{
+    gpgpu_sim *gpu = (gpgpu_sim*) ctx;
+    gpu->bind_thread();
+    if (gpu->m_cluster_stepped[i]) 
+        gpu->m_cluster[i]->core_cycle();
+    gpu->functional_turn_done(i);
+}
+
+// The pool runs each thread's clusters in increasing order, so the lowest 
+// cluster still in its core cycle never waits and the handoff cannot deadlock.
+void gpgpu_sim::functional_lock_ordered( unsigned cluster_id )
+{
+    if (!m_thread_pool) 
+        return;
+    pthread_mutex_lock(&m_functional_mutex);
+    while (m_functional_turn < cluster_id) 
+        pthread_cond_wait(&m_functional_turn_cond,&m_functional_mutex);
 }
 
-unsigned long long g_single_step=0; // set this in gdb to single step the pipeline
+void gpgpu_sim::functional_turn_done( unsigned cluster_id )
+{
+    pthread_mutex_lock(&m_functional_mutex);
+    m_cluster_cycle_done[cluster_id] = true;
+    unsigned n = m_shader_config->n_simt_clusters;
+    while (m_functional_turn < n && m_cluster_cycle_done[m_functional_turn]) 
+        m_functional_turn++;
+    pthread_cond_broadcast(&m_functional_turn_cond);
+    pthread_mutex_unlock(&m_functional_mutex);
+}
+
+void gpgpu_sim::partition_dram_cycle_task( void *ctx, unsigned i )
+{
+    gpgpu_sim *gpu = (gpgpu_sim*) ctx;
+    gpu->bind_thread();
+    gpu->m_memory_partition_unit[i]->dram_cycle(); // Issue the dram command (scheduler + delay model)
+    gpu->partition_power_stats(i);
+}
+
+// Update performance counters for DRAM
+void gpgpu_sim::partition_power_stats( unsigned i )
+{
+    m_memory_partition_unit[i]->set_dram_power_stats(m_power_stats->pwr_mem_stat->n_cmd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_activity[CURRENT_STAT_IDX][i],
+                   m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
+                   m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
+}
+
+void gpgpu_sim::sub_partition_cache_cycle_task( void *ctx, unsigned i )
+{
+    gpgpu_sim *gpu = (gpgpu_sim*) ctx;
+    gpu->bind_thread();
+    gpu->m_memory_sub_partition[i]->cache_cycle(gpu->gpu_sim_cycle+gpu->gpu_tot_sim_cycle);
+}
+
+void gpgpu_sim::cluster_icnt_cycle_all()
+{
+    m_thread_pool->parallel_for(m_shader_config->n_simt_clusters, cluster_icnt_cycle_task, this);
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        m_cluster[i]->merge_deferred();
+}
+
+void gpgpu_sim::cluster_core_cycle_all()
+{
+    // Select the clusters to step before any of them runs. Neither condition can 
+    // be changed by another cluster's core_cycle(): CTAs are only issued by 
+    // issue_block2core() and a finished kernel has no CTAs left.
+    bool more_cta_left = get_more_cta_left();
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        m_cluster_stepped[i] = m_cluster[i]->get_not_completed() || more_cta_left;
+    // hand functional execution from cluster to cluster in index order
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        m_cluster_cycle_done[i] = false;
+    m_functional_turn = 0;
+    m_thread_pool->parallel_for(m_shader_config->n_simt_clusters, cluster_core_cycle_task, this);
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+        m_cluster[i]->merge_deferred();
+}
+
+// The pipeline of a stalled SIMT core only updates statistics and round-robin 
+// state every cycle, so once every core that would be stepped is quiescent 
+// (see shader_core_ctx::quiescent()) core_cycle() is replaced by the much 
+// cheaper skip_cycle(). The memory system is still simulated every cycle 
+// unless it is only waiting too (see skip_to_next_event()); skipping stops 
+// when a response reaches a stepped cluster or CTAs are issued.
+void gpgpu_sim::update_core_skipping()
+{
+    if (m_cores_skipping) {
+        if (m_total_cta_launched != m_skip_cta_launched) 
+            m_cores_skipping = false;
+        return;
+    }
+    bool more_cta_left = get_more_cta_left();
+    bool any_stepped = false;
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+        m_cluster_stepped[i] = m_cluster[i]->get_not_completed() || more_cta_left;
+        if (!m_cluster_stepped[i]) 
+            continue;
+        if (!m_cluster[i]->quiescent()) 
+            return;
+        any_stepped = true;
+    }
+    if (!any_stepped) 
+        return;
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+        if (m_cluster_stepped[i]) 
+            m_cluster[i]->begin_skip();
+    }
+    m_cores_skipping = true;
+    m_skip_more_cta_left = more_cta_left;
+    m_skip_cta_launched = m_total_cta_launched;
+}
+
+bool gpgpu_sim::skipped_cores_woken() const
+{
+    if (get_more_cta_left() != m_skip_more_cta_left) 
+        return true; // a kernel was launched
+    for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+        if (m_cluster_stepped[i] && !m_cluster[i]->response_fifo_empty()) 
+            return true; // icnt_cycle() hands a response to one of the cores
+    }
+    return false;
+}
+
+// While the cores are skipped, the memory system can also be only waiting: 
+// requests sit in the ROP and DRAM latency queues until a fixed ready cycle 
+// and the DRAM channels until their bank timers expire, with nothing in the 
+// interconnect. Stepping any domain then only counts down, so all clocks are 
+// advanced at once to the earliest of these events. The core cycle that 
+// reaches a periodic check (statistics sample, deadlock detection) is 
+// simulated normally, which bounds the jump when nothing is pending. 
+void gpgpu_sim::skip_to_next_event()
+{
+   if (m_config.gpgpu_sample_detail_ctas || m_config.gpgpu_cflog_interval || m_config.g_power_simulation_enabled 
+       || m_config.gpgpu_flush_l1_cache || m_config.gpgpu_flush_l2_cache || g_interactive_debugger_enabled || m_single_step) 
+      return;
+   if (::icnt_busy() || skipped_cores_woken()) 
+      return; // packets in flight
+   unsigned long long ready_cycle = ~0ULL; 
+   unsigned dram_cycles = ~0u;
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+      if (!m_memory_sub_partition[i]->waiting(ready_cycle)) 
+         return;
+   }
+   for (unsigned i=0;i<m_memory_config->m_n_mem;i++) {
+      if (!m_memory_partition_unit[i]->waiting(ready_cycle,dram_cycles)) 
+         return;
+   }
+   if (ready_cycle <= gpu_sim_cycle+gpu_tot_sim_cycle) 
+      return;
+
+   unsigned long long n_dram = 0;
+   while (gpu_sim_cycle+gpu_tot_sim_cycle < ready_cycle) {
+      int mask = peek_clock_domain();
+      if ((mask & DRAM) && n_dram == dram_cycles) 
+         break;
+      if ((mask & CORE) && (!((gpu_sim_cycle+1) % m_config.gpu_stat_sample_freq) || !((gpu_sim_cycle+1) % 20000))) 
+         break;
+      next_clock_domain();
+      if (mask & DRAM) {
+         for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+            m_memory_partition_unit[i]->skip_dram_cycle();
+         n_dram++;
+      }
+      if (mask & L2) {
+         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+            m_memory_sub_partition[i]->skip_cache_cycle();
+      }
+      // an idle interconnect is not stepped
+      if (mask & CORE) {
+         m_skipped_core_cycles++;
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+            if (m_cluster_stepped[i]) {
+               m_cluster[i]->skip_cycle();
+               *active_sms+=m_cluster[i]->get_n_active_sms();
+            }
+         }
+         float temp=0;
+         for (unsigned i=0;i<m_shader_config->num_shader();i++)
+            temp+=m_shader_stats->m_pipeline_duty_cycle[i];
+         *average_pipeline_duty_cycle=((*average_pipeline_duty_cycle)+temp/m_shader_config->num_shader());
+         gpu_sim_cycle++;
+      }
+   }
+   ::gpu_sim_cycle = gpu_sim_cycle;
+
+   // power model counters as left by the last cycle of each domain
+   m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+   for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
+      m_cluster[i]->get_icnt_stats(m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
+      m_cluster[i]->get_cache_stats(m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
+   }
+   m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
+   for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) 
+      m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+   for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+      partition_power_stats(i);
+}
 
 void gpgpu_sim::cycle()
 {
+   bind_thread();
    int clock_mask = next_clock_domain();
+#ifdef GPGPUSIM_HOST_PROFILE
+   host_profiler::begin_step(gpu_sim_cycle, m_config.gpgpu_host_profile_interval, (clock_mask & CORE) != 0);
+#endif
+   HOST_PROFILE_SCOPE(HOST_PROF_CYCLE);
 
    if (clock_mask & CORE ) {
+      if (m_cores_skipping && skipped_cores_woken()) 
+         m_cores_skipping = false;
        // shader core loading (pop from ICNT into core) follows CORE clock
-      for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
-         m_cluster[i]->icnt_cycle(); 
+      if (m_thread_pool) {
+         cluster_icnt_cycle_all();
+      } else {
+         for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) 
+            m_cluster[i]->icnt_cycle(); 
+      }
    }
     if (clock_mask & ICNT) {
         // pop from memory controller to interconnect
@@ -1186,12 +2111,14 @@ void gpgpu_sim::cycle()
     }
 
    if (clock_mask & DRAM) {
-      for (unsigned i=0;i<m_memory_config->m_n_mem;i++){
-         m_memory_partition_unit[i]->dram_cycle(); // Issue the dram command (scheduler + delay model)
-         // Update performance counters for DRAM
-         m_memory_partition_unit[i]->set_dram_power_stats(m_power_stats->pwr_mem_stat->n_cmd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_activity[CURRENT_STAT_IDX][i],
-                        m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
-                        m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i], m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
+      // each partition only writes its own power counters
+      if (m_thread_pool) {
+         m_thread_pool->parallel_for(m_memory_config->m_n_mem, partition_dram_cycle_task, this);
+         for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+            m_memory_partition_unit[i]->merge_deferred();
+      } else {
+         for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
+            partition_dram_cycle_task(this,i);
       }
    }
 
@@ -1202,25 +2129,52 @@ void gpgpu_sim::cycle()
           //move memory request from interconnect into memory partition (if not backed up)
           //Note:This needs to be called in DRAM clock domain if there is no L2 cache in the system
           if ( m_memory_sub_partition[i]->full() ) {
-             gpu_stall_dramfull++;
+             m_memory_sub_partition[i]->count_stall_dramfull();
           } else {
               mem_fetch* mf = (mem_fetch*) icnt_pop( m_shader_config->mem2device(i) );
               m_memory_sub_partition[i]->push( mf, gpu_sim_cycle + gpu_tot_sim_cycle );
           }
-          m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
-          m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+          if (!m_thread_pool) {
+             m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle+gpu_tot_sim_cycle);
+             m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+          }
        }
+      if (m_thread_pool) {
+         // the interconnect is shared, so requests are moved into the sub 
+         // partitions above before their L2 caches are stepped concurrently
+         m_thread_pool->parallel_for(m_memory_config->m_n_mem_sub_partition, sub_partition_cache_cycle_task, this);
+         for (unsigned i=0;i<m_memory_config->m_n_mem_sub_partition;i++) {
+            m_memory_sub_partition[i]->merge_deferred();
+            m_memory_sub_partition[i]->accumulate_L2cache_stats(m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+         }
+      }
    }
 
    if (clock_mask & ICNT) {
+      HOST_PROFILE_SCOPE(HOST_PROF_ICNT);
       icnt_transfer();
    }
 
    if (clock_mask & CORE) {
       // L1 cache + shader core pipeline stages
       m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+      if (m_cores_skipping) 
+         m_skipped_core_cycles++;
+      else if (m_thread_pool) 
+         cluster_core_cycle_all();
       for (unsigned i=0;i<m_shader_config->n_simt_clusters;i++) {
-         if (m_cluster[i]->get_not_completed() || get_more_cta_left() ) {
+         if (m_cores_skipping) {
+            // every stepped core is stalled, see update_core_skipping()
+            if (m_cluster_stepped[i]) {
+               m_cluster[i]->skip_cycle();
+               m_cluster[i]->merge_deferred();
+               *active_sms+=m_cluster[i]->get_n_active_sms();
+            }
+         } else if (m_thread_pool) {
+            // already stepped by cluster_core_cycle_all()
+            if (m_cluster_stepped[i]) 
+               *active_sms+=m_cluster[i]->get_n_active_sms();
+         } else if (m_cluster[i]->get_not_completed() || get_more_cta_left() ) {
                m_cluster[i]->core_cycle();
                *active_sms+=m_cluster[i]->get_n_active_sms();
          }
@@ -1237,10 +2191,11 @@ void gpgpu_sim::cycle()
         //cout<<"Average pipeline duty cycle: "<<*average_pipeline_duty_cycle<<endl;
 
 
-      if( g_single_step && ((gpu_sim_cycle+gpu_tot_sim_cycle) >= g_single_step) ) {
+      if( m_single_step && ((gpu_sim_cycle+gpu_tot_sim_cycle) >= m_single_step) ) {
           asm("int $03");
       }
       gpu_sim_cycle++;
+      ::gpu_sim_cycle = gpu_sim_cycle;
       if( g_interactive_debugger_enabled ) 
          gpgpu_debug();
 
@@ -1251,7 +2206,11 @@ void gpgpu_sim::cycle()
       }
 #endif
 
+      if (m_config.gpgpu_sample_detail_ctas) 
+         sample_cycle();
       issue_block2core();
+      if (m_config.gpgpu_skip_stalled_cycles) 
+         update_core_skipping();
       
       // Depending on configuration, flush the caches once all of threads are completed.
       int all_threads_complete = 1;
@@ -1312,6 +2271,7 @@ void gpgpu_sim::cycle()
             if (m_config.gpu_runtime_stat_flag & GPU_RSTAT_BW_STAT) {
                for (unsigned i=0;i<m_memory_config->m_n_mem;i++) 
                   m_memory_partition_unit[i]->print_stat(stdout);
+               m_memory_stats->reduce_shards();
                printf("maxmrqlatency = %d \n", m_memory_stats->max_mrq_latency);
                printf("maxmflatency = %d \n", m_memory_stats->max_mf_latency);
             }
@@ -1321,6 +2281,10 @@ void gpgpu_sim::cycle()
                shader_print_l1_miss_stat( stdout );
             if (m_config.gpu_runtime_stat_flag & GPU_RSTAT_SCHED) 
                shader_print_scheduler_stat( stdout, false );
+#ifdef GPGPUSIM_HOST_PROFILE
+            if (m_config.gpu_runtime_stat_flag & GPU_RSTAT_HOST_PROF) 
+               host_profiler::print( stdout, gpu_tot_sim_cycle + gpu_sim_cycle, gpu_tot_sim_insn + gpu_sim_insn );
+#endif
          }
       }
 
@@ -1334,6 +2298,9 @@ void gpgpu_sim::cycle()
       }
       try_snap_shot(gpu_sim_cycle);
       spill_log_to_file (stdout, 0, gpu_sim_cycle);
+      try_mid_kernel_checkpoint();
+      if (m_cores_skipping) 
+         skip_to_next_event();
    }
 }
 
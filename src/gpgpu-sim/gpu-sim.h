@@ -36,7 +36,9 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <map>
 #include <stdio.h>
+#include <pthread.h>
 
 
 
@@ -48,6 +50,7 @@
 #define GPU_RSTAT_L1MISS 0x10
 #define GPU_RSTAT_PDOM 0x20
 #define GPU_RSTAT_SCHED 0x40
+#define GPU_RSTAT_HOST_PROF 0x80
 #define GPU_MEMLATSTAT_MC 0x2
 
 // constants for configuring merging of coalesced scatter-gather requests
@@ -273,8 +276,10 @@ struct memory_config {
 };
 
 // global counters and flags (please try not to add to this list!!!)
-extern unsigned long long  gpu_sim_cycle;
-extern unsigned long long  gpu_tot_sim_cycle;
+// per-thread copies of the cycle counters of the gpgpu_sim stepping on this 
+// thread, for the functional simulator, debugger and stream manager
+extern __thread unsigned long long  gpu_sim_cycle;
+extern __thread unsigned long long  gpu_tot_sim_cycle;
 extern bool g_interactive_debugger_enabled;
 
 class gpgpu_sim_config : public power_config, public gpgpu_functional_sim_config {
@@ -314,23 +319,26 @@ public:
     unsigned num_shader() const { return m_shader_config.num_shader(); }
     unsigned num_cluster() const { return m_shader_config.n_simt_clusters; }
     unsigned get_max_concurrent_kernel() const { return max_concurrent_kernel; }
+    unsigned get_sim_threads() const { return gpgpu_sim_threads; }
 
 private:
     void init_clock_domains(void ); 
+    // frequencies in MHz, called by gpgpu_sim::set_clock_domains() on a DVFS change
+    void set_clock_domains( double core_mhz, double icnt_mhz, double l2_mhz, double dram_mhz ) const;
 
 
     bool m_valid;
     shader_core_config m_shader_config;
     memory_config m_memory_config;
-    // clock domains - frequency
-    double core_freq;
-    double icnt_freq;
-    double dram_freq;
-    double l2_freq;
-    double core_period;
-    double icnt_period;
-    double dram_period;
-    double l2_period;
+    // clock domains - frequency, changed at run time by -gpgpu_dvfs_schedule
+    mutable double core_freq;
+    mutable double icnt_freq;
+    mutable double dram_freq;
+    mutable double l2_freq;
+    mutable double core_period;
+    mutable double icnt_period;
+    mutable double dram_period;
+    mutable double l2_period;
 
     // GPGPU-Sim timing model options
     unsigned gpu_max_cycle_opt;
@@ -343,7 +351,19 @@ private:
     int   gpgpu_frfcfs_dram_sched_queue_size; 
     int   gpgpu_cflog_interval;
     char * gpgpu_clock_domains;
+    char * gpgpu_dvfs_schedule;
     unsigned max_concurrent_kernel;
+    unsigned gpgpu_sim_threads; // host threads used to step SIMT clusters
+    bool gpgpu_skip_stalled_cycles; // skip core cycles while every core waits for memory
+    char *gpgpu_timing_checkpoint_file;
+    unsigned gpgpu_timing_checkpoint_save;    // save after this grid completes (0 = never)
+    unsigned gpgpu_timing_checkpoint_save_cycle; // or at this cycle of it (0 = after the grid)
+    unsigned gpgpu_timing_checkpoint_restore; // restore before this grid starts (0 = never)
+    unsigned gpgpu_sample_detail_ctas; // CTAs per detailed window of sampled simulation (0 = off)
+    unsigned gpgpu_sample_ff_ctas;     // CTAs fast-forwarded functionally after each window
+    unsigned gpgpu_warp_trace;         // enum warp_trace_mode
+    char *gpgpu_warp_trace_file;
+    unsigned gpgpu_host_profile_interval; // time every n-th core cycle (PROFILE=1 builds)
 
     // visualizer
     bool  g_visualizer_enabled;
@@ -372,6 +392,10 @@ public:
    bool can_start_kernel();
    unsigned finished_kernel();
    void set_kernel_done( kernel_info_t *kernel );
+   // trace file of a kernel launch (-gpgpu_warp_trace)
+   class warp_trace_file *warp_trace( const kernel_info_t &kernel );
+   // the grid a mid-kernel timing checkpoint is being saved from or restored into
+   kernel_info_t *checkpoint_kernel() const { return m_checkpoint_kernel; }
 
    void init();
    void cycle();
@@ -393,7 +417,28 @@ public:
    bool get_more_cta_left() const;
    kernel_info_t *select_kernel();
 
+   // serialize accesses to the (shared, non thread-safe) functional model and
+   // interconnect while clusters are stepped by multiple host threads
+   void functional_lock() { if (m_thread_pool) pthread_mutex_lock(&m_functional_mutex); }
+   void functional_unlock() { if (m_thread_pool) pthread_mutex_unlock(&m_functional_mutex); }
+   // functional_lock() for work whose order is visible (instruction execution, 
+   // trace writes): waits until every lower numbered cluster has finished its 
+   // core cycle, so clusters execute in the order of the single threaded loop
+   void functional_lock_ordered( unsigned cluster_id );
+   void icnt_lock() { if (m_thread_pool) pthread_mutex_lock(&m_icnt_mutex); }
+   void icnt_unlock() { if (m_thread_pool) pthread_mutex_unlock(&m_icnt_mutex); }
+   // L2 tag update for an access of a fast-forwarded CTA (see functional_execute_cta())
+   void warm_l2( class mem_fetch *mf );
+   // request uids are numbered per simulator instance (see mem_fetch::assign_request_uid())
+   unsigned next_mf_request_uid() { return m_next_mf_request_uid++; }
+   // point the calling thread's interconnect, loggers and cycle copies at this instance
+   void bind_thread();
+
    const gpgpu_sim_config &get_config() const { return m_config; }
+   // DVFS: change the clock domain frequencies (in MHz); takes effect immediately 
+   // and restarts the clock schedule as at the start of a kernel. Called by 
+   // init() for the grids listed in -gpgpu_dvfs_schedule.
+   void set_clock_domains( double core_mhz, double icnt_mhz, double l2_mhz, double dram_mhz );
    void gpu_print_stat();
    void dump_pipeline( int mask, int s, int m ) const;
 
@@ -423,7 +468,10 @@ public:
 private:
    // clocks
    void reinit_clock_domains(void);
+   void build_clock_schedule(void);
+   int  clock_step(void);
    int  next_clock_domain(void);
+   int  peek_clock_domain(void);
    void issue_block2core();
    void print_dram_stats(FILE *fout) const;
    void shader_print_runtime_stat( FILE *fout );
@@ -435,9 +483,67 @@ private:
 
    void gpgpu_debug();
 
+   // multi-threaded cluster stepping (-gpgpu_sim_threads)
+   void cluster_icnt_cycle_all();
+   void cluster_core_cycle_all();
+   static void cluster_icnt_cycle_task( void *ctx, unsigned i );
+   static void cluster_core_cycle_task( void *ctx, unsigned i );
+   void functional_turn_done( unsigned cluster_id );
+   static void partition_dram_cycle_task( void *ctx, unsigned i );
+   void partition_power_stats( unsigned i );
+   static void sub_partition_cache_cycle_task( void *ctx, unsigned i );
+
+   // skipping core cycles while all cores are stalled (-gpgpu_skip_stalled_cycles)
+   void update_core_skipping();
+   bool skipped_cores_woken() const;
+   void skip_to_next_event();
+
+   // timing state checkpoints taken between grids or, under warp trace 
+   // replay, in the middle of one (-gpgpu_timing_checkpoint_*)
+   bool drained() const;
+   void save_checkpoint( const char *filename, kernel_info_t *kernel );
+   void restore_checkpoint( const char *filename, kernel_info_t *kernel );
+   void checkpoint( class checkpoint_file &cp );
+   bool checkpoint_prefix() const;
+   void checkpoint_grid( class checkpoint_file &cp );
+   void try_mid_kernel_checkpoint();
+
+   // sampled simulation (-gpgpu_sample_detail_ctas/-gpgpu_sample_ff_ctas)
+   void sample_cycle();
+   unsigned fast_forward( unsigned max_ctas, bool warm );
+   void print_sample_stats( FILE *fout ) const;
+
 ///// data /////
 
    class simt_core_cluster **m_cluster;
+   class sim_thread_pool *m_thread_pool; // NULL when stepping single-threaded
+   pthread_mutex_t m_functional_mutex;
+   pthread_cond_t m_functional_turn_cond;
+   unsigned m_functional_turn; // lowest cluster still in its core cycle
+   std::vector<bool> m_cluster_cycle_done; // guarded by m_functional_mutex
+   pthread_mutex_t m_icnt_mutex;
+   std::vector<bool> m_cluster_stepped; // clusters selected for the current core cycle
+   bool m_cores_skipping;          // core_cycle() replaced by skip_cycle() on the stepped clusters
+   bool m_skip_more_cta_left;      // get_more_cta_left() when skipping started
+   unsigned m_skip_cta_launched;   // m_total_cta_launched when skipping started
+   unsigned long long m_skipped_core_cycles;
+   unsigned m_grids_simulated;     // init()/update_stats() pairs completed so far
+   kernel_info_t *m_checkpoint_kernel;   // set while a mid-kernel checkpoint is saved or restored
+   bool m_checkpoint_restore_pending;    // restored when the grid is launched (warp trace replay)
+   bool m_checkpoint_saved;              // the mid-kernel checkpoint of this run was taken
+   enum sample_phase_t { SAMPLE_DETAILED, SAMPLE_DRAIN };
+   sample_phase_t m_sample_phase;
+   unsigned m_sample_window_ctas;               // CTAs issued in the current detailed window
+   bool m_sample_steady;                        // window at full occupancy, still issuing
+   unsigned m_sample_running_ctas;              // CTAs running on the cores after the last issue
+   unsigned long long m_sample_window_cycles;   // steady-state cycles of the current window
+   unsigned long long m_sample_window_done;     // CTAs completed in them
+   std::vector<unsigned long long> m_sample_steady_cycles; // one sample per measured window
+   std::vector<unsigned long long> m_sample_steady_ctas;
+   unsigned m_sample_unsteady_windows;          // windows that never reached full occupancy
+   unsigned long long m_sample_detail_ctas;     // CTAs simulated in detail this grid
+   unsigned long long m_sample_ff_ctas;         // CTAs fast-forwarded this grid
+   unsigned long long m_sample_ff_insn;         // thread instructions fast-forwarded this grid
    class memory_partition_unit **m_memory_partition_unit;
    class memory_sub_partition **m_memory_sub_partition;
 
@@ -445,15 +551,36 @@ private:
    unsigned m_last_issued_kernel;
 
    std::list<unsigned> m_finished_kernel;
+   std::map<unsigned,class warp_trace_file*> m_warp_traces; // open traces by kernel launch uid
    unsigned m_total_cta_launched;
    unsigned m_last_cluster_issue;
    float * average_pipeline_duty_cycle;
    float * active_sms;
-   // time of next rising edge 
-   double core_time;
-   double icnt_time;
-   double dram_time;
-   double l2_time;
+   // -gpgpu_dvfs_schedule: frequencies in MHz set before a grid starts
+   struct dvfs_point {
+      unsigned grid;
+      double core_mhz, icnt_mhz, l2_mhz, dram_mhz;
+   };
+   std::vector<dvfs_point> m_dvfs_schedule;
+   // clock domain frequencies in kHz (from -gpgpu_clock_domains or set_clock_domains())
+   unsigned long long core_khz;
+   unsigned long long icnt_khz;
+   unsigned long long dram_khz;
+   unsigned long long l2_khz;
+   // clock periods and time of next rising edge, in ticks of 1/lcm(frequencies)
+   unsigned long long core_period;
+   unsigned long long icnt_period;
+   unsigned long long dram_period;
+   unsigned long long l2_period;
+   unsigned long long core_time;
+   unsigned long long icnt_time;
+   unsigned long long dram_time;
+   unsigned long long l2_time;
+   unsigned long long clock_hyperperiod; // ticks after which all clock edges line up again (0 = never)
+   // next_clock_domain() masks over one hyperperiod (empty if it is too long)
+   std::vector<unsigned char> m_clock_schedule;
+   unsigned m_clock_schedule_pos;
+   bool m_clock_schedule_valid; // cleared when the frequencies change
 
    // debug
    bool gpu_deadlock;
@@ -472,6 +599,11 @@ private:
    class gpgpu_sim_wrapper *m_gpgpusim_wrapper;
    unsigned long long  gpu_tot_issued_cta;
    unsigned long long  last_gpu_sim_insn;
+   unsigned gpu_stall_icnt2sh; // performance counter for stalls due to congestion
+   unsigned m_next_mf_request_uid;
+   class InterconnectInterface *m_icnt;
+   class stat_tool_state *m_stat_tool;
+   unsigned long long  m_single_step; // set this in gdb to single step the pipeline
 
    unsigned long long  last_liveness_message_time; 
 
@@ -483,6 +615,8 @@ private:
    void clear_executed_kernel_info(); //< clear the kernel information after stat printout
 
 public:
+   unsigned long long  gpu_sim_cycle;
+   unsigned long long  gpu_tot_sim_cycle;
    unsigned long long  gpu_sim_insn;
    unsigned long long  gpu_tot_sim_insn;
    unsigned long long  gpu_sim_insn_last_update;
@@ -0,0 +1,108 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "host_profile.h"
+
+#ifdef GPGPUSIM_HOST_PROFILE
+
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+bool host_profiler::s_sampling = false;
+bool host_profiler::s_started = false;
+unsigned long long host_profiler::s_samples = 0;
+unsigned long long host_profiler::s_ticks[HOST_PROF_NUM_COMPONENTS];
+unsigned long long host_profiler::s_start_ticks = 0;
+double host_profiler::s_start_ns = 0;
+
+static const char *host_profile_component_str[] = {
+    "cycle",
+    "simt_core",
+    "scheduler",
+    "ldst_unit",
+    "probe_locality",
+    "l2_cache",
+    "dram",
+    "dram_sched",
+    "icnt_transfer"
+};
+
+static double host_profile_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec*1e9 + t.tv_nsec;
+}
+
+unsigned long long host_profiler::ticks()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return (unsigned long long)host_profile_ns();
+#endif
+}
+
+void host_profiler::begin_step( unsigned long long sim_cycle, unsigned interval, bool core_edge )
+{
+    if( !s_started ) {
+        s_started = true;
+        s_start_ticks = ticks();
+        s_start_ns = host_profile_ns();
+    }
+    s_sampling = interval && (sim_cycle % interval) == 0;
+    if( s_sampling && core_edge )
+        s_samples++;
+}
+
+void host_profiler::print( FILE *fout, unsigned long long sim_cycles, unsigned long long sim_insn )
+{
+    if( !s_started )
+        return;
+    // the time stamp counter is calibrated against the wall clock over the run
+    double elapsed_ns = host_profile_ns() - s_start_ns;
+    unsigned long long elapsed_ticks = ticks() - s_start_ticks;
+    double ns_per_tick = elapsed_ticks ? elapsed_ns / elapsed_ticks : 0;
+    double elapsed_sec = elapsed_ns / 1e9;
+
+    fprintf(fout, "host_profile_sampled_cycles = %llu\n", s_samples);
+    fprintf(fout, "host_profile_sim_rate = %.2f KIPS, %.1f cycles/sec\n",
+            elapsed_sec > 0 ? sim_insn / elapsed_sec / 1000 : 0,
+            elapsed_sec > 0 ? sim_cycles / elapsed_sec : 0);
+    if( s_samples == 0 )
+        return;
+    double cycle_ns = s_ticks[HOST_PROF_CYCLE] * ns_per_tick / s_samples;
+    for( unsigned c=0; c < HOST_PROF_NUM_COMPONENTS; c++ ) {
+        double ns = s_ticks[c] * ns_per_tick / s_samples;
+        fprintf(fout, "host_profile[%s] = %.1f ns/cycle (%.1f%%)\n",
+                host_profile_component_str[c], ns, cycle_ns > 0 ? 100*ns/cycle_ns : 0);
+    }
+}
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef HOST_PROFILE_H
+#define HOST_PROFILE_H
+
+// Host-side profile of the simulator itself (build with "make PROFILE=1").
+//
+// Every -gpgpu_host_profile_interval-th core cycle, all clock steps up to and
+// including that core cycle are timed with the time stamp counter. Timers are
+// inclusive (the scheduler and LD/ST unit are also counted in the SIMT core
+// time) and, with -gpgpu_sim_threads > 1, add up the time of every host
+// thread. Without PROFILE=1 HOST_PROFILE_SCOPE() expands to nothing.
+
+#include <stdio.h>
+
+enum host_profile_component {
+    HOST_PROF_CYCLE = 0,      // gpgpu_sim::cycle()
+    HOST_PROF_CORE,           // simt_core_cluster::core_cycle()
+    HOST_PROF_SCHEDULER,      // scheduler_unit::cycle()
+    HOST_PROF_LDST,           // ldst_unit::cycle()
+    HOST_PROF_PROBE_LOCALITY, // tag_array::probe_locality()
+    HOST_PROF_L2,             // memory_sub_partition::cache_cycle()
+    HOST_PROF_DRAM,           // memory_partition_unit::dram_cycle()
+    HOST_PROF_DRAM_SCHED,     // frfcfs_scheduler::schedule()
+    HOST_PROF_ICNT,           // icnt_transfer()
+    HOST_PROF_NUM_COMPONENTS
+};
+
+#ifdef GPGPUSIM_HOST_PROFILE
+
+class host_profiler {
+public:
+    // called at the start of each gpgpu_sim::cycle() once the clock domains
+    // of the step are known
+    static void begin_step( unsigned long long sim_cycle, unsigned interval, bool core_edge );
+    static bool sampling() { return s_sampling; }
+    static unsigned long long ticks();
+    static void add( enum host_profile_component c, unsigned long long ticks )
+    {
+        __sync_fetch_and_add(&s_ticks[c],ticks);
+    }
+    // sim_cycles and sim_insn are totals since the start of the run
+    static void print( FILE *fout, unsigned long long sim_cycles, unsigned long long sim_insn );
+
+private:
+    static bool s_sampling;
+    static bool s_started;
+    static unsigned long long s_samples;
+    static unsigned long long s_ticks[HOST_PROF_NUM_COMPONENTS];
+    static unsigned long long s_start_ticks;
+    static double s_start_ns;
+};
+
+class host_profile_scope {
+public:
+    host_profile_scope( enum host_profile_component c )
+    {
+        m_component = c;
+        m_start = host_profiler::sampling() ? host_profiler::ticks() : 0;
+    }
+    ~host_profile_scope()
+    {
+        if( m_start )
+            host_profiler::add(m_component,host_profiler::ticks()-m_start);
+    }
+private:
+    enum host_profile_component m_component;
+    unsigned long long m_start;
+};
+
+#define HOST_PROFILE_SCOPE(c) host_profile_scope host_profile_scope_##c(c)
+
+#else
+
+#define HOST_PROFILE_SCOPE(c)
+
+#endif
+
+#endif
@@ -50,59 +50,62 @@ char* g_network_config_filename;
 // Wrapper to intersim2 to accompany old icnt_wrapper
 // TODO: use delegate/boost/c++11<funtion> instead
 
+// interconnect of the simulator instance bound on this thread (icnt_bind)
+static __thread InterconnectInterface *t_icnt_interface = NULL;
+
 static void intersim2_create(unsigned int n_shader, unsigned int n_mem)
 {
-   g_icnt_interface->CreateInterconnect(n_shader, n_mem);
+   t_icnt_interface->CreateInterconnect(n_shader, n_mem);
 }
 
 static void intersim2_init()
 {
-   g_icnt_interface->Init();
+   t_icnt_interface->Init();
 }
 
 static bool intersim2_has_buffer(unsigned input, unsigned int size)
 {
-   return g_icnt_interface->HasBuffer(input, size);
+   return t_icnt_interface->HasBuffer(input, size);
 }
 
 static void intersim2_push(unsigned input, unsigned output, void* data, unsigned int size)
 {
-   g_icnt_interface->Push(input, output, data, size);
+   t_icnt_interface->Push(input, output, data, size);
 }
 
 static void* intersim2_pop(unsigned output)
 {
-   return g_icnt_interface->Pop(output);
+   return t_icnt_interface->Pop(output);
 }
 
 static void intersim2_transfer()
 {
-   g_icnt_interface->Advance();
+   t_icnt_interface->Advance();
 }
 
 static bool intersim2_busy()
 {
-   return g_icnt_interface->Busy();
+   return t_icnt_interface->Busy();
 }
 
 static void intersim2_display_stats()
 {
-   g_icnt_interface->DisplayStats();
+   t_icnt_interface->DisplayStats();
 }
 
 static void intersim2_display_overall_stats()
 {
-   g_icnt_interface->DisplayOverallStats();
+   t_icnt_interface->DisplayOverallStats();
 }
 
 static void intersim2_display_state(FILE *fp)
 {
-   g_icnt_interface->DisplayState(fp);
+   t_icnt_interface->DisplayState(fp);
 }
 
 static unsigned intersim2_get_flit_size()
 {
-   return g_icnt_interface->GetFlitSize();
+   return t_icnt_interface->GetFlitSize();
 }
 
 void icnt_reg_options( class OptionParser * opp )
@@ -111,12 +114,13 @@ void icnt_reg_options( class OptionParser * opp )
    option_parser_register(opp, "-inter_config_file", OPT_CSTR, &g_network_config_filename, "Interconnection network config file", "mesh");
 }
 
-void icnt_wrapper_init()
+InterconnectInterface *icnt_wrapper_init()
 {
+   InterconnectInterface *icnt = NULL;
    switch (g_network_mode) {
       case INTERSIM:
          //FIXME: delete the object: may add icnt_done wrapper
-         g_icnt_interface = InterconnectInterface::New(g_network_config_filename);
+         icnt = InterconnectInterface::New(g_network_config_filename);
          icnt_create     = intersim2_create;
          icnt_init       = intersim2_init;
          icnt_has_buffer = intersim2_has_buffer;
@@ -133,4 +137,15 @@ void icnt_wrapper_init()
          assert(0);
          break;
    }
+   icnt_bind(icnt);
+   return icnt;
+}
+
+void icnt_bind( InterconnectInterface *icnt )
+{
+   t_icnt_interface = icnt;
+   // intersim2 reaches back through its own global while advancing; the 
+   // worker threads of one instance all bind the same interconnect
+   if (g_icnt_interface != icnt) 
+      g_icnt_interface = icnt;
 }
@@ -64,7 +64,10 @@ enum network_mode {
    N_NETWORK_MODE
 };
 
-void icnt_wrapper_init();
+// creates an interconnect owned by the caller and binds it to this thread;
+// icnt_bind() selects the interconnect the icnt_* functions drive
+class InterconnectInterface *icnt_wrapper_init();
+void icnt_bind( class InterconnectInterface *icnt );
 void icnt_reg_options( class OptionParser * opp );
 
 #endif
@@ -31,6 +31,7 @@
 
 #include <list>
 #include <set>
+#include <algorithm>
 
 #include "../option_parser.h"
 #include "mem_fetch.h"
@@ -44,6 +45,8 @@
 #include "shader.h"
 #include "mem_latency_stat.h"
 #include "l2cache_trace.h"
+#include "checkpoint.h"
+#include "host_profile.h"
 
 
 mem_fetch * partition_mf_allocator::alloc(new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const 
@@ -56,21 +59,25 @@ mem_fetch * partition_mf_allocator::alloc(new_addr_type addr, mem_access_type ty
                                    -1, 
                                    -1, 
                                    -1,
-                                   m_memory_config);
+                                   m_memory_config,
+                                   m_gpu);
     return mf;
 }
 
 memory_partition_unit::memory_partition_unit( unsigned partition_id, 
                                               const struct memory_config *config,
-                                              class memory_stats_t *stats )
-: m_id(partition_id), m_config(config), m_stats(stats), m_arbitration_metadata(config) 
+                                              class memory_stats_t *stats,
+                                              class gpgpu_sim *gpu,
+                                              bool defer_shared_updates )
+: m_id(partition_id), m_config(config), m_stats(stats), m_gpu(gpu), m_defer_shared_updates(defer_shared_updates), 
+  m_arbitration_metadata(config) 
 {
-    m_dram = new dram_t(m_id,m_config,m_stats,this);
+    m_dram = new dram_t(m_id,m_config,m_stats,this,gpu);
 
     m_sub_partition = new memory_sub_partition*[m_config->m_n_sub_partition_per_memory_channel]; 
     for (unsigned p = 0; p < m_config->m_n_sub_partition_per_memory_channel; p++) {
         unsigned sub_partition_id = m_id * m_config->m_n_sub_partition_per_memory_channel + p; 
-        m_sub_partition[p] = new memory_sub_partition(sub_partition_id, m_config, stats); 
+        m_sub_partition[p] = new memory_sub_partition(sub_partition_id, m_config, stats, gpu, defer_shared_updates); 
     }
 }
 
@@ -194,6 +201,7 @@ int memory_partition_unit::global_sub_partition_id_to_local_id(int global_sub_pa
 
 void memory_partition_unit::dram_cycle() 
 { 
+    HOST_PROFILE_SCOPE(HOST_PROF_DRAM);
     // pop completed memory request from dram and push it to dram-to-L2 queue 
     // of the original sub partition 
     mem_fetch* mf_return = m_dram->return_queue_top();
@@ -207,7 +215,7 @@ void memory_partition_unit::dram_cycle()
                 delete mf_return;
             } else {
                 m_sub_partition[dest_spid]->dram_L2_queue_push(mf_return);
-                mf_return->set_status(IN_PARTITION_DRAM_TO_L2_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+                mf_return->set_status(IN_PARTITION_DRAM_TO_L2_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                 m_arbitration_metadata.return_credit(dest_spid); 
                 MEMPART_DPRINTF("mem_fetch request %p return from dram to sub partition %d\n", mf_return, dest_spid); 
             }
@@ -232,9 +240,9 @@ void memory_partition_unit::dram_cycle()
                 MEMPART_DPRINTF("Issue mem_fetch request %p from sub partition %d to dram\n", mf, spid); 
                 dram_delay_t d;
                 d.req = mf;
-                d.ready_cycle = gpu_sim_cycle+gpu_tot_sim_cycle + m_config->dram_latency;
+                d.ready_cycle = m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle + m_config->dram_latency;
                 m_dram_latency_queue.push_back(d);
-                mf->set_status(IN_PARTITION_DRAM_LATENCY_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+                mf->set_status(IN_PARTITION_DRAM_LATENCY_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                 m_arbitration_metadata.borrow_credit(spid); 
                 break;  // the DRAM should only accept one request per cycle 
             }
@@ -242,13 +250,36 @@ void memory_partition_unit::dram_cycle()
     }
 
     // DRAM latency queue
-    if( !m_dram_latency_queue.empty() && ( (gpu_sim_cycle+gpu_tot_sim_cycle) >= m_dram_latency_queue.front().ready_cycle ) && !m_dram->full() ) {
+    if( !m_dram_latency_queue.empty() && ( (m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle) >= m_dram_latency_queue.front().ready_cycle ) && !m_dram->full() ) {
         mem_fetch* mf = m_dram_latency_queue.front().req;
         m_dram_latency_queue.pop_front();
         m_dram->push(mf);
     }
 }
 
+bool memory_partition_unit::waiting( unsigned long long &ready_cycle, unsigned &dram_cycles ) const
+{
+    unsigned blocked = m_dram->blocked_cycles();
+    if (blocked == 0) 
+        return false;
+    dram_cycles = std::min(dram_cycles, blocked);
+    if (!m_dram_latency_queue.empty()) 
+        ready_cycle = std::min(ready_cycle, m_dram_latency_queue.front().ready_cycle);
+    return true;
+}
+
+void memory_partition_unit::skip_dram_cycle()
+{
+    m_dram->skip_cycle();
+    m_dram->dram_log(SAMPLELOG);
+}
+
+void memory_partition_unit::merge_deferred()
+{
+    if (m_defer_shared_updates) 
+        m_dram->merge_deferred(); 
+}
+
 void memory_partition_unit::set_done( mem_fetch *mf )
 {
     unsigned global_spid = mf->get_sub_partition_id(); 
@@ -273,6 +304,37 @@ void memory_partition_unit::set_dram_power_stats(unsigned &n_cmd,
     m_dram->set_dram_power_stats(n_cmd, n_activity, n_nop, n_act, n_pre, n_rd, n_wr, n_req);
 }
 
+void memory_partition_unit::arbitration_metadata::checkpoint( checkpoint_file &cp ) 
+{
+    cp.vector(m_private_credit); 
+    cp.pod(m_shared_credit); 
+    cp.pod(m_last_borrower); 
+}
+
+// The queues between the units only hold requests in a mid-kernel checkpoint. 
+void memory_partition_unit::checkpoint( checkpoint_file &cp )
+{
+    cp.section("memory_partition_unit"); 
+    cp.check_size(m_id, "memory partition id"); 
+    m_arbitration_metadata.checkpoint(cp); 
+    m_dram->checkpoint(cp); 
+    for (unsigned p = 0; p < m_config->m_n_sub_partition_per_memory_channel; p++) {
+        m_sub_partition[p]->checkpoint(cp); 
+    }
+    size_t n = m_dram_latency_queue.size(); 
+    cp.pod(n); 
+    std::list<dram_delay_t>::iterator d = m_dram_latency_queue.begin(); 
+    for (size_t i = 0; i < n; i++) {
+        dram_delay_t entry; 
+        if (cp.saving()) 
+            entry = *d++; 
+        cp.pod(entry.ready_cycle); 
+        cp.mem_fetch_ref(entry.req); 
+        if (!cp.saving()) 
+            m_dram_latency_queue.push_back(entry); 
+    }
+}
+
 void memory_partition_unit::print( FILE *fp ) const
 {
     fprintf(fp, "Memory Partition %u: \n", m_id); 
@@ -294,18 +356,23 @@ void memory_partition_unit::print( FILE *fp ) const
 
 memory_sub_partition::memory_sub_partition( unsigned sub_partition_id, 
                                             const struct memory_config *config,
-                                            class memory_stats_t *stats )
+                                            class memory_stats_t *stats,
+                                            class gpgpu_sim *gpu,
+                                            bool defer_shared_updates )
 {
     m_id = sub_partition_id;
     m_config=config;
     m_stats=stats;
+    m_gpu=gpu;
+    m_stall_dramfull = 0;
+    m_defer_shared_updates = defer_shared_updates;
 
     assert(m_id < m_config->m_n_mem_sub_partition); 
 
     char L2c_name[32];
     snprintf(L2c_name, 32, "L2_bank_%03d", m_id);
     m_L2interface = new L2interface(this);
-    m_mf_allocator = new partition_mf_allocator(config);
+    m_mf_allocator = new partition_mf_allocator(config, gpu);
 
     if(!m_config->m_L2_config.disabled())
        m_L2cache = new l2_cache(L2c_name,m_config->m_L2_config,-1,-1,m_L2interface,m_mf_allocator,IN_PARTITION_L2_MISS_QUEUE);
@@ -334,13 +401,17 @@ memory_sub_partition::~memory_sub_partition()
 
 void memory_sub_partition::cache_cycle( unsigned cycle )
 {
+    HOST_PROFILE_SCOPE(HOST_PROF_L2);
+    // L2 misses and write-backs create new requests
+    if (m_defer_shared_updates) 
+        mem_fetch::set_uid_log(&m_deferred_mf_uid);
     // L2 fill responses
     if( !m_config->m_L2_config.disabled()) {
        if ( m_L2cache->access_ready() && !m_L2_icnt_queue->full() ) {
            mem_fetch *mf = m_L2cache->next_access();
            if(mf->get_access_type() != L2_WR_ALLOC_R){ // Don't pass write allocate read request back to upper level cache
 				mf->set_reply();
-				mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+				mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
 				m_L2_icnt_queue->push(mf);
            }else{
 				m_request_tracker.erase(mf);
@@ -354,12 +425,12 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
         mem_fetch *mf = m_dram_L2_queue->top();
         if ( !m_config->m_L2_config.disabled() && m_L2cache->waiting_for_fill(mf) ) {
             if (m_L2cache->fill_port_free()) {
-                mf->set_status(IN_PARTITION_L2_FILL_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
-                m_L2cache->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
+                mf->set_status(IN_PARTITION_L2_FILL_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
+                m_L2cache->fill(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                 m_dram_L2_queue->pop();
             }
         } else if ( !m_L2_icnt_queue->full() ) {
-            mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+            mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
             m_L2_icnt_queue->push(mf);
             m_dram_L2_queue->pop();
         }
@@ -380,7 +451,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
             bool port_free = m_L2cache->data_port_free(); 
             if ( !output_full && port_free ) {
                 std::list<cache_event> events;
-                enum cache_request_status status = m_L2cache->access(mf->get_addr(),mf,mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
+                enum cache_request_status status = m_L2cache->access(mf->get_addr(),mf,mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle,events);
                 bool write_sent = was_write_sent(events);
                 bool read_sent = was_read_sent(events);
 
@@ -393,7 +464,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
                             delete mf;
                         } else {
                             mf->set_reply();
-                            mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+                            mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                             m_L2_icnt_queue->push(mf);
                         }
                         m_icnt_L2_queue->pop();
@@ -412,7 +483,7 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
             }
         } else {
             // L2 is disabled or non-texture access to texture-only L2
-            mf->set_status(IN_PARTITION_L2_TO_DRAM_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+            mf->set_status(IN_PARTITION_L2_TO_DRAM_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
             m_L2_dram_queue->push(mf);
             m_icnt_L2_queue->pop();
         }
@@ -423,8 +494,17 @@ void memory_sub_partition::cache_cycle( unsigned cycle )
         mem_fetch* mf = m_rop.front().req;
         m_rop.pop();
         m_icnt_L2_queue->push(mf);
-        mf->set_status(IN_PARTITION_ICNT_TO_L2_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+        mf->set_status(IN_PARTITION_ICNT_TO_L2_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
     }
+
+    if (m_defer_shared_updates) 
+        mem_fetch::set_uid_log(NULL);
+}
+
+void memory_sub_partition::merge_deferred()
+{
+    if (m_defer_shared_updates) 
+        mem_fetch::assign_deferred_uids(m_gpu, m_deferred_mf_uid);
 }
 
 bool memory_sub_partition::full() const
@@ -535,6 +615,64 @@ unsigned memory_sub_partition::flushL2()
     return 0; // L2 is read only in this version
 }
 
+void memory_sub_partition::warm( mem_fetch *mf )
+{
+    if ( !m_config->m_L2_config.disabled() &&
+         ( (m_config->m_L2_texure_only && mf->istexture()) || (!m_config->m_L2_texure_only) ) ) {
+        m_L2cache->warm(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle,false); 
+    }
+}
+
+void memory_sub_partition::checkpoint( checkpoint_file &cp )
+{
+    cp.section("memory_sub_partition"); 
+    if (!m_config->m_L2_config.disabled()) {
+        m_L2cache->checkpoint(cp); 
+    }
+    cp.pod(wb_addr); 
+    cp.pod(m_stall_dramfull); 
+    // requests in flight, only a mid-kernel checkpoint has any
+    std::vector<mem_fetch*> tracked(m_request_tracker.begin(), m_request_tracker.end()); 
+    cp.mem_fetch_refs(tracked); 
+    m_request_tracker = std::set<mem_fetch*>(tracked.begin(), tracked.end()); 
+    cp.mem_fetch_pipeline(*m_icnt_L2_queue); 
+    cp.mem_fetch_pipeline(*m_L2_dram_queue); 
+    cp.mem_fetch_pipeline(*m_dram_L2_queue); 
+    cp.mem_fetch_pipeline(*m_L2_icnt_queue); 
+    cp.mem_fetch_ref(L2dramout); 
+    std::queue<rop_delay_t> rop; 
+    size_t n = m_rop.size(); 
+    cp.pod(n); 
+    for (size_t i = 0; i < n; i++) {
+        rop_delay_t entry; 
+        if (cp.saving()) {
+            entry = m_rop.front(); 
+            m_rop.pop(); 
+        }
+        cp.pod(entry.ready_cycle); 
+        cp.mem_fetch_ref(entry.req); 
+        rop.push(entry); 
+    }
+    m_rop = rop; 
+}
+
+bool memory_sub_partition::waiting( unsigned long long &ready_cycle ) const
+{
+    if (!m_icnt_L2_queue->empty() || !m_L2_dram_queue->empty() || !m_dram_L2_queue->empty() || !m_L2_icnt_queue->empty()) 
+        return false;
+    if (!m_config->m_L2_config.disabled() && !m_L2cache->quiescent()) 
+        return false;
+    if (!m_rop.empty()) 
+        ready_cycle = std::min(ready_cycle, m_rop.front().ready_cycle);
+    return true;
+}
+
+void memory_sub_partition::skip_cache_cycle()
+{
+    if (!m_config->m_L2_config.disabled()) 
+        m_L2cache->skip_cycle();
+}
+
 bool memory_sub_partition::busy() const 
 {
     return !m_request_tracker.empty();
@@ -547,13 +685,13 @@ void memory_sub_partition::push( mem_fetch* req, unsigned long long cycle )
         m_stats->memlatstat_icnt2mem_pop(req);
         if( req->istexture() ) {
             m_icnt_L2_queue->push(req);
-            req->set_status(IN_PARTITION_ICNT_TO_L2_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+            req->set_status(IN_PARTITION_ICNT_TO_L2_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
         } else {
             rop_delay_t r;
             r.req = req;
             r.ready_cycle = cycle + m_config->rop_latency;
             m_rop.push(r);
-            req->set_status(IN_PARTITION_ROP_DELAY,gpu_sim_cycle+gpu_tot_sim_cycle);
+            req->set_status(IN_PARTITION_ROP_DELAY,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
         }
     }
 }
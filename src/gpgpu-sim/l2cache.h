@@ -38,9 +38,10 @@ class mem_fetch;
 
 class partition_mf_allocator : public mem_fetch_allocator {
 public:
-    partition_mf_allocator( const memory_config *config )
+    partition_mf_allocator( const memory_config *config, class gpgpu_sim *gpu )
     {
         m_memory_config = config;
+        m_gpu = gpu;
     }
     virtual mem_fetch * alloc(const class warp_inst_t &inst, const mem_access_t &access) const 
     {
@@ -50,6 +51,7 @@ public:
     virtual mem_fetch * alloc(new_addr_type addr, mem_access_type type, unsigned size, bool wr) const;
 private:
     const memory_config *m_memory_config;
+    class gpgpu_sim *m_gpu;
 };
 
 // Memory partition unit contains all the units assolcated with a single DRAM channel. 
@@ -58,13 +60,20 @@ private:
 class memory_partition_unit
 {
 public: 
-   memory_partition_unit( unsigned partition_id, const struct memory_config *config, class memory_stats_t *stats );
+   memory_partition_unit( unsigned partition_id, const struct memory_config *config, class memory_stats_t *stats,
+                          class gpgpu_sim *gpu, bool defer_shared_updates );
    ~memory_partition_unit(); 
 
    bool busy() const;
 
    void cache_cycle( unsigned cycle );
    void dram_cycle();
+   // true if dram_cycle() only counts down: ready_cycle is lowered to the core 
+   // cycle the DRAM latency queue head is ready, dram_cycles to the DRAM 
+   // cycles before the DRAM can issue a command
+   bool waiting( unsigned long long &ready_cycle, unsigned &dram_cycles ) const;
+   // equivalent of dram_cycle() while waiting()
+   void skip_dram_cycle();
 
    void set_done( mem_fetch *mf );
 
@@ -72,6 +81,13 @@ public:
    void print_stat( FILE *fp ) { m_dram->print_stat(fp); }
    void visualize() const { m_dram->visualize(); }
    void print( FILE *fp ) const;
+   void checkpoint( class checkpoint_file &cp );
+
+   // While the memory partitions are stepped on multiple host threads, updates 
+   // to state shared with other partitions are deferred until merge_deferred() 
+   // is called (in partition order) after every partition has been stepped.
+   bool defer_shared_updates() const { return m_defer_shared_updates; }
+   void merge_deferred();
 
    class memory_sub_partition * get_sub_partition(int sub_partition_id) 
    {
@@ -91,12 +107,15 @@ public:
    int global_sub_partition_id_to_local_id(int global_sub_partition_id) const; 
 
    unsigned get_mpid() const { return m_id; }
+   class gpgpu_sim *get_gpu() const { return m_gpu; }
 
 private: 
 
    unsigned m_id;
    const struct memory_config *m_config;
    class memory_stats_t *m_stats;
+   class gpgpu_sim *m_gpu;
+   bool m_defer_shared_updates;
    class memory_sub_partition **m_sub_partition; 
    class dram_t *m_dram;
 
@@ -116,6 +135,7 @@ private:
       int last_borrower() const { return m_last_borrower; } 
 
       void print( FILE *fp ) const; 
+      void checkpoint( class checkpoint_file &cp ); 
    private: 
       // id of the last subpartition that borrowed credit 
       int m_last_borrower; 
@@ -144,7 +164,8 @@ private:
 class memory_sub_partition
 {
 public:
-   memory_sub_partition( unsigned sub_partition_id, const struct memory_config *config, class memory_stats_t *stats );
+   memory_sub_partition( unsigned sub_partition_id, const struct memory_config *config, class memory_stats_t *stats,
+                         class gpgpu_sim *gpu, bool defer_shared_updates );
    ~memory_sub_partition(); 
 
    unsigned get_id() const { return m_id; } 
@@ -152,14 +173,28 @@ public:
    bool busy() const;
 
    void cache_cycle( unsigned cycle );
+   // true if cache_cycle() only counts down: ready_cycle is lowered to the 
+   // core cycle the ROP queue head is ready
+   bool waiting( unsigned long long &ready_cycle ) const;
+   // equivalent of cache_cycle() while waiting()
+   void skip_cache_cycle();
+   // numbers the requests created by cache_cycle() on a worker thread
+   void merge_deferred();
 
    bool full() const;
+   // cycles in which the interconnect had a request for this sub partition 
+   // but its input queue was full
+   void count_stall_dramfull() { m_stall_dramfull++; }
+   unsigned get_stall_dramfull() const { return m_stall_dramfull; }
    void push( class mem_fetch* mf, unsigned long long clock_cycle );
    class mem_fetch* pop(); 
    class mem_fetch* top();
    void set_done( mem_fetch *mf );
 
    unsigned flushL2();
+   void checkpoint( class checkpoint_file &cp );
+   // tag-only L2 access of a fast-forwarded request (sampled simulation)
+   void warm( class mem_fetch *mf );
 
    // interface to L2_dram_queue
    bool L2_dram_queue_empty() const; 
@@ -203,6 +238,11 @@ private:
    unsigned long long int wb_addr;
 
    class memory_stats_t *m_stats;
+   class gpgpu_sim *m_gpu;
+   unsigned m_stall_dramfull;
+
+   bool m_defer_shared_updates;
+   std::vector<mem_fetch*> m_deferred_mf_uid;
 
    std::set<mem_fetch*> m_request_tracker;
 
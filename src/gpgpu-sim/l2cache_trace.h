@@ -35,11 +35,11 @@
 #define MEMPART_DTRACE(x)  ( DTRACE(x) && (Trace::sampling_memory_partition == -1 || Trace::sampling_memory_partition == (int)get_mpid()) )
 
 // Intended to be called from inside components of a memory partition
-// Depends on a get_mpid() function
+// Depends on get_mpid() and get_gpu() functions
 #define MEMPART_DPRINTF(...) do {\
     if (MEMPART_DTRACE(MEMORY_PARTITION_UNIT)) {\
         printf( MEMPART_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
+                get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle,\
                 Trace::trace_streams_str[Trace::MEMORY_PARTITION_UNIT],\
                 get_mpid() );\
         printf(__VA_ARGS__);\
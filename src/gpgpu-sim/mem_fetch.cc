@@ -30,8 +30,30 @@
 #include "shader.h"
 #include "visualizer.h"
 #include "gpu-sim.h"
+#include "checkpoint.h"
 
-unsigned mem_fetch::sm_next_mf_request_uid=1;
+__thread std::vector<mem_fetch*> *mem_fetch::sm_uid_log=NULL;
+
+void mem_fetch::assign_request_uid()
+{
+   if( sm_uid_log ) {
+      m_request_uid = 0;
+      sm_uid_log->push_back(this);
+   } else {
+      m_request_uid = m_gpu->next_mf_request_uid();
+   }
+}
+
+void mem_fetch::assign_deferred_uids( gpgpu_sim *gpu, std::vector<mem_fetch*> &uid_log )
+{
+   // deleted entries still consume a uid, as they would have at creation
+   for( unsigned i=0; i < uid_log.size(); i++ ) {
+      unsigned uid = gpu->next_mf_request_uid();
+      if( uid_log[i] ) 
+         uid_log[i]->m_request_uid = uid;
+   }
+   uid_log.clear();
+}
 
 mem_fetch::mem_fetch( const mem_access_t &access, 
                       const warp_inst_t *inst,
@@ -40,9 +62,11 @@ mem_fetch::mem_fetch( const mem_access_t &access,
                       unsigned sid, 
                       unsigned tpc, 
                       const class memory_config *config,
+                      gpgpu_sim *gpu,
                       unsigned ctaid )
 {
-   m_request_uid = sm_next_mf_request_uid++;
+   m_gpu = gpu;
+   assign_request_uid();
    m_access = access;
    if( inst ) { 
        m_inst = *inst;
@@ -57,10 +81,10 @@ mem_fetch::mem_fetch( const mem_access_t &access,
    config->m_address_mapping.addrdec_tlx(access.get_addr(),&m_raw_addr);
    m_partition_addr = config->m_address_mapping.partition_address(access.get_addr());
    m_type = m_access.is_write()?WRITE_REQUEST:READ_REQUEST;
-   m_timestamp = gpu_sim_cycle + gpu_tot_sim_cycle;
+   m_timestamp = gpu->gpu_sim_cycle + gpu->gpu_tot_sim_cycle;
    m_timestamp2 = 0;
    m_status = MEM_FETCH_INITIALIZED;
-   m_status_change = gpu_sim_cycle + gpu_tot_sim_cycle;
+   m_status_change = gpu->gpu_sim_cycle + gpu->gpu_tot_sim_cycle;
    m_mem_config = config;
    icnt_flit_size = config->icnt_flit_size;
    check_pair = false;
@@ -74,9 +98,11 @@ mem_fetch::mem_fetch( const mem_access_t &access,
                       unsigned wid,
                       unsigned sid, 
                       unsigned tpc, 
-                      const class memory_config *config)
+                      const class memory_config *config,
+                      gpgpu_sim *gpu )
 {
-   m_request_uid = sm_next_mf_request_uid++;
+   m_gpu = gpu;
+   assign_request_uid();
    m_access = access;
    if( inst ) { 
        m_inst = *inst;
@@ -90,10 +116,10 @@ mem_fetch::mem_fetch( const mem_access_t &access,
    config->m_address_mapping.addrdec_tlx(access.get_addr(),&m_raw_addr);
    m_partition_addr = config->m_address_mapping.partition_address(access.get_addr());
    m_type = m_access.is_write()?WRITE_REQUEST:READ_REQUEST;
-   m_timestamp = gpu_sim_cycle + gpu_tot_sim_cycle;
+   m_timestamp = gpu->gpu_sim_cycle + gpu->gpu_tot_sim_cycle;
    m_timestamp2 = 0;
    m_status = MEM_FETCH_INITIALIZED;
-   m_status_change = gpu_sim_cycle + gpu_tot_sim_cycle;
+   m_status_change = gpu->gpu_sim_cycle + gpu->gpu_tot_sim_cycle;
    m_mem_config = config;
    icnt_flit_size = config->icnt_flit_size;
    check_pair = false;
@@ -101,9 +127,22 @@ mem_fetch::mem_fetch( const mem_access_t &access,
     m_thread0_active = false;
 }
 
+mem_fetch::mem_fetch( checkpoint_file &cp )
+{
+   checkpoint(cp);
+}
 
 mem_fetch::~mem_fetch()
 {
+    if( sm_uid_log ) {
+        // deleted before its uid was assigned
+        for( std::vector<mem_fetch*>::reverse_iterator it=sm_uid_log->rbegin(); it != sm_uid_log->rend(); ++it ) {
+            if( *it == this ) {
+                *it = NULL;
+                break;
+            }
+        }
+    }
     m_status = MEM_FETCH_DELETED;
 }
 
@@ -131,6 +170,37 @@ void mem_fetch::print( FILE *fp, bool print_inst ) const
     else fprintf(fp,"\n");
 }
 
+// the uid is kept, so a restored run numbers and orders its requests as the 
+// run that saved the checkpoint
+void mem_fetch::checkpoint( checkpoint_file &cp )
+{
+    cp.pod(m_thread0_active);
+    cp.pod(is_prefetch);
+    cp.pod(m_request_uid);
+    cp.pod(m_sid);
+    cp.pod(m_tpc);
+    cp.pod(m_wid);
+    cp.pod(m_ctaid);
+    cp.pod(m_status);
+    cp.pod(m_status_change);
+    checkpoint_mem_access(cp,m_access);
+    cp.pod(m_data_size);
+    cp.pod(m_ctrl_size);
+    cp.pod(m_partition_addr);
+    cp.pod(m_raw_addr);
+    cp.pod(m_type);
+    cp.pod(m_timestamp);
+    cp.pod(m_timestamp2);
+    cp.pod(m_icnt_receive_time);
+    cp.pod(check_pair);
+    cp.pod(icnt_flit_size);
+    checkpoint_warp_inst(cp,m_inst);
+    if( !cp.saving() ) {
+        m_gpu = cp.gpu();
+        m_mem_config = m_gpu->getMemoryConfig();
+    }
+}
+
 void mem_fetch::set_status( enum mem_fetch_status status, unsigned long long cycle ) 
 {
     m_status = status;
@@ -31,6 +31,7 @@
 #include "addrdec.h"
 #include "../abstract_hardware_model.h"
 #include <bitset>
+#include <vector>
 
 enum mf_type {
    READ_REQUEST = 0,
@@ -55,7 +56,8 @@ public:
                unsigned wid,
                unsigned sid, 
                unsigned tpc, 
-               const class memory_config *config);
+               const class memory_config *config,
+               class gpgpu_sim *gpu );
     mem_fetch( const mem_access_t &access, 
                const warp_inst_t *inst,
                unsigned ctrl_size, 
@@ -63,7 +65,10 @@ public:
                unsigned sid, 
                unsigned tpc, 
                const class memory_config *config,
+               class gpgpu_sim *gpu,
                unsigned ctaid );
+   // rebuilds a request saved in a mid-kernel timing checkpoint
+   mem_fetch( class checkpoint_file &cp );
    ~mem_fetch();
 
    void set_status( enum mem_fetch_status status, unsigned long long cycle );
@@ -83,6 +88,8 @@ public:
    void do_atomic();
 
    void print( FILE *fp, bool print_inst = true ) const;
+   // use checkpoint_file::mem_fetch_ref(), which saves each request once
+   void checkpoint( class checkpoint_file &cp );
 
    const addrdec_t &get_tlx_addr() const { return m_raw_addr; }
    unsigned get_data_size() const { return m_data_size; }
@@ -123,9 +130,18 @@ public:
    enum mem_fetch_status get_status() const { return m_status; }
 
    const memory_config *get_mem_config(){return m_mem_config;}
+   class gpgpu_sim *get_gpu() const { return m_gpu; }
     bool check_pair;
    unsigned get_num_flits(bool simt_to_mem);
+
+   // While SIMT clusters are stepped on multiple host threads, mem_fetch objects
+   // created by the calling thread are recorded in uid_log instead of taking a 
+   // uid immediately; assign_deferred_uids() then numbers them in the order a 
+   // single-threaded run would have (set_uid_log(NULL) restores immediate uids).
+   static void set_uid_log( std::vector<mem_fetch*> *uid_log ) { sm_uid_log = uid_log; }
+   static void assign_deferred_uids( class gpgpu_sim *gpu, std::vector<mem_fetch*> &uid_log );
 private:
+   void assign_request_uid();
 
     bool m_thread0_active;
     bool is_prefetch;
@@ -156,9 +172,10 @@ private:
    // requesting instruction (put last so mem_fetch prints nicer in gdb)
    warp_inst_t m_inst;
 
-   static unsigned sm_next_mf_request_uid;
+   static __thread std::vector<mem_fetch*> *sm_uid_log;
 
    const class memory_config *m_mem_config;
+   class gpgpu_sim *m_gpu; // simulator instance that created this request
    unsigned icnt_flit_size;
 };
 
@@ -37,18 +37,21 @@
 #include "../cuda-sim/ptx-stats.h"
 #include "visualizer.h"
 #include "dram.h"
+#include "checkpoint.h"
 
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-memory_stats_t::memory_stats_t( unsigned n_shader, const struct shader_core_config *shader_config, const struct memory_config *mem_config )
+memory_stats_t::memory_stats_t( unsigned n_shader, const struct shader_core_config *shader_config, const struct memory_config *mem_config, gpgpu_sim *gpu )
 {
    assert( mem_config->m_valid );
    assert( shader_config->m_valid );
 
    unsigned i,j;
 
+   m_gpu = gpu;
+
 
    concurrent_row_access = (unsigned int**) calloc(mem_config->m_n_mem, sizeof(unsigned int*));
    num_activates = (unsigned int**) calloc(mem_config->m_n_mem, sizeof(unsigned int*));
@@ -76,6 +79,9 @@ memory_stats_t::memory_stats_t( unsigned n_shader, const struct shader_core_conf
    max_icnt2mem_latency = 0;
    max_icnt2sh_latency = 0;
    memset(mrq_lat_table, 0, sizeof(unsigned)*32);
+   dram_sched_shard empty_shard;
+   memset(&empty_shard, 0, sizeof(empty_shard));
+   m_dram_shard.resize(mem_config->m_n_mem, empty_shard);
    memset(dq_lat_table, 0, sizeof(unsigned)*32);
    memset(mf_lat_table, 0, sizeof(unsigned)*32);
    memset(icnt2mem_lat_table, 0, sizeof(unsigned)*24);
@@ -133,11 +139,86 @@ memory_stats_t::memory_stats_t( unsigned n_shader, const struct shader_core_conf
    L2_L2todramlength = (unsigned int*) calloc(mem_config->m_n_mem, sizeof(unsigned int));
 }
 
+void memory_stats_t::reduce_shards()
+{
+   for (unsigned i=0; i < m_dram_shard.size(); i++) {
+      dram_sched_shard &s = m_dram_shard[i];
+      total_n_access += s.n_access;
+      total_n_reads += s.n_reads;
+      total_n_writes += s.n_writes;
+      if (s.max_mrq_latency > max_mrq_latency) 
+         max_mrq_latency = s.max_mrq_latency;
+      for (unsigned j=0; j < 32; j++) 
+         mrq_lat_table[j] += s.mrq_lat_table[j];
+      memset(&s, 0, sizeof(s));
+   }
+}
+
+void memory_stats_t::checkpoint( checkpoint_file &cp )
+{
+   unsigned n_mem = m_memory_config->m_n_mem;
+   unsigned nbk = m_memory_config->nbk;
+   unsigned i,j;
+
+   reduce_shards();
+   cp.section("memory_stats");
+   cp.check_size(m_n_shader,"memory_stats shaders");
+   cp.check_size(n_mem,"memory_stats partitions");
+   cp.check_size(nbk,"memory_stats banks");
+   cp.pod(max_mrq_latency);
+   cp.pod(max_dq_latency);
+   cp.pod(max_mf_latency);
+   cp.pod(max_icnt2mem_latency);
+   cp.pod(max_icnt2sh_latency);
+   cp.pod(mrq_lat_table);
+   cp.pod(dq_lat_table);
+   cp.pod(mf_lat_table);
+   cp.pod(icnt2mem_lat_table);
+   cp.pod(icnt2sh_lat_table);
+   cp.pod(mf_lat_pw_table);
+   cp.pod(mf_num_lat_pw);
+   cp.pod(mf_tot_lat_pw);
+   cp.pod(mf_total_lat);
+   cp.pod(num_mfs);
+   cp.pod(total_n_access);
+   cp.pod(total_n_reads);
+   cp.pod(total_n_writes);
+   for (i=0;i<n_mem;i++) {
+      cp.array(mf_total_lat_table[i],nbk);
+      cp.array(mf_max_lat_table[i],nbk);
+      cp.array(totalbankreads[i],nbk);
+      cp.array(totalbankwrites[i],nbk);
+      cp.array(totalbankaccesses[i],nbk);
+      cp.array(concurrent_row_access[i],nbk);
+      cp.array(num_activates[i],nbk);
+      cp.array(row_access[i],nbk);
+      cp.array(max_conc_access2samerow[i],nbk);
+      cp.array(max_servicetime2samerow[i],nbk);
+   }
+   for (i=0;i<m_n_shader;i++) {
+      for (j=0;j<n_mem;j++) {
+         cp.array(bankreads[i][j],nbk);
+         cp.array(bankwrites[i][j],nbk);
+      }
+   }
+   for (i=0;i<NUM_MEM_ACCESS_TYPE;i++) 
+      for (j=0;j<n_mem;j++) 
+         cp.array(mem_access_type_stats[i][j],nbk+1);
+   cp.array(num_MCBs_accessed,n_mem*nbk);
+   cp.array(position_of_mrq_chosen,m_memory_config->gpgpu_frfcfs_dram_sched_queue_size?m_memory_config->gpgpu_frfcfs_dram_sched_queue_size:1024);
+   cp.array(L2_cbtoL2length,n_mem);
+   cp.array(L2_cbtoL2writelength,n_mem);
+   cp.array(L2_L2tocblength,n_mem);
+   cp.array(L2_dramtoL2length,n_mem);
+   cp.array(L2_dramtoL2writelength,n_mem);
+   cp.array(L2_L2todramlength,n_mem);
+}
+
 // record the total latency
 unsigned memory_stats_t::memlatstat_done(mem_fetch *mf )
 {
    unsigned mf_latency;
-   mf_latency = (gpu_sim_cycle+gpu_tot_sim_cycle) - mf->get_timestamp();
+   mf_latency = (m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle) - mf->get_timestamp();
    mf_num_lat_pw++;
    mf_tot_lat_pw += mf_latency;
    unsigned idx = LOGB2(mf_latency);
@@ -157,7 +238,7 @@ void memory_stats_t::memlatstat_read_done(mem_fetch *mf)
       if (mf_latency > mf_max_lat_table[mf->get_tlx_addr().chip][mf->get_tlx_addr().bk]) 
          mf_max_lat_table[mf->get_tlx_addr().chip][mf->get_tlx_addr().bk] = mf_latency;
       unsigned icnt2sh_latency;
-      icnt2sh_latency = (gpu_tot_sim_cycle+gpu_sim_cycle) - mf->get_return_timestamp();
+      icnt2sh_latency = (m_gpu->gpu_tot_sim_cycle+m_gpu->gpu_sim_cycle) - mf->get_return_timestamp();
       icnt2sh_lat_table[LOGB2(icnt2sh_latency)]++;
       if (icnt2sh_latency > max_icnt2sh_latency)
          max_icnt2sh_latency = icnt2sh_latency;
@@ -190,7 +271,7 @@ void memory_stats_t::memlatstat_icnt2mem_pop(mem_fetch *mf)
 {
    if (m_memory_config->gpgpu_memlatency_stat) {
       unsigned icnt2mem_latency;
-      icnt2mem_latency = (gpu_tot_sim_cycle+gpu_sim_cycle) - mf->get_timestamp();
+      icnt2mem_latency = (m_gpu->gpu_tot_sim_cycle+m_gpu->gpu_sim_cycle) - mf->get_timestamp();
       icnt2mem_lat_table[LOGB2(icnt2mem_latency)]++;
       if (icnt2mem_latency > max_icnt2mem_latency)
          max_icnt2mem_latency = icnt2mem_latency;
@@ -215,6 +296,7 @@ void memory_stats_t::memlatstat_print( unsigned n_mem, unsigned gpu_mem_n_bk )
    unsigned i,j,k,l,m;
    unsigned max_bank_accesses, min_bank_accesses, max_chip_accesses, min_chip_accesses;
 
+   reduce_shards();
    if (m_memory_config->gpgpu_memlatency_stat) {
       printf("maxmrqlatency = %d \n", max_mrq_latency);
       printf("maxdqlatency = %d \n", max_dq_latency);
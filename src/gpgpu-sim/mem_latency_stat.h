@@ -31,12 +31,14 @@
 #include <stdio.h>
 #include <zlib.h>
 #include <map>
+#include <vector>
 
 class memory_stats_t {
 public:
    memory_stats_t( unsigned n_shader, 
                    const struct shader_core_config *shader_config, 
-                   const struct memory_config *mem_config );
+                   const struct memory_config *mem_config,
+                   class gpgpu_sim *gpu );
 
    unsigned memlatstat_done( class mem_fetch *mf );
    void memlatstat_read_done( class mem_fetch *mf );
@@ -46,11 +48,26 @@ public:
    void memlatstat_print(unsigned n_mem, unsigned gpu_mem_n_bk);
 
    void visualizer_print( gzFile visualizer_file );
+   void checkpoint( class checkpoint_file &cp );
+
+   // DRAM scheduler statistics of one memory partition. Each partition only 
+   // updates its own shard so the partitions can be stepped on separate host 
+   // threads; reduce_shards() adds them to the totals below before printing.
+   struct dram_sched_shard {
+      unsigned n_access;
+      unsigned n_reads;
+      unsigned n_writes;
+      unsigned max_mrq_latency;
+      unsigned mrq_lat_table[32];
+   };
+   dram_sched_shard &dram_shard( unsigned dram_id ) { return m_dram_shard[dram_id]; }
+   void reduce_shards();
 
    unsigned m_n_shader;
 
    const struct shader_core_config *m_shader_config;
    const struct memory_config *m_memory_config;
+   class gpgpu_sim *m_gpu;
 
    unsigned max_mrq_latency;
    unsigned max_dq_latency;
@@ -100,6 +117,9 @@ public:
    unsigned total_n_access;
    unsigned total_n_reads;
    unsigned total_n_writes;
+
+private:
+   std::vector<dram_sched_shard> m_dram_shard; // indexed by dram chip id
 };
 
 #endif /*MEM_LATENCY_STAT_H*/
@@ -27,15 +27,18 @@
 
 #include "scoreboard.h"
 #include "shader.h"
+#include "gpu-sim.h"
 #include "../cuda-sim/ptx_sim.h"
 #include "shader_trace.h"
+#include "checkpoint.h"
 
 
 //Constructor
-Scoreboard::Scoreboard( unsigned sid, unsigned n_warps )
+Scoreboard::Scoreboard( unsigned sid, unsigned n_warps, class gpgpu_sim *gpu )
 : longopregs()
 {
 	m_sid = sid;
+	m_gpu = gpu;
 	//Initialize size of table
 	reg_table.resize(n_warps);
 	longopregs.resize(n_warps);
@@ -80,6 +83,16 @@ const bool Scoreboard::islongop (unsigned warp_id,unsigned regnum) {
 	return longopregs[warp_id].find(regnum) != longopregs[warp_id].end();
 }
 
+void Scoreboard::checkpoint(checkpoint_file &cp)
+{
+    cp.section("scoreboard");
+    cp.check_size(reg_table.size(), "scoreboard");
+    for( unsigned w=0; w < reg_table.size(); w++ ) {
+        cp.set(reg_table[w]);
+        cp.set(longopregs[w]);
+    }
+}
+
 void Scoreboard::reserveRegisters(const class warp_inst_t* inst) 
 {
     for( unsigned r=0; r < 4; r++) {
@@ -38,7 +38,7 @@
 
 class Scoreboard {
 public:
-    Scoreboard( unsigned sid, unsigned n_warps );
+    Scoreboard( unsigned sid, unsigned n_warps, class gpgpu_sim *gpu );
 
     void reserveRegisters(const warp_inst_t *inst);
     void releaseRegisters(const warp_inst_t *inst);
@@ -48,11 +48,14 @@ public:
     bool pendingWrites(unsigned wid) const;
     void printContents() const;
     const bool islongop(unsigned warp_id, unsigned regnum);
+    void checkpoint(class checkpoint_file &cp);
 private:
     void reserveRegister(unsigned wid, unsigned regnum);
     int get_sid() const { return m_sid; }
+    const class gpgpu_sim *get_gpu() const { return m_gpu; }
 
     unsigned m_sid;
+    const class gpgpu_sim *m_gpu;
 
     // keeps track of pending writes to registers
     // indexed by warp id, reg_id => pending write count
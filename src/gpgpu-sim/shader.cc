@@ -46,6 +46,8 @@
 #include <limits.h>
 #include "traffic_breakdown.h"
 #include "shader_trace.h"
+#include "checkpoint.h"
+#include "host_profile.h"
 
 #define PRIORITIZE_MSHR_OVER_WB 1
 #define MAX(a,b) (((a)>(b))?(a):(b))
@@ -96,8 +98,14 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     m_not_completed = 0;
     m_active_threads.reset();
     m_n_active_cta = 0;
-    for ( unsigned i = 0; i<MAX_CTA_PER_SHADER; i++ ) 
+    for ( unsigned i = 0; i<MAX_CTA_PER_SHADER; i++ ) {
         m_cta_status[i]=0;
+        m_cta_trace_file[i]=NULL;
+        m_cta_trace_id[i]=0;
+    }
+    m_warp_trace_mode = (enum warp_trace_mode) gpu->get_config().gpgpu_warp_trace;
+    if( m_warp_trace_mode != WARP_TRACE_OFF ) 
+        m_warp_trace.resize(config->max_warps_per_shader);
     for (unsigned i = 0; i<config->n_thread_per_shader; i++) {
         m_thread[i]= NULL;
         m_threadState[i].m_cta_id = -1;
@@ -110,7 +118,7 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     } else {
         m_icnt = new shader_memory_interface(this,cluster);
     }
-    m_mem_fetch_allocator = new shader_core_mem_fetch_allocator(shader_id,tpc_id,mem_config);
+    m_mem_fetch_allocator = new shader_core_mem_fetch_allocator(shader_id,tpc_id,mem_config,gpu);
     
     // fetch
     m_last_warp_fetched = 0;
@@ -121,112 +129,25 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     m_L1I = new read_only_cache( name,m_config->m_L1I_config,m_sid,get_shader_instruction_cache_id(),m_icnt,IN_L1I_MISS_QUEUE);
     
     m_warp.resize(m_config->max_warps_per_shader, shd_warp_t(this, warp_size));
-    m_scoreboard = new Scoreboard(m_sid, m_config->max_warps_per_shader);
+    m_scoreboard = new Scoreboard(m_sid, m_config->max_warps_per_shader, gpu);
     
     //scedulers
     //must currently occur after all inputs have been initialized.
-    std::string sched_config = m_config->gpgpu_scheduler_string;
-    const concrete_scheduler scheduler = sched_config.find("lrr") != std::string::npos ?
-                                         CONCRETE_SCHEDULER_LRR :
-                                         /*cory*/
-                                         sched_config.find("caws") != std::string::npos ?
-                                         CONCRETE_SCHEDULER_CAWS :
-                                         /*cory*/
-                                         sched_config.find("two_level_active") != std::string::npos ?
-                                         CONCRETE_SCHEDULER_TWO_LEVEL_ACTIVE :
-                                         sched_config.find("gto") != std::string::npos ?
-                                         CONCRETE_SCHEDULER_GTO :
-                                         sched_config.find("warp_limiting") != std::string::npos ?
-                                         CONCRETE_SCHEDULER_WARP_LIMITING:
-                                         NUM_CONCRETE_SCHEDULERS;
-    assert ( scheduler != NUM_CONCRETE_SCHEDULERS );
-    
-
     for (int i = 0; i < m_config->gpgpu_num_sched_per_core; i++) { //gpgpu_num_sched_per_core, 2 in GTX480
-        switch( scheduler )
-        {
-            case CONCRETE_SCHEDULER_LRR:
-                schedulers.push_back(
-                    new lrr_scheduler( m_stats,
-                                       this,
-                                       m_scoreboard,
-                                       m_simt_stack,
-                                       &m_warp,
-                                       &m_pipeline_reg[ID_OC_SP],
-                                       &m_pipeline_reg[ID_OC_SFU],
-                                       &m_pipeline_reg[ID_OC_MEM],
-                                       i
-                                     )
-                );
-                break;
-            /*cory*/
-            case CONCRETE_SCHEDULER_CAWS:
-                schedulers.push_back(
-                    new caws_scheduler( m_stats,
-                                       this,
-                                       m_scoreboard,
-                                       m_simt_stack,
-                                       &m_warp,
-                                       &m_pipeline_reg[ID_OC_SP],
-                                       &m_pipeline_reg[ID_OC_SFU],
-                                       &m_pipeline_reg[ID_OC_MEM],
-                                       i
-                                     )
-                );
-                break;
-                /*cory*/
-            case CONCRETE_SCHEDULER_TWO_LEVEL_ACTIVE:
-                schedulers.push_back(
-                    new two_level_active_scheduler( m_stats,
-                                                    this,
-                                                    m_scoreboard,
-                                                    m_simt_stack,
-                                                    &m_warp,
-                                                    &m_pipeline_reg[ID_OC_SP],
-                                                    &m_pipeline_reg[ID_OC_SFU],
-                                                    &m_pipeline_reg[ID_OC_MEM],
-                                                    i,
-                                                    config->gpgpu_scheduler_string
-                                                  )
-                );
-                break;
-            case CONCRETE_SCHEDULER_GTO:
-                schedulers.push_back(
-                    new gto_scheduler( m_stats,
-                                       this,
-                                       m_scoreboard,
-                                       m_simt_stack,
-                                       &m_warp,
-                                       &m_pipeline_reg[ID_OC_SP],
-                                       &m_pipeline_reg[ID_OC_SFU],
-                                       &m_pipeline_reg[ID_OC_MEM],
-                                       i
-                                     )
-                );
-                break;
-            case CONCRETE_SCHEDULER_WARP_LIMITING:
-                schedulers.push_back(
-                    new swl_scheduler( m_stats,
-                                       this,
-                                       m_scoreboard,
-                                       m_simt_stack,
-                                       &m_warp,
-                                       &m_pipeline_reg[ID_OC_SP],
-                                       &m_pipeline_reg[ID_OC_SFU],
-                                       &m_pipeline_reg[ID_OC_MEM],
-                                       i,
-                                       config->gpgpu_scheduler_string
-                                     )
-                );
-                break;
-            default:
-                abort();
-        };
+        schedulers.push_back(
+            scheduler_registry::create( m_stats,
+                                        this,
+                                        m_scoreboard,
+                                        m_simt_stack,
+                                        &m_warp,
+                                        &m_pipeline_reg[ID_OC_SP],
+                                        &m_pipeline_reg[ID_OC_SFU],
+                                        &m_pipeline_reg[ID_OC_MEM],
+                                        i,
+                                        config->gpgpu_scheduler_string
+                                      )
+        );
     }
-    /*cory*/
-    gto_num=0;
-    lrr_num=0;
-    /*cory*/
     //printf("m_warp_size:%d\n",m_warp.size()); /*cory*/
     for (unsigned i = 0; i < m_warp.size(); i++) {
         //distribute i's evenly though schedulers;
@@ -313,6 +234,9 @@ shader_core_ctx::shader_core_ctx( class gpgpu_sim *gpu,
     m_issue_port.push_back(OC_EX_MEM);
     
     assert(m_num_function_units == m_fu.size() and m_fu.size() == m_dispatch_port.size() and m_fu.size() == m_issue_port.size());
+    for ( int i = 0; i < m_config->gpgpu_num_sched_per_core; ++i ) {
+        schedulers[i]->function_units_created();
+    }
     
     //there are as many result buses as the width of the EX_WB stage
     num_result_bus = config->pipe_widths[EX_WB];
@@ -342,7 +266,11 @@ void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread, bool re
 
 void shader_core_ctx::init_warps( unsigned cta_id, unsigned start_thread, unsigned end_thread )
 {
-    address_type start_pc = next_pc(start_thread);
+    // replayed CTAs have no functional thread state, every warp starts at the 
+    // pc of its first trace entry
+    address_type start_pc = m_warp_trace_mode == WARP_TRACE_REPLAY ? 
+                            m_warp_trace[start_thread/m_config->warp_size].peek().pc : 
+                            next_pc(start_thread);
     if (m_config->model == POST_DOMINATOR) {
         unsigned start_warp = start_thread / m_config->warp_size;
         unsigned end_warp = end_thread / m_config->warp_size + ((end_thread % m_config->warp_size)? 1 : 0);
@@ -359,8 +287,9 @@ void shader_core_ctx::init_warps( unsigned cta_id, unsigned start_thread, unsign
                 }
             }
             m_simt_stack[i]->launch(start_pc,active_threads);
-            m_warp[i].init(start_pc,cta_id,i,active_threads, m_dynamic_warp_id);
+            m_warp[i].init(start_pc,cta_id,i,active_threads, m_dynamic_warp_id, m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
             ++m_dynamic_warp_id;
+            schedulers[i%m_config->gpgpu_num_sched_per_core]->warp_initialized(&m_warp[i]);
             m_not_completed += n_active;
       }
    }
@@ -389,6 +318,24 @@ void shader_core_ctx::get_pdom_stack_top_info( unsigned tid, unsigned *pc, unsig
     m_simt_stack[warp_id]->get_pdom_stack_top_info(pc,rpc);
 }
 
+void shader_core_ctx::get_next_inst_info( unsigned warp_id, unsigned *pc, active_mask_t *active_mask ) const
+{
+    if( m_warp_trace_mode == WARP_TRACE_REPLAY ) {
+        const warp_trace_stream &trace = m_warp_trace[warp_id];
+        if( trace.done() ) {
+            *pc = (unsigned)-1;
+            active_mask->reset();
+        } else {
+            *pc = trace.peek().pc;
+            *active_mask = active_mask_t(trace.peek().active_mask);
+        }
+    } else {
+        unsigned rpc;
+        m_simt_stack[warp_id]->get_pdom_stack_top_info(pc,&rpc);
+        *active_mask = m_simt_stack[warp_id]->get_active_mask();
+    }
+}
+
 void shader_core_stats::print( FILE* fout ) const
 {
 	unsigned long long  thread_icount_uarch=0;
@@ -475,11 +422,45 @@ void shader_core_stats::print( FILE* fout ) const
       fprintf(fout, "\tW%d:%d", i-2, shader_cycle_distro[i]);
    fprintf(fout, "\n");
 
+   unsigned caws_epochs = 0;
+   for (unsigned i = 0; i < NUM_CAWS_POLICIES; i++) 
+      caws_epochs += caws_epoch_policy[i];
+   if (caws_epochs) {
+      fprintf(fout, "gpgpu_caws_epochs = %u\n", caws_epochs);
+      fprintf(fout, "gpgpu_caws_epochs[lrr] = %u\n", caws_epoch_policy[CAWS_POLICY_LRR]);
+      fprintf(fout, "gpgpu_caws_epochs[gto] = %u\n", caws_epoch_policy[CAWS_POLICY_GTO]);
+      fprintf(fout, "gpgpu_caws_epochs[throttle] = %u\n", caws_epoch_policy[CAWS_POLICY_THROTTLE]);
+      fprintf(fout, "gpgpu_caws_policy_switches = %u\n", caws_policy_switches);
+      fprintf(fout, "gpgpu_caws_switches_held = %u\n", caws_switches_held);
+   }
+   // L1D hit rate of the sampled loads issued under each policy, as the 
+   // shadow tags estimated it and as achieved
+   const char *caws_shadow_policy[2] = { "lrr", "gto" };
+   for (unsigned i = 0; i < 2; i++) {
+      if (caws_shadow_loads[i]) 
+         fprintf(fout, "gpgpu_caws_shadow_hit_rate[%s] = predicted %.4f, achieved %.4f (%llu loads)\n", caws_shadow_policy[i],
+                 (float)caws_shadow_predicted_hits[i] / caws_shadow_loads[i], (float)caws_shadow_hits[i] / caws_shadow_loads[i], 
+                 caws_shadow_loads[i]);
+   }
+   if (ccws_throttled_loads) 
+      fprintf(fout, "gpgpu_ccws_throttled_loads = %u\n", ccws_throttled_loads);
+   if (cta_aware_group_switches) 
+      fprintf(fout, "gpgpu_cta_aware_group_switches = %u\n", cta_aware_group_switches);
+   if (strncmp(m_config->gpgpu_scheduler_string, "barrier_aware", strlen("barrier_aware")) == 0) 
+      fprintf(fout, "gpgpu_barrier_wait_cycles = %llu\n", barrier_wait_cycles);
+   if (barrier_boosted_issues) 
+      fprintf(fout, "gpgpu_barrier_boosted_issues = %u\n", barrier_boosted_issues);
+
    m_outgoing_traffic_stats->print(fout); 
    m_incoming_traffic_stats->print(fout); 
 }
 
 void shader_core_stats::event_warp_issued( unsigned s_id, unsigned warp_id, unsigned num_issued, unsigned dynamic_warp_id ) {
+    if ( m_parent ) {
+        // per-shader distributions: only this shader's entry is touched
+        m_parent->event_warp_issued( s_id, warp_id, num_issued, dynamic_warp_id );
+        return;
+    }
     assert( warp_id <= m_config->max_warps_per_shader );
     for ( unsigned i = 0; i < num_issued; ++i ) {
         if ( m_shader_dynamic_warp_issue_distro[ s_id ].size() <= dynamic_warp_id ) {
@@ -493,6 +474,206 @@ void shader_core_stats::event_warp_issued( unsigned s_id, unsigned warp_id, unsi
     }
 }
 
+void shader_core_stats::event_warp_load( unsigned s_id, unsigned warp_id, unsigned n_transactions ) {
+    if ( m_parent ) {
+        m_parent->event_warp_load( s_id, warp_id, n_transactions );
+        return;
+    }
+    if ( m_shader_warp_slot_loads[ s_id ].size() <= warp_id ) {
+        m_shader_warp_slot_loads[ s_id ].resize(warp_id + 1);
+        m_shader_warp_slot_load_transactions[ s_id ].resize(warp_id + 1);
+    }
+    ++m_shader_warp_slot_loads[ s_id ][ warp_id ];
+    m_shader_warp_slot_load_transactions[ s_id ][ warp_id ] += n_transactions;
+}
+
+void shader_core_stats::clear_shard_counters()
+{
+    gpgpu_n_load_insn = 0;
+    gpgpu_n_store_insn = 0;
+    gpgpu_n_shmem_insn = 0;
+    gpgpu_n_tex_insn = 0;
+    gpgpu_n_const_insn = 0;
+    gpgpu_n_param_insn = 0;
+    gpgpu_n_shmem_bkconflict = 0;
+    gpgpu_n_cache_bkconflict = 0;
+    gpgpu_n_intrawarp_mshr_merge = 0;
+    gpgpu_n_cmem_portconflict = 0;
+    memset(gpu_stall_shd_mem_breakdown,0,sizeof(gpu_stall_shd_mem_breakdown));
+    gpu_reg_bank_conflict_stalls = 0;
+    memset(shader_cycle_distro,0,(m_config->warp_size+3)*sizeof(unsigned));
+    gpgpu_n_stall_shd_mem = 0;
+    gpgpu_n_mem_read_local = 0;
+    gpgpu_n_mem_write_local = 0;
+    gpgpu_n_mem_texture = 0;
+    gpgpu_n_mem_const = 0;
+    gpgpu_n_mem_read_global = 0;
+    gpgpu_n_mem_write_global = 0;
+    gpgpu_n_mem_read_inst = 0;
+    gpgpu_n_mem_l2_writeback = 0;
+    gpgpu_n_mem_l1_write_allocate = 0;
+    gpgpu_n_mem_l2_write_allocate = 0;
+    made_write_mfs = 0;
+    made_read_mfs = 0;
+    memset(caws_epoch_policy,0,sizeof(caws_epoch_policy));
+    caws_policy_switches = 0;
+    caws_switches_held = 0;
+    memset(caws_shadow_loads,0,sizeof(caws_shadow_loads));
+    memset(caws_shadow_hits,0,sizeof(caws_shadow_hits));
+    memset(caws_shadow_predicted_hits,0,sizeof(caws_shadow_predicted_hits));
+    ccws_throttled_loads = 0;
+    cta_aware_group_switches = 0;
+    barrier_wait_cycles = 0;
+    barrier_boosted_issues = 0;
+    memset(divergence_aware_cycles,0,sizeof(divergence_aware_cycles));
+}
+
+void shader_core_stats::merge_shard()
+{
+    assert( m_parent );
+    m_parent->gpgpu_n_load_insn += gpgpu_n_load_insn;
+    m_parent->gpgpu_n_store_insn += gpgpu_n_store_insn;
+    m_parent->gpgpu_n_shmem_insn += gpgpu_n_shmem_insn;
+    m_parent->gpgpu_n_tex_insn += gpgpu_n_tex_insn;
+    m_parent->gpgpu_n_const_insn += gpgpu_n_const_insn;
+    m_parent->gpgpu_n_param_insn += gpgpu_n_param_insn;
+    m_parent->gpgpu_n_shmem_bkconflict += gpgpu_n_shmem_bkconflict;
+    m_parent->gpgpu_n_cache_bkconflict += gpgpu_n_cache_bkconflict;
+    m_parent->gpgpu_n_intrawarp_mshr_merge += gpgpu_n_intrawarp_mshr_merge;
+    m_parent->gpgpu_n_cmem_portconflict += gpgpu_n_cmem_portconflict;
+    for( unsigned i=0; i < N_MEM_STAGE_ACCESS_TYPE; i++ ) 
+        for( unsigned j=0; j < N_MEM_STAGE_STALL_TYPE; j++ ) 
+            m_parent->gpu_stall_shd_mem_breakdown[i][j] += gpu_stall_shd_mem_breakdown[i][j];
+    m_parent->gpu_reg_bank_conflict_stalls += gpu_reg_bank_conflict_stalls;
+    for( unsigned i=0; i < m_config->warp_size+3; i++ ) 
+        m_parent->shader_cycle_distro[i] += shader_cycle_distro[i];
+    m_parent->gpgpu_n_stall_shd_mem += gpgpu_n_stall_shd_mem;
+    m_parent->gpgpu_n_mem_read_local += gpgpu_n_mem_read_local;
+    m_parent->gpgpu_n_mem_write_local += gpgpu_n_mem_write_local;
+    m_parent->gpgpu_n_mem_texture += gpgpu_n_mem_texture;
+    m_parent->gpgpu_n_mem_const += gpgpu_n_mem_const;
+    m_parent->gpgpu_n_mem_read_global += gpgpu_n_mem_read_global;
+    m_parent->gpgpu_n_mem_write_global += gpgpu_n_mem_write_global;
+    m_parent->gpgpu_n_mem_read_inst += gpgpu_n_mem_read_inst;
+    m_parent->gpgpu_n_mem_l2_writeback += gpgpu_n_mem_l2_writeback;
+    m_parent->gpgpu_n_mem_l1_write_allocate += gpgpu_n_mem_l1_write_allocate;
+    m_parent->gpgpu_n_mem_l2_write_allocate += gpgpu_n_mem_l2_write_allocate;
+    m_parent->made_write_mfs += made_write_mfs;
+    m_parent->made_read_mfs += made_read_mfs;
+    for( unsigned i=0; i < NUM_CAWS_POLICIES; i++ ) 
+        m_parent->caws_epoch_policy[i] += caws_epoch_policy[i];
+    m_parent->caws_policy_switches += caws_policy_switches;
+    m_parent->caws_switches_held += caws_switches_held;
+    for( unsigned i=0; i < 2; i++ ) {
+        m_parent->caws_shadow_loads[i] += caws_shadow_loads[i];
+        m_parent->caws_shadow_hits[i] += caws_shadow_hits[i];
+        m_parent->caws_shadow_predicted_hits[i] += caws_shadow_predicted_hits[i];
+    }
+    m_parent->ccws_throttled_loads += ccws_throttled_loads;
+    m_parent->cta_aware_group_switches += cta_aware_group_switches;
+    m_parent->barrier_wait_cycles += barrier_wait_cycles;
+    m_parent->barrier_boosted_issues += barrier_boosted_issues;
+    for( unsigned i=0; i < NUM_DIVERGENCE_AWARE_MODES; i++ ) 
+        m_parent->divergence_aware_cycles[i] += divergence_aware_cycles[i];
+    m_parent->m_outgoing_traffic_stats->merge(*m_outgoing_traffic_stats);
+    m_parent->m_incoming_traffic_stats->merge(*m_incoming_traffic_stats);
+    clear_shard_counters();
+}
+
+void shader_core_stats::checkpoint( checkpoint_file &cp )
+{
+    assert( m_parent == NULL ); // shards are merged every cycle
+    cp.section("shader_core_stats");
+    unsigned n = m_config->num_shader();
+    cp.check_size(n,"shader_core_stats");
+    cp.array(shader_cycles,n);
+    cp.array(m_num_sim_insn,n);
+    cp.array(m_num_sim_winsn,n);
+    cp.array(m_last_num_sim_insn,n);
+    cp.array(m_last_num_sim_winsn,n);
+    cp.array(m_num_decoded_insn,n);
+    cp.array(m_pipeline_duty_cycle,n);
+    cp.array(m_num_FPdecoded_insn,n);
+    cp.array(m_num_INTdecoded_insn,n);
+    cp.array(m_num_storequeued_insn,n);
+    cp.array(m_num_loadqueued_insn,n);
+    cp.array(m_num_ialu_acesses,n);
+    cp.array(m_num_fp_acesses,n);
+    cp.array(m_num_imul_acesses,n);
+    cp.array(m_num_tex_inst,n);
+    cp.array(m_num_fpmul_acesses,n);
+    cp.array(m_num_idiv_acesses,n);
+    cp.array(m_num_fpdiv_acesses,n);
+    cp.array(m_num_sp_acesses,n);
+    cp.array(m_num_sfu_acesses,n);
+    cp.array(m_num_trans_acesses,n);
+    cp.array(m_num_mem_acesses,n);
+    cp.array(m_num_sp_committed,n);
+    cp.array(m_num_tlb_hits,n);
+    cp.array(m_num_tlb_accesses,n);
+    cp.array(m_num_sfu_committed,n);
+    cp.array(m_num_mem_committed,n);
+    cp.array(m_read_regfile_acesses,n);
+    cp.array(m_write_regfile_acesses,n);
+    cp.array(m_non_rf_operands,n);
+    cp.array(m_num_imul24_acesses,n);
+    cp.array(m_num_imul32_acesses,n);
+    cp.array(m_active_sp_lanes,n);
+    cp.array(m_active_sfu_lanes,n);
+    cp.array(m_active_fu_lanes,n);
+    cp.array(m_active_fu_mem_lanes,n);
+    cp.array(m_n_diverge,n);
+    cp.array(gpgpu_n_shmem_bank_access,n);
+    cp.array(n_simt_to_mem,n);
+    cp.array(n_mem_to_simt,n);
+    cp.array(shader_cycle_distro,m_config->warp_size+3);
+    cp.array(last_shader_cycle_distro,m_config->warp_size+3);
+    cp.pod(gpgpu_n_load_insn);
+    cp.pod(gpgpu_n_store_insn);
+    cp.pod(gpgpu_n_shmem_insn);
+    cp.pod(gpgpu_n_tex_insn);
+    cp.pod(gpgpu_n_const_insn);
+    cp.pod(gpgpu_n_param_insn);
+    cp.pod(gpgpu_n_shmem_bkconflict);
+    cp.pod(gpgpu_n_cache_bkconflict);
+    cp.pod(gpgpu_n_intrawarp_mshr_merge);
+    cp.pod(gpgpu_n_cmem_portconflict);
+    cp.pod(gpu_stall_shd_mem_breakdown);
+    cp.pod(gpu_reg_bank_conflict_stalls);
+    cp.pod(gpgpu_n_stall_shd_mem);
+    cp.pod(gpgpu_n_mem_read_local);
+    cp.pod(gpgpu_n_mem_write_local);
+    cp.pod(gpgpu_n_mem_texture);
+    cp.pod(gpgpu_n_mem_const);
+    cp.pod(gpgpu_n_mem_read_global);
+    cp.pod(gpgpu_n_mem_write_global);
+    cp.pod(gpgpu_n_mem_read_inst);
+    cp.pod(gpgpu_n_mem_l2_writeback);
+    cp.pod(gpgpu_n_mem_l1_write_allocate);
+    cp.pod(gpgpu_n_mem_l2_write_allocate);
+    cp.pod(made_write_mfs);
+    cp.pod(made_read_mfs);
+    cp.pod(caws_epoch_policy);
+    cp.pod(caws_policy_switches);
+    cp.pod(caws_switches_held);
+    cp.pod(caws_shadow_loads);
+    cp.pod(caws_shadow_hits);
+    cp.pod(caws_shadow_predicted_hits);
+    cp.pod(ccws_throttled_loads);
+    cp.pod(cta_aware_group_switches);
+    cp.pod(barrier_wait_cycles);
+    cp.pod(barrier_boosted_issues);
+    cp.pod(divergence_aware_cycles);
+    m_outgoing_traffic_stats->checkpoint(cp);
+    m_incoming_traffic_stats->checkpoint(cp);
+    cp.vector2d(m_shader_dynamic_warp_issue_distro);
+    cp.vector(m_last_shader_dynamic_warp_issue_distro);
+    cp.vector2d(m_shader_warp_slot_issue_distro);
+    cp.vector(m_last_shader_warp_slot_issue_distro);
+    cp.vector2d(m_shader_warp_slot_loads);
+    cp.vector2d(m_shader_warp_slot_load_transactions);
+}
+
 void shader_core_stats::visualizer_print( gzFile visualizer_file )
 {
     // warp divergence breakdown
@@ -593,7 +774,10 @@ void shader_core_ctx::decode()
     if( m_inst_fetch_buffer.m_valid ) {
         // decode 1 or 2 instructions and place them into ibuffer
         address_type pc = m_inst_fetch_buffer.m_pc;
+        m_gpu->functional_lock();
         const warp_inst_t* pI1 = ptx_fetch_inst(pc);
+        const warp_inst_t* pI2 = pI1? ptx_fetch_inst(pc+pI1->isize) : NULL;
+        m_gpu->functional_unlock();
         m_warp[m_inst_fetch_buffer.m_warp_id].ibuffer_fill(0,pI1);
         m_warp[m_inst_fetch_buffer.m_warp_id].inc_inst_in_pipeline();
         if( pI1 ) {
@@ -603,7 +787,6 @@ void shader_core_ctx::decode()
             }else if(pI1->oprnd_type==FP_OP) {
             	m_stats->m_num_FPdecoded_insn[m_sid]++;
             }
-           const warp_inst_t* pI2 = ptx_fetch_inst(pc+pI1->isize);
            if( pI2 ) {
                m_warp[m_inst_fetch_buffer.m_warp_id].ibuffer_fill(1,pI2);
                m_warp[m_inst_fetch_buffer.m_warp_id].inc_inst_in_pipeline();
@@ -628,23 +811,8 @@ void shader_core_ctx::fetch()
             unsigned warp_id = (m_last_warp_fetched+1+i) % m_config->max_warps_per_shader;
 
             // this code checks if this warp has finished executing and can be reclaimed
-            if( m_warp[warp_id].hardware_done() && !m_scoreboard->pendingWrites(warp_id) && !m_warp[warp_id].done_exit() ) {
-                bool did_exit=false;
-                for( unsigned t=0; t<m_config->warp_size;t++) {
-                    unsigned tid=warp_id*m_config->warp_size+t;
-                    if( m_threadState[tid].m_active == true ) {
-                        m_threadState[tid].m_active = false; 
-                        unsigned cta_id = m_warp[warp_id].get_cta_id();
-                        register_cta_thread_exit(cta_id);
-                        m_not_completed -= 1;
-                        m_active_threads.reset(tid);
-                        assert( m_thread[tid]!= NULL );
-                        did_exit=true;
-                    }
-                }
-                if( did_exit ) 
-                    m_warp[warp_id].set_done_exit();
-            }
+            if( m_warp[warp_id].hardware_done() && !m_scoreboard->pendingWrites(warp_id) && !m_warp[warp_id].done_exit() ) 
+                reclaim_warp(warp_id);
 
             // this code fetches instructions from the i-cache or generates memory requests
             if( !m_warp[warp_id].functional_done() && !m_warp[warp_id].imiss_pending() && m_warp[warp_id].ibuffer_empty() ) {
@@ -664,18 +832,19 @@ void shader_core_ctx::fetch()
                                               warp_id,
                                               m_sid,
                                               m_tpc,
-                                              m_memory_config);
+                                              m_memory_config,
+                                              m_gpu);
                 std::list<cache_event> events;
                 mem_fetch *pref_mf = NULL;
-                enum cache_request_status status = m_L1I->access( (new_addr_type)ppc, mf, pref_mf, gpu_sim_cycle+gpu_tot_sim_cycle,events); //second mf is no use, only data cache need prefetch
+                enum cache_request_status status = m_L1I->access( (new_addr_type)ppc, mf, pref_mf, m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle,events); //second mf is no use, only data cache need prefetch
                 if( status == MISS ) {
                     m_last_warp_fetched=warp_id;
                     m_warp[warp_id].set_imiss_pending();
-                    m_warp[warp_id].set_last_fetch(gpu_sim_cycle);
+                    m_warp[warp_id].set_last_fetch(m_gpu->gpu_sim_cycle);
                 } else if( status == HIT ) {
                     m_last_warp_fetched=warp_id;
                     m_inst_fetch_buffer = ifetch_buffer_t(pc,nbytes,warp_id);
-                    m_warp[warp_id].set_last_fetch(gpu_sim_cycle);
+                    m_warp[warp_id].set_last_fetch(m_gpu->gpu_sim_cycle);
                     delete mf;
                 } else {
                     m_last_warp_fetched=warp_id;
@@ -696,13 +865,125 @@ void shader_core_ctx::fetch()
     }
 }
 
+void shader_core_ctx::reclaim_warp( unsigned warp_id )
+{
+    bool did_exit=false;
+    for( unsigned t=0; t<m_config->warp_size;t++) {
+        unsigned tid=warp_id*m_config->warp_size+t;
+        if( m_threadState[tid].m_active == true ) {
+            m_threadState[tid].m_active = false; 
+            unsigned cta_id = m_warp[warp_id].get_cta_id();
+            register_cta_thread_exit(cta_id);
+            m_not_completed -= 1;
+            m_active_threads.reset(tid);
+            assert( m_thread[tid]!= NULL || m_warp_trace_mode == WARP_TRACE_REPLAY );
+            did_exit=true;
+        }
+    }
+    if( did_exit ) 
+        m_warp[warp_id].set_done_exit();
+}
+
 void shader_core_ctx::func_exec_inst( warp_inst_t &inst )
 {
-    execute_warp_inst_t(inst);
+    if( m_warp_trace_mode == WARP_TRACE_REPLAY ) {
+        replay_warp_inst(inst);
+    } else {
+        warp_trace_inst *captured = NULL;
+        if( m_warp_trace_mode == WARP_TRACE_CAPTURE ) {
+            // addresses and exiting threads are added by checkExecutionStatusAndUpdate()
+            std::vector<warp_trace_inst> &trace = m_warp_trace[inst.warp_id()].inst;
+            trace.push_back(warp_trace_inst());
+            captured = &trace.back();
+            captured->pc = inst.pc;
+            captured->op = inst.op;
+            captured->active_mask = inst.get_active_mask().to_ulong();
+        }
+        m_gpu->functional_lock_ordered(m_tpc);
+        execute_warp_inst_t(inst);
+        m_gpu->functional_unlock();
+        if( captured ) {
+            assert( inst.space.get_type() < 256 && inst.space.get_bank() < 256 );
+            captured->space = inst.space.get_type();
+            captured->space_bank = inst.space.get_bank();
+            captured->memory_op = inst.memory_op;
+            captured->data_size = inst.data_size;
+            captured->atomic = inst.isatomic();
+        }
+    }
     if( inst.is_load() || inst.is_store() )
         inst.generate_mem_accesses();
 }
 
+// Warp trace replay: the next trace entry of the warp stands in for the 
+// functional model. It supplies what execute_warp_inst_t() would have set on 
+// the instruction, then each active thread goes through 
+// checkExecutionStatusAndUpdate() exactly as in an execution-driven run.
+void shader_core_ctx::replay_warp_inst( warp_inst_t &inst )
+{
+    unsigned warp_id = inst.warp_id();
+    warp_trace_stream &trace = m_warp_trace[warp_id];
+    assert( !trace.done() );
+    const warp_trace_inst &t = trace.peek();
+    if( t.pc != inst.pc || t.op != (unsigned)inst.op || t.active_mask != inst.get_active_mask().to_ulong() ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace does not match the program on shader %u, warp %u: "
+               "trace pc 0x%04x op %u mask 0x%08x, issued pc 0x%04x op %u mask 0x%08lx\n", 
+               m_sid, warp_id, t.pc, t.op, t.active_mask, inst.pc, (unsigned)inst.op, inst.get_active_mask().to_ulong());
+        abort();
+    }
+    memory_space_t space((enum _memory_space_t)t.space);
+    space.set_bank(t.space_bank);
+    inst.space = space;
+    inst.memory_op = (enum memory_op_t)t.memory_op;
+    inst.data_size = t.data_size;
+    bool mem = inst.is_load() || inst.is_store();
+    for( unsigned lane=0; lane < m_config->warp_size; lane++ ) {
+        if( !inst.active(lane) ) 
+            continue;
+        if( t.atomic ) 
+            inst.add_callback(lane,NULL,NULL,NULL,true); // performed functionally at capture
+        if( mem ) 
+            inst.set_addr(lane,trace.addr[trace.next_addr++]);
+    }
+    bool exited = t.exit_mask != 0;
+    for( unsigned lane=0; lane < m_config->warp_size; lane++ ) {
+        if( inst.active(lane) ) 
+            checkExecutionStatusAndUpdate(inst,lane,warp_id*m_config->warp_size+lane);
+    }
+    trace.next_inst++;
+    if( exited && m_warp[warp_id].functional_done() ) 
+        warp_exit(warp_id);
+}
+
+// updateSIMTStack() takes each thread's next pc from its functional state, 
+// which replayed threads do not have. A lane's next pc is instead that of the 
+// first later trace entry it is active in, and a lane with none has finished. 
+// The scan stops once every active lane is found, which is the next entry 
+// unless the warp diverged.
+void shader_core_ctx::replay_simt_stack( unsigned warp_id, warp_inst_t *inst )
+{
+    const warp_trace_stream &trace = m_warp_trace[warp_id];
+    assert( trace.next_inst > 0 );
+    unsigned pending = inst->get_active_mask().to_ulong() & ~trace.inst[trace.next_inst-1].exit_mask;
+    addr_vector_t next_pc(m_config->warp_size,(address_type)-1);
+    for( unsigned i=trace.next_inst; pending && i < trace.inst.size(); i++ ) {
+        unsigned found = pending & trace.inst[i].active_mask;
+        for( unsigned lane=0; lane < m_config->warp_size; lane++ ) {
+            if( (found >> lane) & 1 ) 
+                next_pc[lane] = trace.inst[i].pc;
+        }
+        pending &= ~found;
+    }
+    simt_mask_t thread_done;
+    for( unsigned lane=0; lane < m_config->warp_size; lane++ ) {
+        if( next_pc[lane] == (address_type)-1 ) 
+            thread_done.set(lane);
+        else if( inst->reconvergence_pc == RECONVERGE_RETURN_PC ) 
+            inst->reconvergence_pc = next_pc[lane]; // every lane returns to the caller
+    }
+    m_simt_stack[warp_id]->update(thread_done,next_pc,inst->reconvergence_pc,inst->op,inst->isize,inst->pc);
+}
+
 void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t* next_inst, const active_mask_t &active_mask, unsigned warp_id )
 {
     warp_inst_t** pipe_reg = pipe_reg_set.get_free();
@@ -711,9 +992,15 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
     assert(next_inst->valid());
     **pipe_reg = *next_inst; // static instruction information
     //(*pipe_reg)->issue( active_mask, warp_id, gpu_tot_sim_cycle + gpu_sim_cycle, m_warp[warp_id].get_dynamic_warp_id());// dynamic instruction information
-    (*pipe_reg)->issue( active_mask, warp_id, gpu_tot_sim_cycle + gpu_sim_cycle, m_warp[warp_id].get_dynamic_warp_id(), m_warp[warp_id].get_cta_id());// dynamic instruction information
+    (*pipe_reg)->issue( active_mask, warp_id, m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle, m_warp[warp_id].get_dynamic_warp_id(), m_warp[warp_id].get_cta_id());// dynamic instruction information
     m_stats->shader_cycle_distro[2+(*pipe_reg)->active_count()]++;
+    m_warp[warp_id].issued( m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle );
     func_exec_inst( **pipe_reg );
+    if( (*pipe_reg)->is_load() && 
+        ((*pipe_reg)->space.get_type() == global_space || (*pipe_reg)->space.get_type() == local_space) ) {
+        m_warp[warp_id].record_load_transactions( (*pipe_reg)->accessq_count() );
+        m_stats->event_warp_load( m_sid, warp_id, (*pipe_reg)->accessq_count() );
+    }
 
     if( next_inst->op == BARRIER_OP ){
     	m_warp[warp_id].store_info_of_last_inst_at_barrier(*pipe_reg);
@@ -723,11 +1010,95 @@ void shader_core_ctx::issue_warp( register_set& pipe_reg_set, const warp_inst_t*
         m_warp[warp_id].set_membar();
     }
 
-    updateSIMTStack(warp_id,*pipe_reg);
+    if( m_warp_trace_mode == WARP_TRACE_REPLAY ) 
+        replay_simt_stack(warp_id,*pipe_reg);
+    else
+        updateSIMTStack(warp_id,*pipe_reg);
     m_scoreboard->reserveRegisters(*pipe_reg);
     m_warp[warp_id].set_next_pc(next_inst->pc + next_inst->isize);
 }
 
+// Functional fast-forward for sampled simulation (-gpgpu_sample_*): each warp 
+// of the CTA executes one instruction at a time through the same functional 
+// model, SIMT stack and barriers as issue_warp(), but without the fetch, 
+// scoreboard or functional unit models, until it reaches a barrier or exits. 
+// Only called while every core is idle, so the CTA's warps are the only 
+// ones on this core and are reclaimed before returning.
+unsigned long long shader_core_ctx::functional_execute_cta( unsigned cta_id, bool warm )
+{
+    if( m_ff_inst.empty() ) 
+        m_ff_inst.resize(m_config->max_warps_per_shader);
+    std::vector<unsigned> warps;
+    for( unsigned w=0; w < m_config->max_warps_per_shader; w++ ) {
+        if( !m_warp[w].done_exit() && m_warp[w].get_cta_id() == cta_id ) 
+            warps.push_back(w);
+    }
+
+    unsigned long long n_insn = 0;
+    bool progress = true;
+    while( progress ) {
+        progress = false;
+        for( unsigned i=0; i < warps.size(); i++ ) {
+            unsigned warp_id = warps[i];
+            while( !m_warp[warp_id].functional_done() && !m_barriers.warp_waiting_at_barrier(warp_id) ) {
+                unsigned pc,rpc;
+                m_simt_stack[warp_id]->get_pdom_stack_top_info(&pc,&rpc);
+                m_gpu->functional_lock();
+                const warp_inst_t *pI = ptx_fetch_inst(pc);
+                m_gpu->functional_unlock();
+                assert( pI );
+                warp_inst_t &inst = m_ff_inst[warp_id];
+                inst = *pI;
+                inst.issue( m_simt_stack[warp_id]->get_active_mask(), warp_id, m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle, 
+                            m_warp[warp_id].get_dynamic_warp_id(), cta_id );
+                func_exec_inst( inst );
+                if( inst.isatomic() ) {
+                    // performed at the memory partition in timing mode
+                    inst.do_atomic();
+                    m_warp[warp_id].dec_n_atomic(inst.active_count());
+                }
+                if( warm ) 
+                    warm_caches( inst );
+                if( pI->op == BARRIER_OP ) {
+                    m_warp[warp_id].store_info_of_last_inst_at_barrier(&inst);
+                    m_barriers.warp_reaches_barrier(cta_id,warp_id,&inst);
+                }
+                updateSIMTStack(warp_id,&inst);
+                n_insn += inst.active_count();
+                progress = true;
+            }
+        }
+    }
+
+    for( unsigned i=0; i < warps.size(); i++ ) {
+        unsigned warp_id = warps[i];
+        if( !m_warp[warp_id].functional_done() ) {
+            printf("GPGPU-Sim uArch: ERROR ** functional execution of CTA %u on shader %u stuck at a barrier\n", cta_id, m_sid);
+            m_barriers.dump();
+            abort();
+        }
+        assert( m_warp[warp_id].hardware_done() && !m_scoreboard->pendingWrites(warp_id) );
+        reclaim_warp(warp_id);
+    }
+    return n_insn;
+}
+
+// tag-only accesses of a fast-forwarded instruction, see ldst_unit::memory_cycle()
+void shader_core_ctx::warm_caches( warp_inst_t &inst )
+{
+    if( (inst.space.get_type() != global_space) &&
+        (inst.space.get_type() != local_space) &&
+        (inst.space.get_type() != param_space_local) ) 
+        return;
+    while( !inst.accessq_empty() ) {
+        mem_fetch *mf = m_mem_fetch_allocator->alloc(inst,inst.accessq_back());
+        inst.accessq_pop_back();
+        if( m_ldst_unit->warm_l1d(inst,mf) ) 
+            m_gpu->warm_l2(mf);
+        delete mf;
+    }
+}
+
 void shader_core_ctx::issue(){
     //really is issue;
     for (unsigned i = 0; i < schedulers.size(); i++) {
@@ -833,6 +1204,7 @@ void scheduler_unit::order_by_priority( std::vector< T >& result_list,
 
 void scheduler_unit::cycle()
 {
+    HOST_PROFILE_SCOPE(HOST_PROF_SCHEDULER);
     SCHED_DPRINTF( "scheduler_unit::cycle()\n" );
     bool valid_inst = false;  // there was one warp with a valid instruction to issue (didn't require flush due to control hazard)
     bool ready_inst = false;  // of the valid instructions, there was one not waiting for pending register writes
@@ -864,13 +1236,14 @@ void scheduler_unit::cycle()
         unsigned warp_id = (*iter)->get_warp_id();
         unsigned checked=0;
         unsigned issued=0;
-        unsigned max_issue = m_shader->m_config->gpgpu_max_insn_issue_per_warp;
+        unsigned max_issue = m_shader->get_config()->gpgpu_max_insn_issue_per_warp;
         while( !warp(warp_id).waiting() && !warp(warp_id).ibuffer_empty() && (checked < max_issue) && (checked <= issued) && (issued < max_issue) ) {
             const warp_inst_t *pI = warp(warp_id).ibuffer_next_inst();
             bool valid = warp(warp_id).ibuffer_next_valid();
             bool warp_inst_issued = false;
-            unsigned pc,rpc;
-            m_simt_stack[warp_id]->get_pdom_stack_top_info(&pc,&rpc);
+            unsigned pc;
+            active_mask_t active_mask;
+            m_shader->get_next_inst_info(warp_id,&pc,&active_mask);
             SCHED_DPRINTF( "Warp (warp_id %u, dynamic_warp_id %u) has valid instruction (%s)\n",
                            (*iter)->get_warp_id(), (*iter)->get_dynamic_warp_id(),
                            ptx_get_insn_str( pc).c_str() );
@@ -888,10 +1261,9 @@ void scheduler_unit::cycle()
                         SCHED_DPRINTF( "Warp (warp_id %u, dynamic_warp_id %u) passes scoreboard\n",
                                        (*iter)->get_warp_id(), (*iter)->get_dynamic_warp_id() );
                         ready_inst = true;
-                        const active_mask_t &active_mask = m_simt_stack[warp_id]->get_active_mask();
                         assert( warp(warp_id).inst_in_pipeline() );
                         if ( (pI->op == LOAD_OP) || (pI->op == STORE_OP) || (pI->op == MEMORY_BARRIER_OP) ) {
-                            if( m_mem_out->has_free() ) {
+                            if( m_mem_out->has_free() && memory_inst_allowed(warp_id,pI) ) {
                                 m_shader->issue_warp(*m_mem_out,pI,active_mask,warp_id);
                                 issued_warp_id=warp_id;
                                 inst_type=0;
@@ -947,17 +1319,10 @@ void scheduler_unit::cycle()
         }
         //printf("issued:%d \n",issued);  /*cory*/
         if ( issued ) {                                    
-            // This might be a bit inefficient, but we need to maintain
-            // two ordered list for proper scheduler execution.
-            // We could remove the need for this loop by associating a
-            // supervised_is index with each entry in the m_next_cycle_prioritized_warps
-            // vector. For now, just run through until you find the right warp_id
-            for ( std::vector< shd_warp_t* >::const_iterator supervised_iter = m_supervised_warps.begin();
-                  supervised_iter != m_supervised_warps.end();
-                  ++supervised_iter ) {
-                if ( *iter == *supervised_iter ) {
-                    m_last_supervised_issued = supervised_iter;
-                }
+            // we need to maintain two ordered lists for proper scheduler execution;
+            // m_supervised_index gives the issued warp's place in m_supervised_warps
+            if ( warp_id < m_supervised_index.size() && m_supervised_index[warp_id] >= 0 ) {
+                m_last_supervised_issued = m_supervised_warps.begin() + m_supervised_index[warp_id];
             }
             break;
         } 
@@ -972,6 +1337,22 @@ void scheduler_unit::cycle()
         m_stats->shader_cycle_distro[2]++; // pipeline stalled
 }
 
+unsigned scheduler_unit::stalled_cycle_distro()
+{
+    // on a quiescent core every warp that reaches the scoreboard check in 
+    // cycle() has a valid instruction that fails it
+    order_warps();
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_next_cycle_prioritized_warps.begin();
+          iter != m_next_cycle_prioritized_warps.end();
+          iter++ ) {
+        if ( (*iter) == NULL || (*iter)->done_exit() ) 
+            continue;
+        if ( !(*iter)->waiting() && !(*iter)->ibuffer_empty() && (*iter)->ibuffer_next_inst() ) 
+            return 1; // waiting for RAW hazards
+    }
+    return 0; // idle
+}
+
 void scheduler_unit::do_on_warp_issued( unsigned warp_id,
                                         unsigned num_issued,
                                         const std::vector< shd_warp_t* >::const_iterator& prioritized_iter )
@@ -983,6 +1364,24 @@ void scheduler_unit::do_on_warp_issued( unsigned warp_id,
     warp(warp_id).ibuffer_step();
 }
 
+bool scheduler_unit::stalled_on_long_op( shd_warp_t *w )
+{
+    if ( w->waiting() ) 
+        return true;
+    const warp_inst_t* inst = w->ibuffer_next_inst();
+    for ( int i=0; inst && i<4; i++ ) {
+        if ( inst->in[i] > 0 && m_scoreboard->islongop( w->get_warp_id(), inst->in[i] ) ) 
+            return true;
+    }
+    return false;
+}
+
+int scheduler_unit::scheduler_policy_gto() const
+{
+    // the order functions record the policy in the LD/ST unit of the core
+    return m_shader->scheduler_policy_gto();
+}
+
 bool scheduler_unit::sort_warps_by_oldest_dynamic_id(shd_warp_t* lhs, shd_warp_t* rhs)
 {
     if (rhs && lhs) {
@@ -998,14 +1397,540 @@ bool scheduler_unit::sort_warps_by_oldest_dynamic_id(shd_warp_t* lhs, shd_warp_t
     }
 }
 
+void scheduler_unit::warp_initialized( shd_warp_t *w )
+{
+    std::vector< shd_warp_t* >::iterator iter 
+        = std::find( m_oldest_first_warps.begin(), m_oldest_first_warps.end(), w );
+    if ( iter == m_oldest_first_warps.end() ) {
+        return; // not supervised by this scheduler
+    }
+    m_oldest_first_warps.erase( iter );
+    m_oldest_first_warps.push_back( w );
+    if ( PRIORITIZED_ORDER_GREEDY_THEN_OLDEST == m_prioritized_order ) {
+        m_prioritized_order = PRIORITIZED_ORDER_NONE;
+    }
+}
+
+void scheduler_unit::checkpoint_warp_list( checkpoint_file &cp, std::vector< shd_warp_t* > &warps )
+{
+    std::vector<unsigned> index;
+    for ( unsigned i = 0; i < warps.size(); i++ ) 
+        index.push_back( warps[i] - &warp(0) );
+    cp.vector(index);
+    if ( !cp.saving() ) {
+        warps.clear();
+        for ( unsigned i = 0; i < index.size(); i++ ) 
+            warps.push_back( &warp(index[i]) );
+    }
+}
+
+void scheduler_unit::checkpoint_warps( checkpoint_file &cp )
+{
+    unsigned last_issued = m_last_supervised_issued - m_supervised_warps.begin();
+    cp.pod(last_issued);
+    checkpoint_warp_list( cp, m_next_cycle_prioritized_warps );
+    checkpoint_warp_list( cp, m_oldest_first_warps );
+    if ( !cp.saving() ) {
+        m_last_supervised_issued = m_supervised_warps.begin() + last_issued;
+        // rebuilt by the next order_warps()
+        m_prioritized_order = PRIORITIZED_ORDER_NONE;
+        m_prioritized_for = NULL;
+    }
+}
+
+void scheduler_unit::order_lrr_supervised()
+{
+    shd_warp_t* last_issued = ( m_last_supervised_issued == m_supervised_warps.end() ) ? NULL 
+                                                                                       : *m_last_supervised_issued;
+    if ( PRIORITIZED_ORDER_LRR == m_prioritized_order && last_issued == m_prioritized_for ) {
+        return;
+    }
+    // the warp after the last issued one goes first, the last issued one last
+    std::vector< shd_warp_t* >::const_iterator begin = m_supervised_warps.begin();
+    std::vector< shd_warp_t* >::const_iterator end = m_supervised_warps.end();
+    std::vector< shd_warp_t* >::const_iterator first = last_issued ? m_last_supervised_issued + 1 : begin;
+    m_next_cycle_prioritized_warps.assign( first, end );
+    m_next_cycle_prioritized_warps.insert( m_next_cycle_prioritized_warps.end(), begin, first );
+    m_prioritized_order = PRIORITIZED_ORDER_LRR;
+    m_prioritized_for = last_issued;
+}
+
+void scheduler_unit::order_greedy_then_oldest( unsigned num_warps_to_add )
+{
+    assert( num_warps_to_add <= m_oldest_first_warps.size() );
+    shd_warp_t* greedy_value = ( m_last_supervised_issued == m_supervised_warps.end() ) ? NULL 
+                                                                                        : *m_last_supervised_issued;
+    if ( num_warps_to_add == m_oldest_first_warps.size() ) {
+        // every warp is in the list, so the order only changes with the greedy warp
+        // or when a warp is initialized
+        if ( PRIORITIZED_ORDER_GREEDY_THEN_OLDEST == m_prioritized_order && greedy_value == m_prioritized_for ) {
+            return;
+        }
+        m_next_cycle_prioritized_warps.clear();
+        if ( greedy_value ) {
+            m_next_cycle_prioritized_warps.push_back( greedy_value );
+        }
+        for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+              iter != m_oldest_first_warps.end(); ++iter ) {
+            if ( *iter != greedy_value ) {
+                m_next_cycle_prioritized_warps.push_back( *iter );
+            }
+        }
+        m_prioritized_order = PRIORITIZED_ORDER_GREEDY_THEN_OLDEST;
+        m_prioritized_for = greedy_value;
+        return;
+    }
+
+    // only num_warps_to_add warps are considered: the oldest warps that are 
+    // neither waiting nor done go first, as with sort_warps_by_oldest_dynamic_id
+    m_prioritized_order = PRIORITIZED_ORDER_NONE;
+    m_next_cycle_prioritized_warps.clear();
+    if ( greedy_value ) {
+        m_next_cycle_prioritized_warps.push_back( greedy_value );
+    }
+    unsigned count = 0;
+    for ( unsigned pass = 0; pass < 2; ++pass ) {
+        for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+              iter != m_oldest_first_warps.end() && count < num_warps_to_add; ++iter ) {
+            bool ready = !( (*iter)->done_exit() || (*iter)->waiting() );
+            if ( ready != ( pass == 0 ) ) {
+                continue;
+            }
+            if ( *iter != greedy_value ) {
+                m_next_cycle_prioritized_warps.push_back( *iter );
+            }
+            ++count;
+        }
+    }
+}
+
+std::map< std::string, scheduler_factory > &scheduler_registry::factories()
+{
+    static std::map< std::string, scheduler_factory > factories;
+    static bool registering = false;
+    if ( !registering ) {
+        registering = true; // add() comes back here
+        register_schedulers();
+    }
+    return factories;
+}
+
+void scheduler_registry::add( const char *name, scheduler_factory factory )
+{
+    if ( !factories().insert( std::make_pair( std::string(name), factory ) ).second ) {
+        printf("GPGPU-Sim uArch: ERROR ** scheduler \"%s\" registered twice\n", name);
+        abort();
+    }
+}
+
+void scheduler_registry::print_names( FILE *fp )
+{
+    std::map< std::string, scheduler_factory >::const_iterator f;
+    for ( f = factories().begin(); f != factories().end(); ++f ) 
+        fprintf(fp, "%s%s", f == factories().begin() ? "" : " | ", f->first.c_str());
+}
+
+scheduler_unit* scheduler_registry::create( shader_core_stats* stats, shader_core_ctx* shader,
+                                            Scoreboard* scoreboard, simt_stack** simt,
+                                            std::vector<shd_warp_t>* warp,
+                                            register_set* sp_out,
+                                            register_set* sfu_out,
+                                            register_set* mem_out,
+                                            int id,
+                                            char* config_string )
+{
+    std::string name = config_string;
+    name = name.substr( 0, name.find(':') );
+    std::map< std::string, scheduler_factory >::const_iterator f = factories().find( name );
+    if ( f == factories().end() ) {
+        printf("GPGPU-Sim uArch: ERROR ** unknown scheduler \"%s\", expected one of < ", config_string);
+        print_names( stdout );
+        printf(" >\n");
+        abort();
+    }
+    return f->second( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id, config_string );
+}
+
 void lrr_scheduler::order_warps()
 {
-    order_lrr( m_next_cycle_prioritized_warps,
-               m_supervised_warps,
-               m_last_supervised_issued,
-               m_supervised_warps.size() );
+    m_shader->set_scheduler_policy_gto(0);
+    order_lrr_supervised();
 }
+REGISTER_SCHEDULER( "lrr", lrr_scheduler );
+
 /**/
+caws_scheduler::caws_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                                 Scoreboard* scoreboard, simt_stack** simt,
+                                 std::vector<shd_warp_t>* warp,
+                                 register_set* sp_out,
+                                 register_set* sfu_out,
+                                 register_set* mem_out,
+                                 int id,
+                                 char* config_string )
+    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id )
+{
+    // plain "caws" is a policy per core every 2000 loads
+    m_epoch = 2000;
+    m_epoch_mode = CAWS_EPOCH_LOADS;
+    unsigned hysteresis = 0;
+    unsigned source = 0;
+    m_num_warps_to_limit = 0;
+    if ( strcmp( config_string, "caws" ) != 0 ) {
+        unsigned mode_readin;
+        int ret = sscanf( config_string,
+                          "caws:%u:%u:%u:%u:%u",
+                          &m_epoch,
+                          &mode_readin,
+                          &hysteresis,
+                          &m_num_warps_to_limit,
+                          &source );
+        if ( (ret != 2 && ret != 4 && ret != 5) || m_epoch == 0 || mode_readin >= NUM_CAWS_EPOCH_MODES || source > 1 ) {
+            printf("GPGPU-Sim uArch: ERROR ** invalid scheduler \"%s\", expected caws:<epoch>:<mode>[:<hysteresis>:<warp_limit>[:<source>]] "
+                   "with <epoch> > 0, <mode> < %u and <source> 0 (locality monitor) or 1 (shadow tags)\n",
+                   config_string, (unsigned)NUM_CAWS_EPOCH_MODES);
+            abort();
+        }
+        m_epoch_mode = (caws_epoch_mode)mode_readin;
+    }
+    assert( m_num_warps_to_limit <= shader->get_config()->max_warps_per_shader );
+    m_epoch_start = 0;
+    m_policy_engine.configure( hysteresis, m_num_warps_to_limit > 0 );
+    shader->caws_policy().configure( hysteresis, m_num_warps_to_limit > 0 );
+    m_shadow_source = source == 1;
+    if ( m_shadow_source ) {
+        const shader_core_config *config = shader->get_config();
+        shader->caws_shadow().configure( config->caws_shadow_sets, config->caws_shadow_window,
+                                         config->m_L1D_config.get_nset(), config->m_L1D_config.get_assoc(),
+                                         config->max_warps_per_shader, stats );
+    }
+}
+
+unsigned long long caws_scheduler::epoch_now() const
+{
+    if ( epoch_in_cycles() ) {
+        return get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle;
+    }
+    if ( per_sched() ) {
+        unsigned long long loads;
+        warp_locality_counts counts;
+        supervised_locality( loads, counts );
+        return loads;
+    }
+    return m_shader->get_LDST_inst();
+}
+
+bool caws_scheduler::epoch_done() const
+{
+    switch ( m_epoch_mode ) {
+    case CAWS_EPOCH_LOADS:
+        // flush_stat() restarts the load count when the policy is selected
+        return m_shader->get_LDST_inst()%m_epoch==0 && m_shader->get_LDST_inst()!=0;
+    case CAWS_EPOCH_CYCLES:
+        // the first scheduler unit selects the policy of the core
+        return m_id == 0 && epoch_now() >= m_epoch_start + m_epoch;
+    default:
+        return epoch_now() >= m_epoch_start + m_epoch;
+    }
+}
+
+caws_policy_engine::caws_policy_engine()
+{
+    gto_num = 0;
+    lrr_num = 0;
+    m_policy = CAWS_POLICY_LRR;
+    m_candidate = CAWS_POLICY_LRR;
+    m_last_winner = CAWS_POLICY_LRR;
+    m_confidence = 0;
+    m_hysteresis = 0;
+    m_throttle = false;
+}
+
+void caws_policy_engine::configure( unsigned hysteresis, bool throttle )
+{
+    m_hysteresis = hysteresis;
+    m_throttle = throttle;
+}
+
+caws_policy caws_policy_engine::epoch( long long intra, long long inter, long long miss_intra, long long miss_inter, bool verbose )
+{
+    caws_policy winner;
+    if(m_throttle && miss_intra > intra + inter + miss_inter){
+        // the warps evict each other's lines before reusing them: neither 
+        // order helps, fewer warps do
+        winner = CAWS_POLICY_THROTTLE;
+    }
+    else if(intra == 0 && miss_intra == 0 && inter == 0 && miss_inter == 0){
+        winner = gto_num > lrr_num ? CAWS_POLICY_GTO : CAWS_POLICY_LRR;
+        if(verbose)
+        printf("gto_num:%d, lrr_num:%d temp:%d \n",gto_num, lrr_num, winner);
+    }
+    else if(inter == 0 && intra == 0){
+        if(miss_inter >= miss_intra){
+            winner = CAWS_POLICY_LRR;
+            lrr_num++;
+        }
+        else{
+            winner = CAWS_POLICY_GTO;
+            gto_num++;
+        }
+    }
+    else if(inter >= intra){
+        assert(inter != 0 && "error: inter and intra is 0!");
+        winner = CAWS_POLICY_LRR;
+        lrr_num++;
+    }
+    else{
+        assert(intra != 0 && "error: inter and intra is 0!");
+        winner = CAWS_POLICY_GTO;
+        gto_num++;
+    }
+    return adopt(winner);
+}
+
+caws_policy caws_policy_engine::epoch_hits( long long loads, long long lrr_hits, long long gto_hits, bool verbose )
+{
+    caws_policy winner;
+    if(loads == 0){
+        winner = gto_num > lrr_num ? CAWS_POLICY_GTO : CAWS_POLICY_LRR;
+    }
+    else if(gto_hits > lrr_hits){
+        winner = CAWS_POLICY_GTO;
+        gto_num++;
+    }
+    else{
+        winner = CAWS_POLICY_LRR;
+        lrr_num++;
+    }
+    if(verbose)
+        printf("shadow loads:%lld lrr_hits:%lld gto_hits:%lld winner:%d\n", loads, lrr_hits, gto_hits, winner);
+    return adopt(winner);
+}
+
+caws_policy caws_policy_engine::adopt( caws_policy winner )
+{
+    m_last_winner = winner;
+    if(winner == m_policy){
+        m_confidence = 0;
+    }
+    else{
+        if(winner == m_candidate){
+            m_confidence++;
+        }
+        else{
+            m_candidate = winner;
+            m_confidence = 1;
+        }
+        if(m_confidence > m_hysteresis){
+            m_policy = winner;
+            m_confidence = 0;
+        }
+    }
+    return m_policy;
+}
+
+void caws_policy_engine::checkpoint( checkpoint_file &cp )
+{
+    cp.pod(gto_num);
+    cp.pod(lrr_num);
+    cp.pod(m_policy);
+    cp.pod(m_candidate);
+    cp.pod(m_last_winner);
+    cp.pod(m_confidence);
+}
+
+caws_shadow_tags::caws_shadow_tags()
+{
+    m_stride = 1;
+    m_sampled_sets = 0;
+    m_assoc = 0;
+    m_window = 0;
+    m_stamp = 0;
+    m_stats = NULL;
+}
+
+void caws_shadow_tags::configure( unsigned sampled_sets, unsigned window, unsigned n_sets, unsigned assoc, 
+                                  unsigned n_warps, shader_core_stats *stats )
+{
+    // every CAWS scheduler unit of the core configures the same estimator
+    if( enabled() )
+        return;
+    m_sampled_sets = MIN( sampled_sets, n_sets );
+    m_stride = n_sets / m_sampled_sets;
+    m_assoc = assoc;
+    m_window = window;
+    m_loads.reserve(window);
+    m_warp_loads.assign(n_warps, 0);
+    m_lrr_tag.assign(m_sampled_sets * assoc, 0);
+    m_gto_tag.assign(m_sampled_sets * assoc, 0);
+    m_lrr_stamp.assign(m_sampled_sets * assoc, 0);
+    m_gto_stamp.assign(m_sampled_sets * assoc, 0);
+    m_stats = stats;
+}
+
+void caws_shadow_tags::access( unsigned set_index, new_addr_type tag, unsigned warp_id, unsigned age, bool hit, bool gto )
+{
+    if( set_index % m_stride || set_index / m_stride >= m_sampled_sets )
+        return;
+    shadow_load l;
+    l.tag = tag;
+    l.set = set_index / m_stride;
+    l.warp_id = warp_id;
+    l.age = age;
+    l.round = m_warp_loads[warp_id]++;
+    l.hit = hit;
+    l.gto = gto;
+    m_loads.push_back(l);
+    if( m_loads.size() == m_window )
+        replay();
+}
+
+bool caws_shadow_tags::lrr_order( const shadow_load &a, const shadow_load &b )
+{
+    return a.round != b.round ? a.round < b.round : a.warp_id < b.warp_id;
+}
+
+bool caws_shadow_tags::gto_order( const shadow_load &a, const shadow_load &b )
+{
+    return a.age < b.age;
+}
+
+bool caws_shadow_tags::shadow_access( std::vector<new_addr_type> &tags, std::vector<unsigned long long> &stamps, 
+                                      unsigned set, new_addr_type tag )
+{
+    unsigned victim = set * m_assoc;
+    for( unsigned i = set * m_assoc; i < (set + 1) * m_assoc; i++ ) {
+        if( stamps[i] && tags[i] == tag ) {
+            stamps[i] = ++m_stamp;
+            return true;
+        }
+        if( stamps[i] < stamps[victim] ) 
+            victim = i;
+    }
+    tags[victim] = tag;
+    stamps[victim] = ++m_stamp;
+    return false;
+}
+
+void caws_shadow_tags::replay()
+{
+    // both orders keep the loads of a warp in program order
+    std::stable_sort( m_loads.begin(), m_loads.end(), lrr_order );
+    for( unsigned i = 0; i < m_loads.size(); i++ ) {
+        const shadow_load &l = m_loads[i];
+        bool lrr_hit = shadow_access( m_lrr_tag, m_lrr_stamp, l.set, l.tag );
+        m_counts.lrr_hits += lrr_hit;
+        m_counts.loads++;
+        m_stats->caws_shadow_loads[l.gto]++;
+        m_stats->caws_shadow_hits[l.gto] += l.hit;
+        if( !l.gto )
+            m_stats->caws_shadow_predicted_hits[0] += lrr_hit;
+    }
+    std::stable_sort( m_loads.begin(), m_loads.end(), gto_order );
+    for( unsigned i = 0; i < m_loads.size(); i++ ) {
+        const shadow_load &l = m_loads[i];
+        bool gto_hit = shadow_access( m_gto_tag, m_gto_stamp, l.set, l.tag );
+        m_counts.gto_hits += gto_hit;
+        if( l.gto )
+            m_stats->caws_shadow_predicted_hits[1] += gto_hit;
+    }
+    m_loads.clear();
+    std::fill( m_warp_loads.begin(), m_warp_loads.end(), 0 );
+}
+
+caws_shadow_counts caws_shadow_tags::epoch_counts()
+{
+    caws_shadow_counts c;
+    c.loads = m_counts.loads - m_epoch_start.loads;
+    c.lrr_hits = m_counts.lrr_hits - m_epoch_start.lrr_hits;
+    c.gto_hits = m_counts.gto_hits - m_epoch_start.gto_hits;
+    m_epoch_start = m_counts;
+    return c;
+}
+
+void caws_shadow_tags::checkpoint( checkpoint_file &cp )
+{
+    cp.check_size(m_window, "CAWS shadow tag window");
+    cp.check_size(m_lrr_tag.size(), "CAWS shadow tags");
+    cp.vector(m_loads);
+    cp.vector(m_warp_loads);
+    cp.vector(m_lrr_tag);
+    cp.vector(m_gto_tag);
+    cp.vector(m_lrr_stamp);
+    cp.vector(m_gto_stamp);
+    cp.pod(m_stamp);
+    cp.pod(m_counts);
+    cp.pod(m_epoch_start);
+}
+
+void caws_scheduler::record_epoch( const caws_policy_engine &engine, caws_policy previous )
+{
+    m_stats->caws_epoch_policy[engine.policy()]++;
+    if ( engine.policy() != previous ) {
+        m_stats->caws_policy_switches++;
+    } else if ( engine.last_winner() != previous ) {
+        m_stats->caws_switches_held++;
+    }
+}
+
+caws_policy caws_scheduler::policy() const
+{
+    return per_sched() ? m_policy_engine.policy() : m_shader->caws_policy().policy();
+}
+
+void caws_scheduler::supervised_locality( unsigned long long &loads, warp_locality_counts &counts ) const
+{
+    // warps are distributed over the scheduler units by warp id, so with an 
+    // even number of units every warp of this one has the parity of m_id
+    bool one_parity = m_shader->get_config()->gpgpu_num_sched_per_core % 2 == 0;
+    loads = 0;
+    counts.clear();
+    for ( unsigned parity = 0; parity < 2; parity++ ) {
+        if ( one_parity && parity != (unsigned)m_id % 2 ) {
+            continue;
+        }
+        const warp_locality_counts &c = m_shader->get_parity_locality(parity);
+        loads += m_shader->get_parity_loads(parity);
+        counts.intra += c.intra;
+        counts.inter += c.inter;
+        counts.miss_intra += c.miss_intra;
+        counts.miss_inter += c.miss_inter;
+    }
+}
+
+void caws_scheduler::per_sched_epoch()
+{
+    unsigned long long loads;
+    warp_locality_counts counts;
+    supervised_locality( loads, counts );
+    long long intra = counts.intra - m_epoch_locality.intra;
+    long long inter = counts.inter - m_epoch_locality.inter;
+    long long miss_intra = counts.miss_intra - m_epoch_locality.miss_intra;
+    long long miss_inter = counts.miss_inter - m_epoch_locality.miss_inter;
+    caws_policy previous = m_policy_engine.policy();
+    bool verbose = m_shader->get_config()->caws_verbose && m_shader->get_sid()==0;
+    if ( m_shadow_source ) {
+        // the estimates cover the loads of every warp of the core
+        const caws_shadow_counts &shadow = m_shader->caws_shadow().counts();
+        m_policy_engine.epoch_hits( shadow.loads - m_epoch_shadow.loads, shadow.lrr_hits - m_epoch_shadow.lrr_hits, 
+                                    shadow.gto_hits - m_epoch_shadow.gto_hits, verbose );
+        m_epoch_shadow = shadow;
+    } else {
+        m_policy_engine.epoch( intra, inter, miss_intra, miss_inter, verbose );
+    }
+    record_epoch( m_policy_engine, previous );
+    if(verbose){
+        printf("gpu_sim_cycle:%llu scheduler:%d loads:%llu\n",get_gpu()->gpu_sim_cycle,m_id,loads);
+        printf("Intra:%lld Inter:%lld Miss_intra:%lld Miss_inter:%lld Switch: policy:%d\n",intra,inter,miss_intra,miss_inter,m_policy_engine.policy());
+    }
+    m_epoch_locality = counts;
+    if ( epoch_in_cycles() ) {
+        unsigned long long now = epoch_now();
+        m_epoch_start = now - (now - m_epoch_start) % m_epoch;
+    } else {
+        m_epoch_start = loads;
+    }
+}
+
 template < class T >
 void caws_scheduler::caws_order_by_priority( std::vector< T >& result_list,
                             const typename std::vector< T >& input_list,
@@ -1015,93 +1940,87 @@ void caws_scheduler::caws_order_by_priority( std::vector< T >& result_list,
                             bool (*priority_func)(T lhs, T rhs) )
 {
     assert( num_warps_to_add <= input_list.size() );
-    result_list.clear();
-    typename std::vector< T > temp = input_list;
 
+    if( per_sched() ){
+        if( epoch_done() )
+            per_sched_epoch();
+    }
     //if((m_shader->m_ldst_unit->m_LDU->LDST_inst%2000)==0 && m_shader->m_ldst_unit->m_LDU->LDST_inst!=0){
-    if(m_shader->get_LDST_inst()%2000==0 && m_shader->get_LDST_inst()!=0){
+    else if( epoch_done() ){
         //m_shader->m_ldst_unit->m_LDU->judge_locality();
         int intra = m_shader->get_intra_warp_locality();
         int inter = m_shader->get_inter_warp_locality();
         int miss_intra = m_shader->get_miss_intra_warp_locality();
         int miss_inter = m_shader->get_miss_inter_warp_locality();
         assert((intra != -1 || inter != -1) && "\nno m_ldst_unit!");
-        if(intra == 0 && miss_intra == 0 && inter == 0 && miss_inter == 0){
-            int temp = m_shader->gto_num > m_shader->lrr_num ? 1:0;
-            if(m_shader->get_sid()==0)
-            printf("gto_num:%d, lrr_num:%d temp:%d \n",m_shader->gto_num, m_shader->lrr_num, temp);
-            m_shader->set_scheduler_policy_gto(temp);
-        }
-        else if(inter == 0 && intra == 0){
-            if(miss_inter >= miss_intra){
-                m_shader->set_scheduler_policy_gto(0);
-                m_shader->lrr_num++;
-            }
-            else{
-                m_shader->set_scheduler_policy_gto(1);
-                m_shader->gto_num++;
-            }
-        }
-        else if(inter >= intra){
-            assert(inter != 0 && "error: inter and intra is 0!");
-            m_shader->set_scheduler_policy_gto(0);
-            m_shader->lrr_num++;
-        }
-        else{
-            assert(intra != 0 && "error: inter and intra is 0!");
-            m_shader->set_scheduler_policy_gto(1);
-            m_shader->gto_num++;
+        caws_policy_engine &engine = m_shader->caws_policy();
+        caws_policy previous = engine.policy();
+        bool verbose = m_shader->get_config()->caws_verbose && m_shader->get_sid()==0;
+        if( m_shadow_source ){
+            caws_shadow_counts shadow = m_shader->caws_shadow().epoch_counts();
+            engine.epoch_hits( shadow.loads, shadow.lrr_hits, shadow.gto_hits, verbose );
         }
+        else
+            engine.epoch( intra, inter, miss_intra, miss_inter, verbose );
+        record_epoch( engine, previous );
+        m_shader->set_scheduler_policy_gto( engine.policy() != CAWS_POLICY_LRR );
       
-        if(m_shader->get_sid()==0){
+        if(verbose){
             //printf("shader_id:%d\n",m_shader->get_sid());
-            printf("gpu_sim_cycle:%llu cache_hit:%d cache_miss:%d LDST_inst:%d \n",gpu_sim_cycle,m_shader->get_L1Dcache_hit_num(),m_shader->get_L1Dcache_miss_num(),m_shader->get_LDST_inst());
+            printf("gpu_sim_cycle:%llu cache_hit:%d cache_miss:%d LDST_inst:%d \n",get_gpu()->gpu_sim_cycle,m_shader->get_L1Dcache_hit_num(),m_shader->get_L1Dcache_miss_num(),m_shader->get_LDST_inst());
             printf("m_intra:%d m_inter:%d m_miss_intra:%d m_miss_inter:%d\n",m_shader->get_intra_warp_locality(),m_shader->get_inter_warp_locality(),
             m_shader->get_miss_intra_warp_locality(), m_shader->get_miss_inter_warp_locality());
             printf("Intra:%d Inter:%d Switch: LDU_GTO:%d\n",intra, inter, m_shader->scheduler_policy_gto());
         }
         m_shader->flush_stat();
+        if( epoch_in_cycles() ){
+            unsigned long long now = epoch_now();
+            m_epoch_start = now - (now - m_epoch_start) % m_epoch;
+        }
     }
     // int rand_num = rand();
     // if( rand_num%2==0){
-    if(m_shader->scheduler_policy_gto()==0){
+    caws_policy current = policy();
+    if(current == CAWS_POLICY_LRR){
         //printf("m_shader->m_LDU->uid:%d\n",m_shader->m_LDU->uid);
-        typename std::vector< T >::const_iterator iter
-        = ( last_issued_from_input ==  input_list.end() ) ? input_list.begin()
-                                                          : last_issued_from_input + 1; //上一个发射是 end，跳转到 begin, 否则+1
-        for ( unsigned count = 0;
-          count < num_warps_to_add;
-          ++iter, ++count) {
-        if ( iter ==  input_list.end() ) {
-            iter = input_list.begin();
-        }
-        result_list.push_back( *iter );
-        }
+        // caws_scheduler::order_warps() orders all of m_supervised_warps
+        assert( num_warps_to_add == m_supervised_warps.size() );
+        order_lrr_supervised();
     }
     else{
-        if ( ORDERING_GREEDY_THEN_PRIORITY_FUNC == ordering ) {
-            T greedy_value = *last_issued_from_input;
-            result_list.push_back( greedy_value );
-
-            std::sort( temp.begin(), temp.end(), priority_func );
-            typename std::vector< T >::iterator iter = temp.begin();
-            for ( unsigned count = 0; count < num_warps_to_add; ++count, ++iter ) {
-                if ( *iter != greedy_value ) {
-                    result_list.push_back( *iter );
-                }
-            }
-        } else if ( ORDERED_PRIORITY_FUNC_ONLY == ordering ) {
-            std::sort( temp.begin(), temp.end(), priority_func );
-            typename std::vector< T >::iterator iter = temp.begin();
-            for ( unsigned count = 0; count < num_warps_to_add; ++count, ++iter ) {
-                result_list.push_back( *iter );
-            }
-        } else {
-            fprintf( stderr, "Unknown ordering - %d\n", ordering );
-            abort();
-        }
+        // caws_scheduler::order_warps() orders m_supervised_warps greedy then oldest
+        assert( ORDERING_GREEDY_THEN_PRIORITY_FUNC == ordering );
+        assert( priority_func == scheduler_unit::sort_warps_by_oldest_dynamic_id );
+        if(current == CAWS_POLICY_THROTTLE)
+            num_warps_to_add = MIN( m_num_warps_to_limit, num_warps_to_add );
+        order_greedy_then_oldest( num_warps_to_add );
+    }
+}
+
+int caws_scheduler::scheduler_policy_gto() const
+{
+    return per_sched() ? m_policy_engine.policy() != CAWS_POLICY_LRR : scheduler_unit::scheduler_policy_gto();
+}
+
+bool caws_scheduler::order_warps_is_stateless() const
+{
+    // a cycle epoch can end while the core is stalled
+    if ( epoch_in_cycles() ) {
+        return false;
     }
+    // a load epoch ends, re-selecting the policy, at the first call after 
+    // its last load
+    return !epoch_done();
+}
+
+void caws_scheduler::checkpoint( checkpoint_file &cp )
+{
+    cp.pod(m_epoch_start);
+    m_policy_engine.checkpoint(cp);
+    cp.pod(m_epoch_locality);
+    cp.pod(m_epoch_shadow);
 }
+
 void caws_scheduler::order_warps()
 {
     caws_order_by_priority( m_next_cycle_prioritized_warps,
@@ -1111,17 +2030,17 @@ void caws_scheduler::order_warps()
                        ORDERING_GREEDY_THEN_PRIORITY_FUNC,
                        scheduler_unit::sort_warps_by_oldest_dynamic_id );
 }
+REGISTER_SCHEDULER( "caws", caws_scheduler );
+
 /*cory*/
 
 void gto_scheduler::order_warps()
 {
-    order_by_priority( m_next_cycle_prioritized_warps,
-                       m_supervised_warps,
-                       m_last_supervised_issued,
-                       m_supervised_warps.size(),
-                       ORDERING_GREEDY_THEN_PRIORITY_FUNC,
-                       scheduler_unit::sort_warps_by_oldest_dynamic_id );
+    m_shader->set_scheduler_policy_gto(1);
+    order_greedy_then_oldest( m_supervised_warps.size() );
 }
+REGISTER_SCHEDULER( "gto", gto_scheduler );
+
 
 void
 two_level_active_scheduler::do_on_warp_issued( unsigned warp_id,
@@ -1144,22 +2063,22 @@ two_level_active_scheduler::do_on_warp_issued( unsigned warp_id,
     }
 }
 
+void two_level_active_scheduler::checkpoint_warps( checkpoint_file &cp )
+{
+    scheduler_unit::checkpoint_warps( cp );
+    std::vector< shd_warp_t* > pending( m_pending_warps.begin(), m_pending_warps.end() );
+    checkpoint_warp_list( cp, pending );
+    if ( !cp.saving() ) 
+        m_pending_warps.assign( pending.begin(), pending.end() );
+}
+
 void two_level_active_scheduler::order_warps()
 {
     //Move waiting warps to m_pending_warps
     unsigned num_demoted = 0;
     for (   std::vector< shd_warp_t* >::iterator iter = m_next_cycle_prioritized_warps.begin();
             iter != m_next_cycle_prioritized_warps.end(); ) {
-        bool waiting = (*iter)->waiting();
-        for (int i=0; i<4; i++){
-            const warp_inst_t* inst = (*iter)->ibuffer_next_inst();
-            //Is the instruction waiting on a long operation?
-            if ( inst && inst->in[i] > 0 && this->m_scoreboard->islongop((*iter)->get_warp_id(), inst->in[i])){
-                waiting = true;
-            }
-        }
-
-        if( waiting ) {
+        if( stalled_on_long_op(*iter) ) {
             m_pending_warps.push_back(*iter);
             iter = m_next_cycle_prioritized_warps.erase(iter);
             SCHED_DPRINTF( "DEMOTED warp_id=%d, dynamic_warp_id=%d\n",
@@ -1190,44 +2109,412 @@ void two_level_active_scheduler::order_warps()
     }
     assert( num_promoted == num_demoted );
 }
+REGISTER_SCHEDULER( "two_level_active", two_level_active_scheduler );
+
+
+swl_scheduler::swl_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                               Scoreboard* scoreboard, simt_stack** simt,
+                               std::vector<shd_warp_t>* warp,
+                               register_set* sp_out,
+                               register_set* sfu_out,
+                               register_set* mem_out,
+                               int id,
+                               char* config_string )
+    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id )
+{
+    unsigned m_prioritization_readin;
+    int ret = sscanf( config_string,
+                      "warp_limiting:%d:%d",
+                      &m_prioritization_readin,
+                      &m_num_warps_to_limit
+                     );
+    assert( 2 == ret );
+    m_prioritization = (scheduler_prioritization_type)m_prioritization_readin;
+    // Currently only GTO is implemented
+    assert( m_prioritization == SCHEDULER_PRIORITIZATION_GTO );
+    assert( m_num_warps_to_limit <= shader->get_config()->max_warps_per_shader );
+}
+
+void swl_scheduler::order_warps()
+{
+    if ( SCHEDULER_PRIORITIZATION_GTO == m_prioritization ) {
+        m_shader->set_scheduler_policy_gto(1);
+        order_greedy_then_oldest( MIN( m_num_warps_to_limit, m_supervised_warps.size() ) );
+    } else {
+        fprintf(stderr, "swl_scheduler m_prioritization = %d\n", m_prioritization);
+        abort();
+    }
+}
+REGISTER_SCHEDULER( "warp_limiting", swl_scheduler );
+
+
+ccws_scheduler::ccws_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                                 Scoreboard* scoreboard, simt_stack** simt,
+                                 std::vector<shd_warp_t>* warp,
+                                 register_set* sp_out,
+                                 register_set* sfu_out,
+                                 register_set* mem_out,
+                                 int id,
+                                 char* config_string )
+    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ),
+      m_victim_tags(NULL)
+{
+    // plain "ccws" is 8 victim tags per warp, k_throttle 100 and base score 100
+    m_vta_entries = 8;
+    m_k_throttle = 100;
+    m_base_score = 100;
+    if ( strcmp( config_string, "ccws" ) != 0 ) {
+        int ret = sscanf( config_string,
+                          "ccws:%u:%u:%u",
+                          &m_vta_entries,
+                          &m_k_throttle,
+                          &m_base_score );
+        if ( ret != 3 || m_vta_entries == 0 || m_base_score == 0 ) {
+            printf("GPGPU-Sim uArch: ERROR ** invalid scheduler \"%s\", expected ccws:<vta_entries>:<k_throttle>:<base_score> "
+                   "with <vta_entries> > 0 and <base_score> > 0\n",
+                   config_string);
+            abort();
+        }
+    }
+    m_load_allowed.resize( shader->get_config()->max_warps_per_shader, true );
+}
+
+void ccws_scheduler::function_units_created()
+{
+    // the schedulers of a core share the victim tags of its L1D
+    m_victim_tags = m_shader->enable_L1D_victim_tags( m_vta_entries, m_base_score, m_k_throttle );
+    if ( m_victim_tags == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** the ccws scheduler requires an L1 data cache (-gpgpu_cache:dl1)\n");
+        abort();
+    }
+}
+
+void ccws_scheduler::checkpoint_warps( checkpoint_file &cp )
+{
+    scheduler_unit::checkpoint_warps( cp );
+    cp.check_size( m_load_allowed.size(), "ccws load throttle" );
+    for ( unsigned w = 0; w < m_load_allowed.size(); w++ ) {
+        bool allowed = m_load_allowed[w];
+        cp.pod(allowed);
+        m_load_allowed[w] = allowed;
+    }
+}
+
+void ccws_scheduler::order_warps()
+{
+    m_shader->set_scheduler_policy_gto(1);
+    order_greedy_then_oldest( m_supervised_warps.size() );
+    update_load_allowed();
+}
+
+static bool ccws_sort_by_score( const std::pair<unsigned,shd_warp_t*> &lhs, 
+                                const std::pair<unsigned,shd_warp_t*> &rhs )
+{
+    if ( lhs.first != rhs.first ) 
+        return lhs.first > rhs.first;
+    return lhs.second->get_dynamic_warp_id() < rhs.second->get_dynamic_warp_id();
+}
+
+void ccws_scheduler::update_load_allowed()
+{
+    unsigned time = get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle;
+    unsigned total = 0;
+    m_scored_warps.clear();
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_supervised_warps.begin();
+          iter != m_supervised_warps.end();
+          iter++ ) {
+        if ( (*iter)->done_exit() ) 
+            continue;
+        unsigned score = m_victim_tags->score( (*iter)->get_warp_id(), time );
+        m_scored_warps.push_back( std::make_pair( score, *iter ) );
+        total += score;
+    }
+    unsigned cutoff = m_scored_warps.size() * m_base_score;
+    if ( total <= cutoff ) {
+        // no warp has lost locality, nothing is throttled
+        for ( unsigned i = 0; i < m_scored_warps.size(); i++ ) 
+            m_load_allowed[m_scored_warps[i].second->get_warp_id()] = true;
+        return;
+    }
+    std::sort( m_scored_warps.begin(), m_scored_warps.end(), ccws_sort_by_score );
+    unsigned cumulative = 0;
+    for ( unsigned i = 0; i < m_scored_warps.size(); i++ ) {
+        // the warp that crosses the cutoff is still admitted
+        m_load_allowed[m_scored_warps[i].second->get_warp_id()] = cumulative <= cutoff;
+        cumulative += m_scored_warps[i].first;
+    }
+}
+
+bool ccws_scheduler::memory_inst_allowed( unsigned warp_id, const warp_inst_t *pI )
+{
+    if ( pI->op != LOAD_OP || 
+         ((pI->space.get_type() != global_space) && (pI->space.get_type() != local_space)) ) 
+        return true;
+    if ( m_load_allowed[warp_id] ) 
+        return true;
+    m_stats->ccws_throttled_loads++;
+    return false;
+}
+REGISTER_SCHEDULER( "ccws", ccws_scheduler );
+
+
+void cta_aware_scheduler::checkpoint_warps( checkpoint_file &cp )
+{
+    scheduler_unit::checkpoint_warps( cp );
+    cp.pod(m_active_cta);
+    cp.pod(m_active_cta_last_warp);
+}
+
+void cta_aware_scheduler::order_warps()
+{
+    m_shader->set_scheduler_policy_gto(1);
+    // the warps of a CTA are initialized together, so m_oldest_first_warps 
+    // holds the live warps grouped by CTA, oldest CTA first
+    bool active_cta_live = false;
+    bool active_cta_stalled = true;
+    unsigned oldest_unstalled_cta = NO_ACTIVE_CTA;
+    unsigned oldest_cta = NO_ACTIVE_CTA;
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+          iter != m_oldest_first_warps.end(); ++iter ) {
+        if ( (*iter)->done_exit() ) 
+            continue;
+        unsigned cta = (*iter)->get_cta_id();
+        if ( oldest_cta == NO_ACTIVE_CTA ) 
+            oldest_cta = cta;
+        bool stalled = stalled_on_long_op(*iter);
+        if ( in_active_cta(*iter) ) {
+            active_cta_live = true;
+            active_cta_stalled = active_cta_stalled && stalled;
+        }
+        if ( !stalled && oldest_unstalled_cta == NO_ACTIVE_CTA ) 
+            oldest_unstalled_cta = cta;
+    }
+    if ( !active_cta_live || (active_cta_stalled && oldest_unstalled_cta != NO_ACTIVE_CTA) ) {
+        unsigned next_cta = oldest_unstalled_cta != NO_ACTIVE_CTA ? oldest_unstalled_cta : oldest_cta;
+        if ( (next_cta != m_active_cta || !active_cta_live) && next_cta != NO_ACTIVE_CTA ) 
+            m_stats->cta_aware_group_switches++;
+        m_active_cta = next_cta;
+        m_active_cta_last_warp = 0;
+        for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+              iter != m_oldest_first_warps.end(); ++iter ) {
+            if ( !(*iter)->done_exit() && (*iter)->get_cta_id() == m_active_cta ) 
+                m_active_cta_last_warp = std::max( m_active_cta_last_warp, (*iter)->get_dynamic_warp_id() );
+        }
+    }
+
+    m_prioritized_order = PRIORITIZED_ORDER_NONE;
+    m_next_cycle_prioritized_warps.clear();
+    shd_warp_t* greedy_value = ( m_last_supervised_issued == m_supervised_warps.end() ) ? NULL 
+                                                                                        : *m_last_supervised_issued;
+    if ( greedy_value && !in_active_cta(greedy_value) ) 
+        greedy_value = NULL;
+    if ( greedy_value ) 
+        m_next_cycle_prioritized_warps.push_back( greedy_value );
+    for ( unsigned pass = 0; pass < 2; ++pass ) {
+        for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+              iter != m_oldest_first_warps.end(); ++iter ) {
+            if ( in_active_cta(*iter) == ( pass == 0 ) && *iter != greedy_value ) 
+                m_next_cycle_prioritized_warps.push_back( *iter );
+        }
+    }
+}
+REGISTER_SCHEDULER( "cta_aware", cta_aware_scheduler );
+
+
+barrier_aware_scheduler::barrier_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                                                   Scoreboard* scoreboard, simt_stack** simt,
+                                                   std::vector<shd_warp_t>* warp,
+                                                   register_set* sp_out,
+                                                   register_set* sfu_out,
+                                                   register_set* mem_out,
+                                                   int id,
+                                                   char* config_string )
+    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id )
+{
+    m_boosted.resize( shader->get_config()->max_warps_per_shader, false );
+    m_cta_max_committed.resize( shader->get_config()->max_cta_per_core, 0 );
+}
+
+bool barrier_aware_scheduler::lagging_warp::operator<( const lagging_warp &rhs ) const
+{
+    if ( deficit != rhs.deficit ) 
+        return deficit > rhs.deficit;
+    if ( stalled != rhs.stalled ) 
+        return stalled > rhs.stalled;
+    return warp->get_dynamic_warp_id() < rhs.warp->get_dynamic_warp_id();
+}
+
+void barrier_aware_scheduler::order_warps()
+{
+    m_shader->set_scheduler_policy_gto(1);
+    for ( unsigned i = 0; i < m_lagging_warps.size(); i++ ) 
+        m_boosted[m_lagging_warps[i].warp->get_warp_id()] = false;
+    m_lagging_warps.clear();
+    if ( !m_shader->any_warp_waiting_at_barrier() ) {
+        order_greedy_then_oldest( m_supervised_warps.size() );
+        return;
+    }
+
+    // the most advanced warp of each CTA, including those of the other schedulers
+    std::fill( m_cta_max_committed.begin(), m_cta_max_committed.end(), 0 );
+    for ( std::vector<shd_warp_t>::const_iterator w = m_warp->begin(); w != m_warp->end(); ++w ) {
+        if ( !w->done_exit() ) 
+            m_cta_max_committed[w->get_cta_id()] = MAX( m_cta_max_committed[w->get_cta_id()], w->get_n_committed() );
+    }
+    unsigned long long now = get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle;
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_supervised_warps.begin();
+          iter != m_supervised_warps.end(); ++iter ) {
+        shd_warp_t *w = *iter;
+        if ( w->done_exit() || m_shader->warp_waiting_at_barrier( w->get_warp_id() ) || 
+             !m_shader->cta_waiting_at_barrier( w->get_cta_id() ) ) 
+            continue;
+        lagging_warp lagging;
+        lagging.deficit = m_cta_max_committed[w->get_cta_id()] - w->get_n_committed();
+        lagging.stalled = now - w->get_last_issue_cycle();
+        lagging.warp = w;
+        m_lagging_warps.push_back( lagging );
+        m_boosted[w->get_warp_id()] = true;
+    }
+    if ( m_lagging_warps.empty() ) {
+        // the warps at the barrier wait for the warps of the other schedulers
+        order_greedy_then_oldest( m_supervised_warps.size() );
+        return;
+    }
+    std::sort( m_lagging_warps.begin(), m_lagging_warps.end() );
+
+    m_prioritized_order = PRIORITIZED_ORDER_NONE;
+    m_next_cycle_prioritized_warps.clear();
+    for ( unsigned i = 0; i < m_lagging_warps.size(); i++ ) 
+        m_next_cycle_prioritized_warps.push_back( m_lagging_warps[i].warp );
+    shd_warp_t* greedy_value = ( m_last_supervised_issued == m_supervised_warps.end() ) ? NULL 
+                                                                                        : *m_last_supervised_issued;
+    if ( greedy_value && !m_boosted[greedy_value->get_warp_id()] ) 
+        m_next_cycle_prioritized_warps.push_back( greedy_value );
+    for ( std::vector< shd_warp_t* >::const_iterator iter = m_oldest_first_warps.begin();
+          iter != m_oldest_first_warps.end(); ++iter ) {
+        if ( *iter != greedy_value && !m_boosted[(*iter)->get_warp_id()] ) 
+            m_next_cycle_prioritized_warps.push_back( *iter );
+    }
+}
+
+void barrier_aware_scheduler::do_on_warp_issued( unsigned warp_id,
+                                                 unsigned num_issued,
+                                                 const std::vector< shd_warp_t* >::const_iterator& prioritized_iter )
+{
+    scheduler_unit::do_on_warp_issued( warp_id, num_issued, prioritized_iter );
+    if ( m_boosted[warp_id] ) 
+        m_stats->barrier_boosted_issues++;
+}
+REGISTER_SCHEDULER( "barrier_aware", barrier_aware_scheduler );
+
+
+void prefetch_aware_scheduler::order_warps()
+{
+    // the prefetcher only predicts trailing warps under LRR
+    m_shader->set_scheduler_policy_gto(0);
+    order_lrr_supervised();
+    bool reordered = false;
+    unsigned filled = 0;
+    m_in_flight_warps.clear();
+    for ( unsigned i = 0; i < m_next_cycle_prioritized_warps.size(); i++ ) {
+        shd_warp_t *w = m_next_cycle_prioritized_warps[i];
+        switch ( w->done_exit() ? PREFETCH_TARGET_NONE : m_shader->prefetch_target( w->get_warp_id() ) ) {
+        case PREFETCH_TARGET_FILLED:
+            // promote, keeping the LRR order among the promoted warps
+            std::rotate( m_next_cycle_prioritized_warps.begin() + filled, 
+                         m_next_cycle_prioritized_warps.begin() + i, 
+                         m_next_cycle_prioritized_warps.begin() + i + 1 );
+            filled++;
+            reordered = true;
+            break;
+        case PREFETCH_TARGET_IN_FLIGHT:
+            m_in_flight_warps.push_back( w );
+            break;
+        default:
+            break;
+        }
+    }
+    if ( !m_in_flight_warps.empty() ) {
+        for ( unsigned i = 0; i < m_in_flight_warps.size(); i++ ) {
+            m_next_cycle_prioritized_warps.erase( std::find( m_next_cycle_prioritized_warps.begin(), 
+                                                             m_next_cycle_prioritized_warps.end(), 
+                                                             m_in_flight_warps[i] ) );
+        }
+        m_next_cycle_prioritized_warps.insert( m_next_cycle_prioritized_warps.end(), 
+                                               m_in_flight_warps.begin(), m_in_flight_warps.end() );
+        reordered = true;
+    }
+    if ( reordered ) 
+        m_prioritized_order = PRIORITIZED_ORDER_NONE;
+}
+REGISTER_SCHEDULER( "prefetch_aware", prefetch_aware_scheduler );
+
+
+divergence_aware_scheduler::divergence_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                                                         Scoreboard* scoreboard, simt_stack** simt,
+                                                         std::vector<shd_warp_t>* warp,
+                                                         register_set* sp_out,
+                                                         register_set* sfu_out,
+                                                         register_set* mem_out,
+                                                         int id,
+                                                         char* config_string )
+    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id )
+{
+    // plain "divergence_aware" is divergence_aware:75:25
+    m_busy_pct = 75;
+    m_idle_pct = 25;
+    if ( strcmp( config_string, "divergence_aware" ) != 0 ) {
+        int ret = sscanf( config_string,
+                          "divergence_aware:%u:%u",
+                          &m_busy_pct,
+                          &m_idle_pct );
+        if ( ret != 2 || m_busy_pct > 100 || m_idle_pct >= m_busy_pct ) {
+            printf("GPGPU-Sim uArch: ERROR ** invalid scheduler \"%s\", expected divergence_aware:<busy_pct>:<idle_pct> "
+                   "with <idle_pct> < <busy_pct> <= 100\n",
+                   config_string);
+            abort();
+        }
+    }
+}
 
-swl_scheduler::swl_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
-                               Scoreboard* scoreboard, simt_stack** simt,
-                               std::vector<shd_warp_t>* warp,
-                               register_set* sp_out,
-                               register_set* sfu_out,
-                               register_set* mem_out,
-                               int id,
-                               char* config_string )
-    : scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id )
+// ties go to the oldest warp, so std::sort gives the order a stable sort of 
+// m_oldest_first_warps would without allocating a buffer every cycle
+bool divergence_aware_scheduler::sort_warps_by_fewest_transactions( shd_warp_t* lhs, shd_warp_t* rhs )
 {
-    unsigned m_prioritization_readin;
-    int ret = sscanf( config_string,
-                      "warp_limiting:%d:%d",
-                      &m_prioritization_readin,
-                      &m_num_warps_to_limit
-                     );
-    assert( 2 == ret );
-    m_prioritization = (scheduler_prioritization_type)m_prioritization_readin;
-    // Currently only GTO is implemented
-    assert( m_prioritization == SCHEDULER_PRIORITIZATION_GTO );
-    assert( m_num_warps_to_limit <= shader->get_config()->max_warps_per_shader );
+    if ( lhs->get_avg_load_transactions() != rhs->get_avg_load_transactions() ) 
+        return lhs->get_avg_load_transactions() < rhs->get_avg_load_transactions();
+    return lhs->get_dynamic_warp_id() < rhs->get_dynamic_warp_id();
 }
 
-void swl_scheduler::order_warps()
+bool divergence_aware_scheduler::sort_warps_by_most_transactions( shd_warp_t* lhs, shd_warp_t* rhs )
 {
-    if ( SCHEDULER_PRIORITIZATION_GTO == m_prioritization ) {
-        order_by_priority( m_next_cycle_prioritized_warps,
-                           m_supervised_warps,
-                           m_last_supervised_issued,
-                           MIN( m_num_warps_to_limit, m_supervised_warps.size() ),
-                           ORDERING_GREEDY_THEN_PRIORITY_FUNC,
-                           scheduler_unit::sort_warps_by_oldest_dynamic_id );
-    } else {
-        fprintf(stderr, "swl_scheduler m_prioritization = %d\n", m_prioritization);
-        abort();
+    if ( lhs->get_avg_load_transactions() != rhs->get_avg_load_transactions() ) 
+        return lhs->get_avg_load_transactions() > rhs->get_avg_load_transactions();
+    return lhs->get_dynamic_warp_id() < rhs->get_dynamic_warp_id();
+}
+
+void divergence_aware_scheduler::order_warps()
+{
+    m_shader->set_scheduler_policy_gto(1);
+    unsigned utilization = m_shader->L1D_miss_resource_utilization();
+    divergence_aware_mode mode = utilization >= m_busy_pct ? DIVERGENCE_AWARE_COALESCED_FIRST :
+                                 utilization <= m_idle_pct ? DIVERGENCE_AWARE_DIVERGENT_FIRST :
+                                 DIVERGENCE_AWARE_GTO;
+    m_stats->divergence_aware_cycles[mode]++;
+    if ( mode == DIVERGENCE_AWARE_GTO ) {
+        order_greedy_then_oldest( m_supervised_warps.size() );
+        return;
     }
+    // oldest first among warps with the same average; the vector keeps its 
+    // capacity, so neither the copy nor the sort allocates
+    m_prioritized_order = PRIORITIZED_ORDER_NONE;
+    m_next_cycle_prioritized_warps = m_oldest_first_warps;
+    std::sort( m_next_cycle_prioritized_warps.begin(), m_next_cycle_prioritized_warps.end(),
+               mode == DIVERGENCE_AWARE_COALESCED_FIRST ? sort_warps_by_fewest_transactions 
+                                                        : sort_warps_by_most_transactions );
 }
+REGISTER_SCHEDULER( "divergence_aware", divergence_aware_scheduler );
+
 
 void shader_core_ctx::read_operands()
 {
@@ -1245,7 +2532,7 @@ unsigned shader_core_ctx::translate_local_memaddr( address_type localaddr, unsig
    // need to be mapped to a shared address space for timing simulation.  We do that mapping here.
 
    address_type thread_base = 0;
-   unsigned max_concurrent_threads=0;
+   unsigned max_concurrent_threads = local_mem_word_stride(num_shader)/4;
    if (m_config->gpgpu_local_mem_map) {
       // Dnew = D*N + T%nTpC + nTpC*C
       // N = nTpC*nCpS*nS (max concurent threads)
@@ -1261,12 +2548,10 @@ unsigned shader_core_ctx::translate_local_memaddr( address_type localaddr, unsig
       // then by successive CTA in same shader core
       thread_base = 4*(kernel_padded_threads_per_cta * (m_sid + num_shader * (tid / kernel_padded_threads_per_cta))
                        + tid % kernel_padded_threads_per_cta); 
-      max_concurrent_threads = kernel_padded_threads_per_cta * kernel_max_cta_per_shader * num_shader;
    } else {
       // legacy mapping that maps the same address in the local memory space of all threads 
       // to a single contiguous address region 
       thread_base = 4*(m_config->n_thread_per_shader * m_sid + tid);
-      max_concurrent_threads = num_shader * m_config->n_thread_per_shader;
    }
    assert( thread_base < 4/*word size*/*max_concurrent_threads );
 
@@ -1298,6 +2583,14 @@ unsigned shader_core_ctx::translate_local_memaddr( address_type localaddr, unsig
    return num_accesses;
 }
 
+unsigned shader_core_ctx::local_mem_word_stride( unsigned num_shader ) const
+{
+   // 4 bytes for each of the maximum number of concurrent threads
+   if (m_config->gpgpu_local_mem_map) 
+      return 4 * kernel_padded_threads_per_cta * kernel_max_cta_per_shader * num_shader;
+   return 4 * num_shader * m_config->n_thread_per_shader;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 int shader_core_ctx::test_res_bus(int latency){
 	for(unsigned i=0; i<num_result_bus; i++){
@@ -1370,7 +2663,7 @@ void shader_core_ctx::warp_inst_complete(const warp_inst_t &inst)
 {
    #if 0
       printf("[warp_inst_complete] uid=%u core=%u warp=%u pc=%#x @ time=%llu issued@%llu\n", 
-             inst.get_uid(), m_sid, inst.warp_id(), inst.pc, gpu_tot_sim_cycle + gpu_sim_cycle, inst.get_issue_cycle()); 
+             inst.get_uid(), m_sid, inst.warp_id(), inst.pc, m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle, inst.get_issue_cycle()); 
    #endif
   if(inst.op_pipe==SP__OP)
 	  m_stats->m_num_sp_committed[m_sid]++;
@@ -1385,18 +2678,23 @@ void shader_core_ctx::warp_inst_complete(const warp_inst_t &inst)
 	  m_stats->m_num_sim_insn[m_sid] += inst.active_count();
 
   m_stats->m_num_sim_winsn[m_sid]++;
-  m_gpu->gpu_sim_insn += inst.active_count();
-  inst.completed(gpu_tot_sim_cycle + gpu_sim_cycle);
+  m_warp[inst.warp_id()].committed();
+  m_cluster->inc_gpu_sim_insn(inst.active_count());
+  inst.completed(m_gpu->gpu_tot_sim_cycle + m_gpu->gpu_sim_cycle);
 }
 
-void shader_core_ctx::writeback()
+void shader_core_ctx::sample_pipeline_duty_cycle()
 {
-
 	unsigned max_committed_thread_instructions=m_config->warp_size * (m_config->pipe_widths[EX_WB]); //from the functional units
 	m_stats->m_pipeline_duty_cycle[m_sid]=((float)(m_stats->m_num_sim_insn[m_sid]-m_stats->m_last_num_sim_insn[m_sid]))/max_committed_thread_instructions;
 
     m_stats->m_last_num_sim_insn[m_sid]=m_stats->m_num_sim_insn[m_sid];
     m_stats->m_last_num_sim_winsn[m_sid]=m_stats->m_num_sim_winsn[m_sid];
+}
+
+void shader_core_ctx::writeback()
+{
+    sample_pipeline_duty_cycle();
 
     warp_inst_t** preg = m_pipeline_reg[EX_WB].get_ready();
     warp_inst_t* pipe_reg = (preg==NULL)? NULL:*preg;
@@ -1423,10 +2721,9 @@ void shader_core_ctx::writeback()
         m_scoreboard->releaseRegisters( pipe_reg );
         m_warp[warp_id].dec_inst_in_pipeline();
         warp_inst_complete(*pipe_reg);
-        m_gpu->gpu_sim_insn_last_update_sid = m_sid;
-        m_gpu->gpu_sim_insn_last_update = gpu_sim_cycle;
-        m_last_inst_gpu_sim_cycle = gpu_sim_cycle;
-        m_last_inst_gpu_tot_sim_cycle = gpu_tot_sim_cycle;
+        m_cluster->set_gpu_sim_insn_last_update(m_sid);
+        m_last_inst_gpu_sim_cycle = m_gpu->gpu_sim_cycle;
+        m_last_inst_gpu_tot_sim_cycle = m_gpu->gpu_tot_sim_cycle;
         pipe_reg->clear();
         preg = m_pipeline_reg[EX_WB].get_ready();
         pipe_reg = (preg==NULL)? NULL:*preg;
@@ -1491,12 +2788,6 @@ ldst_unit::process_cache_access( cache_t* cache,
         result = BK_CONF;
     return result;
 }
-int alloc_pref_mf=0;
-// unsigned long long addr_min = (unsigned)-1;
-// unsigned long long addr_max = 0;
-warp_inst_t parent_inst;
-mem_access_t parent_inst_accessq;
-bool caws_flag[15] = {0};
 mem_stage_stall_type ldst_unit::process_memory_access_queue( cache_t *cache, warp_inst_t &inst )
 { 
     mem_stage_stall_type result = NO_RC_FAIL;
@@ -1512,29 +2803,36 @@ mem_stage_stall_type ldst_unit::process_memory_access_queue( cache_t *cache, war
     mf->set_thread0_active(thread0_active);
     //printf("thread0:%d\n", thread0_active);
     mem_fetch *pref_mf = NULL; 
-    if(USE_PREFETCH && (mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R) 
-    && caws_flag[mf->get_sid()] == 0 ){
-        parent_inst = inst;
-        parent_inst_accessq = inst.accessq_back();
-        caws_flag[mf->get_sid()] = 1;
+    if(use_prefetch && (mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R) 
+    && !m_caws_flag ){
+        m_parent_inst = inst;
+        m_parent_inst_accessq = inst.accessq_back();
+        m_caws_flag = true;
         //new_addr_type prefetch_addr = mf->get_addr()+256;
         //pref_mf->set_addr(prefetch_addr);
     }
-    if(USE_PREFETCH && caws_flag[mf->get_sid()] == 1 && (mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R)){
+    if(use_prefetch && m_caws_flag && (mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R)){
         //printf("generate prefetch time:%d\n", gpu_sim_cycle);
-        //printf("alloc_pref alloc_time:%d\n",alloc_pref_mf++);
-        pref_mf = m_mf_allocator->alloc(parent_inst, parent_inst_accessq);
+        pref_mf = m_mf_allocator->alloc(m_parent_inst, m_parent_inst_accessq);
         pref_mf->set_prefetch_true();
     }
 
     if(mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R){
         LDST_inst++;
+        m_parity_loads[inst.warp_id()%2]++;
         update_warp_locality();
     }
     /*cory*/
-    cache->scheduler_policy_gto = scheduler_policy_gto;
+    cache->scheduler_policy_gto = m_core->warp_scheduler_policy_gto(inst.warp_id());
     std::list<cache_event> events;
-        enum cache_request_status status = cache->access(mf->get_addr(),mf,pref_mf,gpu_sim_cycle+gpu_tot_sim_cycle,events);
+        enum cache_request_status status = cache->access(mf->get_addr(),mf,pref_mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle,events);
+    caws_shadow_tags &shadow = m_core->caws_shadow();
+    if( cache == m_L1D && shadow.enabled() && status != RESERVATION_FAIL 
+        && (mf->get_access_type()==GLOBAL_ACC_R || mf->get_access_type()==LOCAL_ACC_R) ) {
+        const l1d_cache_config &l1d = m_config->m_L1D_config;
+        shadow.access( l1d.set_index(mf->get_addr()), l1d.tag(mf->get_addr()), inst.warp_id(), 
+                       m_core->warp_dynamic_id(inst.warp_id()), status == HIT, cache->scheduler_policy_gto );
+    }
     return process_cache_access( cache, mf->get_addr(), inst, events, mf, status );
 }
 
@@ -1627,6 +2925,20 @@ bool ldst_unit::memory_cycle( warp_inst_t &inst, mem_stage_stall_type &stall_rea
 }
 
 
+bool ldst_unit::warm_l1d( const warp_inst_t &inst, mem_fetch *mf )
+{
+   bool bypassL1D = false; 
+   if ( CACHE_GLOBAL == inst.cache_op || (m_L1D == NULL) ) {
+       bypassL1D = true; 
+   } else if (inst.space.is_global()) { 
+       if (m_core->get_config()->gmem_skip_L1D) 
+           bypassL1D = true; 
+   }
+   if( bypassL1D ) 
+       return true;
+   return m_L1D->warm(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle,true);
+}
+
 bool ldst_unit::response_buffer_full() const
 {
     return m_response_fifo.size() >= m_config->ldst_unit_response_queue_size;
@@ -1634,7 +2946,7 @@ bool ldst_unit::response_buffer_full() const
 
 void ldst_unit::fill( mem_fetch *mf )
 {
-    mf->set_status(IN_SHADER_LDST_RESPONSE_FIFO,gpu_sim_cycle+gpu_tot_sim_cycle);
+    mf->set_status(IN_SHADER_LDST_RESPONSE_FIFO,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
     m_response_fifo.push_back(mf);
 }
 
@@ -1643,12 +2955,65 @@ void ldst_unit::flush(){
 	m_L1D->flush();
 }
 
+void ldst_unit::checkpoint( checkpoint_file &cp )
+{
+    cp.section("ldst_unit");
+    m_L1T->checkpoint(cp);
+    m_L1C->checkpoint(cp);
+    if( m_L1D ) 
+        m_L1D->checkpoint(cp);
+    cp.pod(LDST_inst);
+    cp.pod(m_intra_warp_locality);
+    cp.pod(m_inter_warp_locality);
+    cp.pod(m_miss_intra_warp_locality);
+    cp.pod(m_miss_inter_warp_locality);
+    cp.pod(scheduler_policy_gto);
+    cp.array(m_parity_loads,2);
+    cp.array(m_parity_locality,2);
+}
+
+// The responses and writebacks in flight; the requests themselves are 
+// reached through the caches and the interconnect as well.
+void ldst_unit::checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp )
+{
+    pipelined_simd_unit::checkpoint_pipeline(core,cp);
+    cp.mem_fetch_refs(m_response_fifo);
+    unsigned n_warps = m_pending_writes.size();
+    cp.pod(n_warps);
+    std::map<unsigned, std::map<unsigned,unsigned> >::iterator w = m_pending_writes.begin();
+    for( unsigned i=0; i < n_warps; i++ ) {
+        unsigned warp_id = cp.saving() ? w->first : 0;
+        std::map<unsigned,unsigned> regs;
+        if( cp.saving() ) 
+            regs = (w++)->second;
+        cp.pod(warp_id);
+        cp.map(regs);
+        if( !cp.saving() ) 
+            m_pending_writes[warp_id] = regs;
+    }
+    cp.mem_fetch_ref(m_next_global);
+    checkpoint_warp_inst(cp,m_next_wb);
+    cp.pod(m_writeback_arb);
+    cp.pod(m_mem_rc);
+    cp.pod(m_caws_flag);
+    checkpoint_warp_inst(cp,m_parent_inst);
+    checkpoint_mem_access(cp,m_parent_inst_accessq);
+    cp.pod(m_last_inst_gpu_sim_cycle);
+    cp.pod(m_last_inst_gpu_tot_sim_cycle);
+}
+
 simd_function_unit::simd_function_unit( const shader_core_config *config )
 { 
     m_config=config;
     m_dispatch_reg = new warp_inst_t(config); 
 }
 
+void simd_function_unit::checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp )
+{
+    core->checkpoint_inst(cp,*m_dispatch_reg);
+    cp.pod(occupied);
+}
+
 
 sfu:: sfu(  register_set* result_port, const shader_core_config *config,shader_core_ctx *core  )
     : pipelined_simd_unit(result_port,config,config->max_sfu_latency,core)
@@ -1731,6 +3096,13 @@ void pipelined_simd_unit::cycle()
 }
 
 
+void pipelined_simd_unit::checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp )
+{
+    simd_function_unit::checkpoint_pipeline(core,cp);
+    for( unsigned stage=0; stage < m_pipeline_depth; stage++ ) 
+        core->checkpoint_inst(cp,*m_pipeline_reg[stage]);
+}
+
 void pipelined_simd_unit::issue( register_set& source_reg )
 {
     //move_warp(m_dispatch_reg,source_reg);
@@ -1764,11 +3136,13 @@ void ldst_unit::init( mem_fetch_interface *icnt,
     m_icnt = icnt;
     m_mf_allocator=mf_allocator;
     m_core = core;
+    m_gpu = core->get_gpu();
     m_operand_collector = operand_collector;
     m_scoreboard = scoreboard;
     m_stats = stats;
     m_sid = sid;
     m_tpc = tpc;
+    m_caws_flag = false;
     #define STRSIZE 1024
     char L1T_name[STRSIZE];
     char L1C_name[STRSIZE];
@@ -1817,17 +3191,25 @@ ldst_unit::ldst_unit( mem_fetch_interface *icnt,
                               m_icnt,
                               m_mf_allocator,
                               IN_L1D_MISS_QUEUE );
+        // the L1D is the only cache that trains the locality monitor and prefetcher
+        if( m_config->l1d_locality_entries ) 
+            m_L1D->enable_locality_monitor( m_config->l1d_locality_leader_sets, m_config->l1d_locality_entries, 
+                                           m_config->l1d_locality_window, m_config->max_warps_per_shader );
+        if( m_config->l1d_prefetch_pcs ) 
+            m_L1D->enable_prefetcher( m_config->l1d_prefetch_pcs, m_config->max_cta_per_core, 
+                                      m_config->max_warps_per_shader, m_config->l1d_prefetch_records );
     }
 
     m_LDU = new LDU();
-    m_cache_prefetch = new cache_prefetch();
     LDST_inst = 0;
     m_intra_warp_locality=0;
     m_inter_warp_locality=0;
     m_miss_intra_warp_locality=0;
     m_miss_inter_warp_locality=0;
     scheduler_policy_gto=0;
-    use_prefetch=USE_PREFETCH;
+    m_parity_loads[0]=0;
+    m_parity_loads[1]=0;
+    use_prefetch=USE_PREFETCH && m_L1D && m_L1D->prefetcher_enabled();
 }
 
 ldst_unit::ldst_unit( mem_fetch_interface *icnt,
@@ -1881,7 +3263,6 @@ void ldst_unit:: issue( register_set &reg_set )
 	m_core->incmem_stat(m_core->get_config()->warp_size,1);
 	pipelined_simd_unit::issue(reg_set);
 }
-int pref_mf_time = 0;
 void ldst_unit::writeback()
 {
     // process next instruction that is going to writeback
@@ -1910,8 +3291,8 @@ void ldst_unit::writeback()
                 m_core->warp_inst_complete(m_next_wb);
             }
             m_next_wb.clear();
-            m_last_inst_gpu_sim_cycle = gpu_sim_cycle;
-            m_last_inst_gpu_tot_sim_cycle = gpu_tot_sim_cycle;
+            m_last_inst_gpu_sim_cycle = m_gpu->gpu_sim_cycle;
+            m_last_inst_gpu_tot_sim_cycle = m_gpu->gpu_tot_sim_cycle;
         }
     }
 
@@ -1980,6 +3361,26 @@ void ldst_unit::writeback()
     }
 }
 
+bool ldst_unit::quiescent() const
+{
+    if( !pipelined_simd_unit::quiescent() ) 
+        return false;
+    if( !m_next_wb.empty() || m_next_global || !m_response_fifo.empty() ) 
+        return false;
+    if( !m_L1T->quiescent() || !m_L1C->quiescent() ) 
+        return false;
+    return m_L1D == NULL || m_L1D->quiescent();
+}
+
+void ldst_unit::skip_cycle()
+{
+    // unlike pipelined_simd_unit::cycle(), ldst_unit::cycle() does not age 'occupied'
+    m_operand_collector->skip_cycle();
+    m_L1T->skip_cycle();
+    m_L1C->skip_cycle();
+    if( m_L1D ) m_L1D->skip_cycle();
+}
+
 unsigned ldst_unit::clock_multiplier() const
 { 
     return m_config->mem_warp_parts; 
@@ -2009,6 +3410,7 @@ void ldst_unit::issue( register_set &reg_set )
 */
 void ldst_unit::cycle()
 {
+   HOST_PROFILE_SCOPE(HOST_PROF_LDST);
    writeback();
    m_operand_collector->step();
    for( unsigned stage=0; (stage+1)<m_pipeline_depth; stage++ )   //m_pipeline_depth = 3
@@ -2020,13 +3422,13 @@ void ldst_unit::cycle()
        mem_fetch *mf = m_response_fifo.front();
        if (mf->istexture()) {
            if (m_L1T->fill_port_free()) {
-               m_L1T->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
+               m_L1T->fill(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                m_response_fifo.pop_front(); 
            }
        } else if (mf->isconst())  {
            if (m_L1C->fill_port_free()) {
-               mf->set_status(IN_SHADER_FETCHED,gpu_sim_cycle+gpu_tot_sim_cycle);
-               m_L1C->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
+               mf->set_status(IN_SHADER_FETCHED,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
+               m_L1C->fill(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                m_response_fifo.pop_front(); 
            }
        } else {
@@ -2046,14 +3448,14 @@ void ldst_unit::cycle()
                }
                if( bypassL1D ) {
                    if ( m_next_global == NULL ) {
-                       mf->set_status(IN_SHADER_FETCHED,gpu_sim_cycle+gpu_tot_sim_cycle);
+                       mf->set_status(IN_SHADER_FETCHED,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                        m_response_fifo.pop_front();
                        m_next_global = mf;
                    }
                } else {
                    if (m_L1D->fill_port_free()) {
                     //printf("l1d_fill sid:%d pref:%d", mf->get_sid(), mf->get_is_prefetch());
-                       m_L1D->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
+                       m_L1D->fill(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
                        m_response_fifo.pop_front();
                    }
                }
@@ -2136,25 +3538,33 @@ void shader_core_ctx::register_cta_thread_exit( unsigned cta_num )
    assert( m_cta_status[cta_num] > 0 );
    m_cta_status[cta_num]--;
    if (!m_cta_status[cta_num]) {
+      if( m_warp_trace_mode != WARP_TRACE_OFF ) {
+          unsigned warps_per_cta = kernel_padded_threads_per_cta/m_config->warp_size;
+          warp_trace_stream *warps = &m_warp_trace[cta_num*warps_per_cta];
+          if( m_warp_trace_mode == WARP_TRACE_CAPTURE ) {
+              // the trace file is shared by all cores running the kernel
+              m_gpu->functional_lock_ordered(m_tpc);
+              m_cta_trace_file[cta_num]->write_cta(m_cta_trace_id[cta_num],warps,warps_per_cta);
+              m_gpu->functional_unlock();
+          } else {
+              for( unsigned w=0; w < warps_per_cta; w++ ) {
+                  assert( warps[w].done() && warps[w].next_addr == warps[w].addr.size() );
+                  warps[w].clear();
+              }
+          }
+          m_cta_trace_file[cta_num] = NULL;
+      }
       m_n_active_cta--;
       m_barriers.deallocate_barrier(cta_num);
-      shader_CTA_count_unlog(m_sid, 1);
       //printf("GPGPU-Sim uArch: Shader %d finished CTA #%d (%lld,%lld), %u CTAs running\n", m_sid, cta_num, gpu_sim_cycle, gpu_tot_sim_cycle,
              //m_n_active_cta );
+      kernel_info_t *released_kernel = NULL;
       if( m_n_active_cta == 0 ) {
           assert( m_kernel != NULL );
-          m_kernel->dec_running();
-          //printf("GPGPU-Sim uArch: Shader %u empty (release kernel %u \'%s\').\n", m_sid, m_kernel->get_uid(),
-                 //m_kernel->name().c_str() );
-          if( m_kernel->no_more_ctas_to_run() ) {
-              if( !m_kernel->running() ) {
-                  printf("GPGPU-Sim uArch: GPU detected kernel \'%s\' finished on shader %u.\n", m_kernel->name().c_str(), m_sid );
-                  m_gpu->set_kernel_done( m_kernel );
-              }
-          }
+          released_kernel = m_kernel;
           m_kernel=NULL;
-          fflush(stdout);
       }
+      m_cluster->cta_exit(m_sid, released_kernel);
    }
 }
 
@@ -2219,6 +3629,25 @@ void gpgpu_sim::shader_print_scheduler_stat( FILE* fout, bool print_dynamic_info
         fprintf( fout, "%d, ", *iter );
     }
     fprintf( fout, "\n" );
+
+    if ( print_dynamic_info ) 
+        return;
+    const std::vector< unsigned >& loads = m_shader_stats->get_warp_slot_loads()[ scheduler_sampling_core ];
+    const std::vector< unsigned >& transactions = m_shader_stats->get_warp_slot_load_transactions()[ scheduler_sampling_core ];
+    if ( !loads.empty() ) {
+        fprintf( fout, "transactions per load:\n" );
+        for ( unsigned warp_id = 0; warp_id < loads.size(); ++warp_id ) {
+            fprintf( fout, "%.2f, ", loads[warp_id] ? (float)transactions[warp_id] / loads[warp_id] : 0 );
+        }
+        fprintf( fout, "\n" );
+    }
+    const unsigned *mode_cycles = m_shader_stats->divergence_aware_cycles;
+    if ( mode_cycles[DIVERGENCE_AWARE_COALESCED_FIRST] + mode_cycles[DIVERGENCE_AWARE_GTO] + mode_cycles[DIVERGENCE_AWARE_DIVERGENT_FIRST] ) {
+        fprintf( fout, "divergence_aware cycles: coalesced_first = %u, gto = %u, divergent_first = %u\n",
+                 mode_cycles[DIVERGENCE_AWARE_COALESCED_FIRST],
+                 mode_cycles[DIVERGENCE_AWARE_GTO],
+                 mode_cycles[DIVERGENCE_AWARE_DIVERGENT_FIRST] );
+    }
 }
 
 void gpgpu_sim::shader_print_cache_stats( FILE *fout ) const{
@@ -2265,6 +3694,9 @@ void gpgpu_sim::shader_print_cache_stats( FILE *fout ) const{
         }
         fprintf(fout, "\tL1D_total_cache_pending_hits = %u\n", total_css.pending_hits);
         fprintf(fout, "\tL1D_total_cache_reservation_fails = %u\n", total_css.res_fails);
+        fprintf(fout, "\tL1D_total_prefetch_on_time = %u\n", total_css.prefetch_on_time);
+        fprintf(fout, "\tL1D_total_prefetch_late = %u\n", total_css.prefetch_late);
+        fprintf(fout, "\tL1D_total_prefetch_evicted = %u\n", total_css.prefetch_evicted);
         total_css.print_port_stats(fout, "\tL1D_cache"); 
     }
 
@@ -2450,7 +3882,7 @@ void shader_core_ctx::display_simt_state(FILE *fout, int mask ) const
              unsigned tid = i*m_config->warp_size + j;
              int done = ptx_thread_done(tid);
              nactive += (ptx_thread_done(tid)?0:1);
-             if ( done && (mask & 8) ) {
+             if ( done && (mask & 8) && m_thread[tid] ) { // replayed threads have no state
                 unsigned done_cycle = m_thread[tid]->donecycle();
                 if ( done_cycle ) {
                    printf("\n w%02u:t%03u: done @ cycle %u", i, tid, done_cycle );
@@ -2517,7 +3949,7 @@ void shader_core_ctx::display_pipeline(FILE *fout, int print_mem, int mask ) con
 {
    fprintf(fout, "=================================================\n");
    fprintf(fout, "shader %u at cycle %Lu+%Lu (%u threads running)\n", m_sid, 
-           gpu_tot_sim_cycle, gpu_sim_cycle, m_not_completed);
+           m_gpu->gpu_tot_sim_cycle, m_gpu->gpu_sim_cycle, m_not_completed);
    fprintf(fout, "=================================================\n");
 
    dump_warp_state(fout);
@@ -2671,6 +4103,76 @@ void shader_core_ctx::cycle()
     fetch();
 }
 
+bool shader_core_ctx::quiescent()
+{
+    // nothing in flight between fetch and writeback
+    if( m_inst_fetch_buffer.m_valid || !m_L1I->quiescent() ) 
+        return false;
+    for( unsigned i=0; i < m_pipeline_reg.size(); i++ ) 
+        if( m_pipeline_reg[i].has_ready() ) 
+            return false;
+    if( !m_operand_collector.quiescent() ) 
+        return false;
+    for( unsigned n=0; n < m_num_function_units; n++ ) 
+        if( !m_fu[n]->quiescent() ) 
+            return false;
+    for( unsigned i=0; i < schedulers.size(); i++ ) 
+        if( !schedulers[i]->order_warps_is_stateless() ) 
+            return false;
+
+    // every warp is blocked on something only a memory response can resolve
+    for( unsigned w=0; w < m_config->max_warps_per_shader; w++ ) {
+        shd_warp_t &warp = m_warp[w];
+        if( warp.hardware_done() && !m_scoreboard->pendingWrites(w) && !warp.done_exit() ) 
+            return false; // fetch() would retire it
+        if( !warp.functional_done() && !warp.imiss_pending() && warp.ibuffer_empty() ) 
+            return false; // fetch() would access the instruction cache
+        if( warp.done_exit() ) 
+            continue;
+        if( warp.get_membar() && !m_scoreboard->pendingWrites(w) ) 
+            return false; // waiting() would release the memory barrier
+        if( warp.waiting() || warp.ibuffer_empty() ) 
+            continue;
+        const warp_inst_t *pI = warp.ibuffer_next_inst();
+        if( pI == NULL ) {
+            if( warp.ibuffer_next_valid() ) 
+                return false; // ibuffer flush after a diverged return
+            continue;
+        }
+        unsigned pc;
+        active_mask_t active_mask;
+        get_next_inst_info(w,&pc,&active_mask);
+        if( pc != pI->pc || !m_scoreboard->checkCollision(w,pI) ) 
+            return false; // control hazard flush or issue
+    }
+    return true;
+}
+
+void shader_core_ctx::begin_skip()
+{
+    for( unsigned i=0; i < 3; i++ ) 
+        m_skip_cycle_distro[i] = 0;
+    for( unsigned i=0; i < schedulers.size(); i++ ) 
+        m_skip_cycle_distro[schedulers[i]->stalled_cycle_distro()]++;
+}
+
+void shader_core_ctx::skip_cycle()
+{
+    // the per-cycle effects of cycle() on a quiescent core
+    m_stats->shader_cycles[m_sid]++;
+    sample_pipeline_duty_cycle();
+    for( unsigned i=0; i < num_result_bus; i++ ) 
+        *(m_result_bus[i]) >>=1;
+    for( unsigned n=0; n < m_num_function_units; n++ ) {
+        unsigned multiplier = m_fu[n]->clock_multiplier();
+        for( unsigned c=0; c < multiplier; c++ ) 
+            m_fu[n]->skip_cycle();
+    }
+    for( unsigned i=0; i < 3; i++ ) 
+        m_stats->shader_cycle_distro[i] += m_skip_cycle_distro[i];
+    m_L1I->skip_cycle();
+}
+
 // Flushes all content of the cache to memory
 
 void shader_core_ctx::cache_flush()
@@ -2678,6 +4180,336 @@ void shader_core_ctx::cache_flush()
    m_ldst_unit->flush();
 }
 
+void checkpoint_mem_access( checkpoint_file &cp, mem_access_t &access )
+{
+    enum mem_access_type type = access.get_type();
+    new_addr_type addr = access.get_addr();
+    unsigned size = access.get_size();
+    bool wr = access.is_write();
+    active_mask_t warp_mask = access.get_warp_mask();
+    mem_access_byte_mask_t byte_mask = access.get_byte_mask();
+    cp.pod(type);
+    cp.pod(addr);
+    cp.pod(size);
+    cp.pod(wr);
+    cp.pod(warp_mask);
+    cp.pod(byte_mask);
+    if( !cp.saving() ) 
+        access = mem_access_t(type,addr,size,wr,warp_mask,byte_mask);
+}
+
+void checkpoint_warp_inst( checkpoint_file &cp, warp_inst_t &inst )
+{
+    bool valid = !inst.empty();
+    cp.pod(valid);
+    if( !valid ) {
+        if( !cp.saving() ) 
+            inst.clear();
+        return;
+    }
+    address_type pc = 0;
+    active_mask_t active_mask;
+    unsigned warp_id = 0, dynamic_warp_id = 0, cta_id = 0;
+    unsigned long long issue_cycle = 0;
+    memory_space_t space;
+    enum memory_op_t memory_op = no_memory_op;
+    unsigned data_size = 0;
+    bool atomic = false;
+    if( cp.saving() ) {
+        pc = inst.pc;
+        active_mask = inst.get_active_mask();
+        warp_id = inst.warp_id();
+        dynamic_warp_id = inst.dynamic_warp_id();
+        cta_id = inst.cta_id();
+        issue_cycle = inst.get_issue_cycle();
+        space = inst.space;
+        memory_op = inst.memory_op;
+        data_size = inst.data_size;
+        atomic = inst.isatomic();
+    }
+    cp.pod(pc);
+    cp.pod(active_mask);
+    cp.pod(warp_id);
+    cp.pod(dynamic_warp_id);
+    cp.pod(cta_id);
+    cp.pod(issue_cycle);
+    cp.pod(space);
+    cp.pod(memory_op);
+    cp.pod(data_size);
+    cp.pod(atomic);
+    if( cp.saving() ) 
+        return;
+    const warp_inst_t *pI = ptx_fetch_inst(pc);
+    if( pI == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** timing checkpoint: no instruction at pc 0x%04x\n", (unsigned)pc);
+        abort();
+    }
+    inst = *pI;
+    inst.issue(active_mask,warp_id,issue_cycle,dynamic_warp_id,cta_id);
+    // set per thread by the functional model or the warp trace
+    inst.space = space;
+    inst.memory_op = memory_op;
+    inst.data_size = data_size;
+    if( atomic ) {
+        for( unsigned lane=0; lane < MAX_WARP_SIZE; lane++ ) 
+            if( active_mask.test(lane) ) 
+                inst.add_callback(lane,NULL,NULL,NULL,true); // performed functionally, as in replay
+    }
+}
+
+// warp_inst_t keeps the initiation interval it has left to itself
+static unsigned dispatch_delay_left( const warp_inst_t &inst )
+{
+    warp_inst_t probe = inst;
+    unsigned n = 0;
+    while( probe.has_dispatch_delay() ) {
+        probe.dispatch_delay();
+        n++;
+    }
+    return n;
+}
+
+void shader_core_ctx::checkpoint_inst( checkpoint_file &cp, warp_inst_t &inst )
+{
+    checkpoint_warp_inst(cp,inst);
+    if( inst.empty() ) 
+        return;
+    if( inst.is_load() || inst.is_store() ) {
+        // the first address of each thread, local memory words follow at a 
+        // fixed stride (see translate_local_memaddr())
+        unsigned num_shader = m_config->n_simt_clusters*m_config->n_simt_cores_per_cluster;
+        for( unsigned lane=0; lane < m_config->warp_size; lane++ ) {
+            if( !inst.active(lane) ) 
+                continue;
+            new_addr_type addr = cp.saving() ? inst.get_addr(lane) : 0;
+            cp.pod(addr);
+            if( cp.saving() ) 
+                continue;
+            if( inst.space.is_local() && inst.data_size >= 4 ) {
+                new_addr_type addrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
+                unsigned n = inst.data_size/4;
+                for( unsigned i=0; i < n; i++ ) 
+                    addrs[i] = addr + i*local_mem_word_stride(num_shader);
+                inst.set_addr(lane,addrs,n);
+            } else {
+                inst.set_addr(lane,addr);
+            }
+        }
+        // the ldst unit sends the accesses from the back of the queue, so the 
+        // ones left are the first n_accesses generated
+        unsigned n_accesses = cp.saving() ? inst.accessq_count() : 0;
+        cp.pod(n_accesses);
+        if( !cp.saving() ) {
+            inst.generate_mem_accesses();
+            if( inst.accessq_count() < n_accesses ) {
+                printf("GPGPU-Sim uArch: ERROR ** timing checkpoint: instruction at pc 0x%04x of shader %u, warp %u "
+                       "has %u memory accesses left, %u generated\n", 
+                       (unsigned)inst.pc, m_sid, inst.warp_id(), n_accesses, inst.accessq_count());
+                abort();
+            }
+            while( inst.accessq_count() > n_accesses ) 
+                inst.accessq_pop_back();
+        }
+    }
+    // after generate_mem_accesses(), which sets it for shared memory bank conflicts
+    unsigned delay = dispatch_delay_left(inst);
+    cp.pod(delay);
+    if( !cp.saving() ) {
+        unsigned left = dispatch_delay_left(inst);
+        assert( left >= delay );
+        for( ; left > delay; left-- ) 
+            inst.dispatch_delay();
+    }
+}
+
+// Oldest first, so the restored instructions are renumbered in the same order.
+void shader_core_ctx::checkpoint_register_set( checkpoint_file &cp, register_set &regs )
+{
+    if( cp.saving() ) {
+        std::vector<warp_inst_t*> held;
+        while( regs.has_ready() ) {
+            warp_inst_t *inst = new warp_inst_t(m_config);
+            regs.move_out_to(inst);
+            held.push_back(inst);
+        }
+        unsigned n = held.size();
+        cp.pod(n);
+        for( unsigned i=0; i < n; i++ ) {
+            checkpoint_inst(cp,*held[i]);
+            regs.move_in(held[i]);
+            delete held[i]; // the empty instruction swapped out of regs
+        }
+    } else {
+        unsigned n = 0;
+        cp.pod(n);
+        for( unsigned i=0; i < n; i++ ) {
+            warp_inst_t **slot = regs.get_free();
+            assert( slot );
+            checkpoint_inst(cp,**slot);
+        }
+    }
+}
+
+// Decoded instructions are shared by all warps and referenced by their pc.
+static void checkpoint_static_inst( checkpoint_file &cp, const warp_inst_t *&pI )
+{
+    bool present = pI != NULL;
+    cp.pod(present);
+    if( !present ) {
+        pI = NULL;
+        return;
+    }
+    address_type pc = cp.saving() ? pI->pc : 0;
+    cp.pod(pc);
+    if( !cp.saving() ) 
+        pI = ptx_fetch_inst(pc);
+}
+
+void shd_warp_t::checkpoint( checkpoint_file &cp )
+{
+    cp.pod(m_cta_id);
+    cp.pod(m_warp_id);
+    cp.pod(m_dynamic_warp_id);
+    cp.pod(m_next_pc);
+    cp.pod(n_completed);
+    cp.pod(m_active_threads);
+    cp.pod(m_imiss_pending);
+    checkpoint_static_inst(cp,m_inst_at_barrier);
+    for( unsigned i=0; i < IBUFFER_SIZE; i++ ) {
+        cp.pod(m_ibuffer[i].m_valid);
+        checkpoint_static_inst(cp,m_ibuffer[i].m_inst);
+    }
+    cp.pod(m_next);
+    cp.pod(m_n_atomic);
+    cp.pod(m_membar);
+    cp.pod(m_n_committed);
+    cp.pod(m_last_issue_cycle);
+    cp.pod(m_n_loads);
+    cp.pod(m_avg_load_transactions);
+    cp.pod(m_done_exit);
+    cp.pod(m_last_fetch);
+    cp.pod(m_stores_outstanding);
+    cp.pod(m_inst_in_pipeline);
+}
+
+// Mid-kernel checkpoints: SIMT stacks are not saved. Under warp trace replay 
+// they only depend on the trace entries the warp has issued, so they are 
+// rebuilt from those with the same updates as issue_warp().
+void shader_core_ctx::rebuild_simt_stack( unsigned warp_id )
+{
+    assert( m_warp_trace_mode == WARP_TRACE_REPLAY );
+    warp_trace_stream &trace = m_warp_trace[warp_id];
+    unsigned next_inst = trace.next_inst;
+    assert( !trace.inst.empty() );
+    m_simt_stack[warp_id]->reset();
+    m_simt_stack[warp_id]->launch(trace.inst[0].pc,simt_mask_t(trace.inst[0].active_mask));
+    for( unsigned i=0; i < next_inst; i++ ) {
+        const warp_inst_t *pI = ptx_fetch_inst(trace.inst[i].pc);
+        assert( pI );
+        warp_inst_t inst = *pI;
+        inst.issue( active_mask_t(trace.inst[i].active_mask), warp_id, 0, 
+                    m_warp[warp_id].get_dynamic_warp_id(), m_warp[warp_id].get_cta_id() );
+        trace.next_inst = i+1;
+        replay_simt_stack(warp_id,&inst);
+    }
+    trace.next_inst = next_inst;
+}
+
+// Timing state of the core. After a grid only the caches, the prefetcher and 
+// locality tables, the CAWS counters and the scheduler state are live; in the 
+// middle of a grid (warp trace replay only) the CTAs, warps and every 
+// instruction in the pipeline are saved as well.
+void shader_core_ctx::checkpoint( checkpoint_file &cp )
+{
+    cp.section("shader_core_ctx");
+    cp.check_size(m_sid,"shader core id");
+    cp.pod(m_n_active_cta);
+    cp.array(m_cta_status,MAX_CTA_PER_SHADER);
+    cp.pod(m_not_completed);
+    cp.pod(m_active_threads);
+    cp.array(m_threadState,m_config->n_thread_per_shader);
+    cp.pod(m_last_warp_fetched);
+    cp.pod(m_dynamic_warp_id);
+    cp.pod(kernel_max_cta_per_shader);
+    cp.pod(kernel_padded_threads_per_cta);
+    cp.pod(m_last_inst_gpu_sim_cycle);
+    cp.pod(m_last_inst_gpu_tot_sim_cycle);
+    cp.array(m_skip_cycle_distro,3);
+    bool bound = m_kernel != NULL;
+    cp.pod(bound);
+    if( bound && !cp.saving() ) {
+        assert( m_gpu->checkpoint_kernel() );
+        set_kernel(m_gpu->checkpoint_kernel());
+        m_ldst_unit->set_warps_per_cta( kernel_padded_threads_per_cta / m_config->warp_size );
+    }
+
+    cp.check_size(m_warp_trace.size(),"warp traces");
+    for( unsigned w=0; w < m_warp_trace.size(); w++ ) {
+        cp.vector(m_warp_trace[w].inst);
+        cp.vector(m_warp_trace[w].addr);
+        cp.pod(m_warp_trace[w].next_inst);
+        cp.pod(m_warp_trace[w].next_addr);
+    }
+    cp.array(m_cta_trace_id,MAX_CTA_PER_SHADER);
+    if( !cp.saving() && m_warp_trace_mode != WARP_TRACE_OFF ) {
+        for( unsigned i=0; i < MAX_CTA_PER_SHADER; i++ ) 
+            if( m_cta_status[i] ) 
+                m_cta_trace_file[i] = m_gpu->warp_trace(*m_kernel);
+    }
+
+    cp.section("warps");
+    for( unsigned w=0; w < m_warp.size(); w++ ) {
+        m_warp[w].checkpoint(cp);
+        if( m_warp[w].done_exit() ) 
+            continue;
+        // checked against the rebuilt stack
+        unsigned pc = 0, rpc = 0;
+        active_mask_t active_mask;
+        if( cp.saving() ) {
+            m_simt_stack[w]->get_pdom_stack_top_info(&pc,&rpc);
+            active_mask = m_simt_stack[w]->get_active_mask();
+        }
+        cp.pod(pc);
+        cp.pod(rpc);
+        cp.pod(active_mask);
+        if( !cp.saving() ) {
+            rebuild_simt_stack(w);
+            unsigned found_pc, found_rpc;
+            m_simt_stack[w]->get_pdom_stack_top_info(&found_pc,&found_rpc);
+            if( found_pc != pc || found_rpc != rpc || m_simt_stack[w]->get_active_mask() != active_mask ) {
+                printf("GPGPU-Sim uArch: ERROR ** timing checkpoint: rebuilt SIMT stack of shader %u, warp %u is at "
+                       "pc 0x%04x rpc 0x%04x mask 0x%08lx, saved pc 0x%04x rpc 0x%04x mask 0x%08lx\n",
+                       m_sid, w, found_pc, found_rpc, m_simt_stack[w]->get_active_mask().to_ulong(), 
+                       pc, rpc, active_mask.to_ulong());
+                abort();
+            }
+        }
+    }
+    m_barriers.checkpoint(cp);
+
+    cp.section("pipeline");
+    cp.pod(m_inst_fetch_buffer);
+    cp.check_size(m_pipeline_reg.size(),"pipeline registers");
+    for( unsigned i=0; i < m_pipeline_reg.size(); i++ ) 
+        checkpoint_register_set(cp,m_pipeline_reg[i]);
+    m_operand_collector.checkpoint(cp);
+    cp.check_size(m_fu.size(),"function units");
+    for( unsigned n=0; n < m_fu.size(); n++ ) 
+        m_fu[n]->checkpoint_pipeline(this,cp);
+    for( unsigned i=0; i < m_result_bus.size(); i++ ) 
+        cp.pod(*m_result_bus[i]);
+
+    m_L1I->checkpoint(cp);
+    m_ldst_unit->checkpoint(cp);
+    m_scoreboard->checkpoint(cp);
+    m_caws_policy.checkpoint(cp);
+    m_caws_shadow.checkpoint(cp);
+    for( unsigned i=0; i < schedulers.size(); i++ ) {
+        schedulers[i]->checkpoint(cp);
+        schedulers[i]->checkpoint_warps(cp);
+    }
+}
+
 // modifiers
 std::list<opndcoll_rfu_t::op_t> opndcoll_rfu_t::arbiter_t::allocate_reads() 
 {
@@ -2782,6 +4614,28 @@ barrier_set_t::barrier_set_t(shader_core_ctx *shader,unsigned max_warps_per_core
    for(unsigned i=0; i<max_barriers_per_cta; i++){
 	   m_bar_id_to_warps[i].reset();
    }
+   m_arrival_cycle.resize(max_warps_per_core,0);
+}
+
+void barrier_set_t::arrive( unsigned warp_id )
+{
+   m_warp_at_barrier.set(warp_id);
+   m_arrival_cycle[warp_id] = m_shader->get_gpu()->gpu_sim_cycle + m_shader->get_gpu()->gpu_tot_sim_cycle;
+}
+
+void barrier_set_t::release( warp_set_t warps )
+{
+   warp_set_t released = warps & m_warp_at_barrier;
+   if( released.none() )
+      return;
+   unsigned long long now = m_shader->get_gpu()->gpu_sim_cycle + m_shader->get_gpu()->gpu_tot_sim_cycle;
+   unsigned long long wait = 0;
+   for( unsigned w=0; w < m_max_warps_per_core; w++ ) {
+      if( released.test(w) )
+         wait += now - m_arrival_cycle[w];
+   }
+   m_shader->inc_barrier_wait_stat(wait);
+   m_warp_at_barrier &= ~released;
 }
 
 // during cta allocation
@@ -2833,7 +4687,7 @@ void barrier_set_t::warp_reaches_barrier(unsigned cta_id,unsigned warp_id,warp_i
    cta_to_warp_t::iterator w=m_cta_to_warps.find(cta_id);
 
    if( w == m_cta_to_warps.end() ) { // cta is active
-      printf("ERROR ** cta_id %u not found in barrier set on cycle %llu+%llu...\n", cta_id, gpu_tot_sim_cycle, gpu_sim_cycle );
+      printf("ERROR ** cta_id %u not found in barrier set on cycle %llu+%llu...\n", cta_id, m_shader->get_gpu()->gpu_tot_sim_cycle, m_shader->get_gpu()->gpu_sim_cycle );
       dump();
       abort();
    }
@@ -2841,7 +4695,7 @@ void barrier_set_t::warp_reaches_barrier(unsigned cta_id,unsigned warp_id,warp_i
 
    m_bar_id_to_warps[bar_id].set(warp_id);
    if(bar_type==SYNC || bar_type==RED){
-	   m_warp_at_barrier.set(warp_id);
+	   arrive(warp_id);
    }
    warp_set_t warps_in_cta = w->second;
    warp_set_t at_barrier = warps_in_cta & m_bar_id_to_warps[bar_id];
@@ -2850,7 +4704,7 @@ void barrier_set_t::warp_reaches_barrier(unsigned cta_id,unsigned warp_id,warp_i
 	   if( at_barrier == active ) {
 		   // all warps have reached barrier, so release waiting warps...
 		   m_bar_id_to_warps[bar_id] &= ~at_barrier;
-		   m_warp_at_barrier &= ~at_barrier;
+		   release(at_barrier);
 		   if(bar_type==RED){
 			   m_shader->broadcast_barrier_reduction(cta_id, bar_id,at_barrier);
 		   }
@@ -2860,7 +4714,7 @@ void barrier_set_t::warp_reaches_barrier(unsigned cta_id,unsigned warp_id,warp_i
 	  if ((at_barrier.count() * m_warp_size) == bar_count){
 		   // required number of warps have reached barrier, so release waiting warps...
 		   m_bar_id_to_warps[bar_id] &= ~at_barrier;
-		   m_warp_at_barrier &= ~at_barrier;
+		   release(at_barrier);
 		   if(bar_type==RED){
 			   m_shader->broadcast_barrier_reduction(cta_id, bar_id,at_barrier);
 		   }
@@ -2891,7 +4745,7 @@ void barrier_set_t::warp_exit( unsigned warp_id )
 	   if( at_a_specific_barrier == active ) {
 	      // all warps have reached barrier, so release waiting warps...
 		   m_bar_id_to_warps[i] &= ~at_a_specific_barrier;
-		   m_warp_at_barrier &= ~at_a_specific_barrier;
+		   release(at_a_specific_barrier);
 	   }
    }
 }
@@ -2902,6 +4756,21 @@ bool barrier_set_t::warp_waiting_at_barrier( unsigned warp_id ) const
    return m_warp_at_barrier.test(warp_id);
 }
 
+bool barrier_set_t::cta_waiting_at_barrier( unsigned cta_id ) const
+{
+   cta_to_warp_t::const_iterator w=m_cta_to_warps.find(cta_id);
+   return w != m_cta_to_warps.end() && (w->second & m_warp_at_barrier).any();
+}
+
+void barrier_set_t::checkpoint( checkpoint_file &cp )
+{
+   cp.map(m_cta_to_warps);
+   cp.map(m_bar_id_to_warps);
+   cp.pod(m_warp_active);
+   cp.pod(m_warp_at_barrier);
+   cp.vector(m_arrival_cycle);
+}
+
 void barrier_set_t::dump()
 {
    printf( "barrier set information\n");
@@ -2981,6 +4850,7 @@ void shader_core_ctx::set_max_cta( const kernel_info_t &kernel )
     kernel_padded_threads_per_cta = (gpu_cta_size%m_config->warp_size) ? 
         m_config->warp_size*((gpu_cta_size/m_config->warp_size)+1) : 
         gpu_cta_size;
+    m_ldst_unit->set_warps_per_cta( kernel_padded_threads_per_cta / m_config->warp_size );
 }
 
 void shader_core_ctx::decrement_atomic_count( unsigned wid, unsigned n )
@@ -3006,8 +4876,8 @@ bool shader_core_ctx::fetch_unit_response_buffer_full() const
 
 void shader_core_ctx::accept_fetch_response( mem_fetch *mf )
 {
-    mf->set_status(IN_SHADER_FETCHED,gpu_sim_cycle+gpu_tot_sim_cycle);
-    m_L1I->fill(mf,gpu_sim_cycle+gpu_tot_sim_cycle);
+    mf->set_status(IN_SHADER_FETCHED,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
+    m_L1I->fill(mf,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
 }
 
 bool shader_core_ctx::ldst_unit_response_buffer_full() const
@@ -3361,6 +5231,72 @@ bool opndcoll_rfu_t::collector_unit_t::allocate( register_set* pipeline_reg_set,
    return false;
 }
 
+void opndcoll_rfu_t::checkpoint( checkpoint_file &cp )
+{
+   cp.section("opndcoll_rfu_t");
+   // the pipeline registers the collector units dispatch to
+   port_vector_t outputs;
+   for( unsigned p=0; p < m_in_ports.size(); p++ ) {
+      for( unsigned i=0; i < m_in_ports[p].m_out.size(); i++ ) {
+         register_set *out = m_in_ports[p].m_out[i];
+         if( std::find(outputs.begin(),outputs.end(),out) == outputs.end() ) 
+            outputs.push_back(out);
+      }
+   }
+   cp.check_size(m_cu.size(),"collector units");
+   for( unsigned n=0; n < m_cu.size(); n++ ) 
+      m_cu[n]->checkpoint(cp,outputs);
+   m_arbiter.checkpoint(cp,m_cu);
+   for( unsigned p=0; p < m_dispatch_units.size(); p++ ) 
+      m_dispatch_units[p].checkpoint(cp);
+}
+
+void opndcoll_rfu_t::arbiter_t::checkpoint( checkpoint_file &cp, std::vector<collector_unit_t *> &cus )
+{
+   cp.pod(m_last_cu);
+   for( unsigned b=0; b < m_num_banks; b++ ) {
+      // (collector unit, operand) of each queued read
+      std::vector< std::pair<unsigned,unsigned> > reads;
+      for( std::list<op_t>::const_iterator o=m_queue[b].begin(); o != m_queue[b].end(); o++ ) 
+         reads.push_back( std::make_pair(o->get_oc_id(),o->get_operand()) );
+      cp.vector(reads);
+      if( !cp.saving() ) {
+         m_queue[b].clear();
+         for( unsigned r=0; r < reads.size(); r++ ) 
+            m_queue[b].push_back( cus[reads[r].first]->get_operands()[reads[r].second] );
+      }
+   }
+}
+
+void opndcoll_rfu_t::dispatch_unit_t::checkpoint( checkpoint_file &cp )
+{
+   cp.pod(m_last_cu);
+}
+
+void opndcoll_rfu_t::collector_unit_t::checkpoint( checkpoint_file &cp, const port_vector_t &outputs )
+{
+   cp.pod(m_free);
+   if( m_free ) 
+      return;
+   cp.pod(m_warp_id);
+   m_rfu->shader_core()->checkpoint_inst(cp,*m_warp);
+   unsigned output = std::find(outputs.begin(),outputs.end(),m_output_register) - outputs.begin();
+   cp.pod(output);
+   assert( output < outputs.size() );
+   m_output_register = outputs[output];
+   cp.pod(m_not_ready);
+   if( !cp.saving() ) {
+      // the source operands, as in allocate()
+      for( unsigned op=0; op < MAX_REG_OPERANDS; op++ ) {
+         int reg_num = m_warp->arch_reg.src[op];
+         if( reg_num >= 0 ) 
+            m_src_op[op] = op_t( this, op, reg_num, m_num_banks, m_bank_warp_shift );
+         else 
+            m_src_op[op] = op_t();
+      }
+   }
+}
+
 void opndcoll_rfu_t::collector_unit_t::dispatch()
 {
    assert( m_not_ready.none() );
@@ -3383,31 +5319,152 @@ simt_core_cluster::simt_core_cluster( class gpgpu_sim *gpu,
     m_cta_issue_next_core=m_config->n_simt_cores_per_cluster-1; // this causes first launch to use hw cta 0
     m_cluster_id=cluster_id;
     m_gpu = gpu;
+    m_defer_shared_updates = gpu->get_config().get_sim_threads() > 1;
+    if( m_defer_shared_updates ) 
+        stats = new shader_core_stats(stats);
     m_stats = stats;
     m_memory_stats = mstats;
+    m_deferred_icnt_flits = 0;
+    m_deferred_sim_insn = 0;
+    m_deferred_last_update_sid = -1;
     m_core = new shader_core_ctx*[ config->n_simt_cores_per_cluster ];
     for( unsigned i=0; i < config->n_simt_cores_per_cluster; i++ ) {
         unsigned sid = m_config->cid_to_sid(i,m_cluster_id);
         m_core[i] = new shader_core_ctx(gpu,this,sid,m_cluster_id,config,mem_config,stats);
         m_core_sim_order.push_back(i); 
     }
+    m_core_active.resize(config->n_simt_cores_per_cluster, true);
 }
 
 void simt_core_cluster::core_cycle()
 {
+    HOST_PROFILE_SCOPE(HOST_PROF_CORE);
+    if( m_defer_shared_updates ) 
+        mem_fetch::set_uid_log(&m_deferred_mf_uid);
     for( std::list<unsigned>::iterator it = m_core_sim_order.begin(); it != m_core_sim_order.end(); ++it ) {
-        m_core[*it]->cycle();
+        shader_core_ctx *core = m_core[*it];
+        if( !m_core_active[*it] ) {
+            core->skip_cycle();
+            continue;
+        }
+        core->cycle();
+        if( m_config->gpgpu_skip_idle_cores && core->get_n_active_cta() == 0 && core->quiescent() ) {
+            m_core_active[*it] = false;
+            core->begin_skip();
+        }
     }
+    if( m_defer_shared_updates ) 
+        mem_fetch::set_uid_log(NULL);
 
     if (m_config->simt_core_sim_order == 1) {
         m_core_sim_order.splice(m_core_sim_order.end(), m_core_sim_order, m_core_sim_order.begin()); 
     }
 }
 
-void simt_core_cluster::reinit()
+void simt_core_cluster::merge_deferred()
+{
+    if( !m_defer_shared_updates ) 
+        return;
+    mem_fetch::assign_deferred_uids(m_gpu, m_deferred_mf_uid);
+    for( unsigned i=0; i < m_deferred_icnt_push.size(); i++ ) {
+        const deferred_icnt_push &p = m_deferred_icnt_push[i];
+        ::icnt_push(m_cluster_id, p.output, (void*)p.mf, p.size);
+    }
+    m_deferred_icnt_push.clear();
+    m_deferred_icnt_flits = 0;
+    for( unsigned i=0; i < m_deferred_read_done.size(); i++ ) 
+        m_memory_stats->memlatstat_read_done(m_deferred_read_done[i]);
+    m_deferred_read_done.clear();
+    m_gpu->gpu_sim_insn += m_deferred_sim_insn;
+    m_deferred_sim_insn = 0;
+    if( m_deferred_last_update_sid != -1 ) {
+        m_gpu->gpu_sim_insn_last_update_sid = m_deferred_last_update_sid;
+        m_gpu->gpu_sim_insn_last_update = m_gpu->gpu_sim_cycle;
+        m_deferred_last_update_sid = -1;
+    }
+    for( unsigned i=0; i < m_deferred_cta_exit.size(); i++ ) {
+        shader_CTA_count_unlog(m_deferred_cta_exit[i].first, 1);
+        if( m_deferred_cta_exit[i].second ) 
+            release_kernel(m_deferred_cta_exit[i].first, m_deferred_cta_exit[i].second);
+    }
+    m_deferred_cta_exit.clear();
+    m_stats->merge_shard();
+}
+
+bool simt_core_cluster::quiescent()
+{
+    if( !m_response_fifo.empty() ) 
+        return false;
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        if( !m_core[i]->quiescent() ) 
+            return false;
+    return true;
+}
+
+void simt_core_cluster::begin_skip()
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->begin_skip();
+}
+
+void simt_core_cluster::skip_cycle()
 {
     for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->skip_cycle();
+    if (m_config->simt_core_sim_order == 1) {
+        m_core_sim_order.splice(m_core_sim_order.end(), m_core_sim_order, m_core_sim_order.begin()); 
+    }
+}
+
+void simt_core_cluster::inc_gpu_sim_insn( unsigned n )
+{
+    if( m_defer_shared_updates ) 
+        m_deferred_sim_insn += n;
+    else 
+        m_gpu->gpu_sim_insn += n;
+}
+
+void simt_core_cluster::set_gpu_sim_insn_last_update( unsigned sid )
+{
+    if( m_defer_shared_updates ) {
+        m_deferred_last_update_sid = sid;
+    } else {
+        m_gpu->gpu_sim_insn_last_update_sid = sid;
+        m_gpu->gpu_sim_insn_last_update = m_gpu->gpu_sim_cycle;
+    }
+}
+
+void simt_core_cluster::cta_exit( unsigned sid, kernel_info_t *released_kernel )
+{
+    if( m_defer_shared_updates ) {
+        m_deferred_cta_exit.push_back( std::make_pair(sid,released_kernel) );
+        return;
+    }
+    shader_CTA_count_unlog(sid, 1);
+    if( released_kernel ) 
+        release_kernel(sid, released_kernel);
+}
+
+void simt_core_cluster::release_kernel( unsigned sid, kernel_info_t *kernel )
+{
+    kernel->dec_running();
+    //printf("GPGPU-Sim uArch: Shader %u empty (release kernel %u \'%s\').\n", sid, kernel->get_uid(),
+           //kernel->name().c_str() );
+    if( kernel->no_more_ctas_to_run() ) {
+        if( !kernel->running() ) {
+            printf("GPGPU-Sim uArch: GPU detected kernel \'%s\' finished on shader %u.\n", kernel->name().c_str(), sid );
+            m_gpu->set_kernel_done( kernel );
+        }
+    }
+    fflush(stdout);
+}
+
+void simt_core_cluster::reinit()
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) {
         m_core[i]->reinit(0,m_config->n_thread_per_shader,true);
+        m_core_active[i] = true;
+    }
 }
 
 unsigned simt_core_cluster::max_cta( const kernel_info_t &kernel )
@@ -3440,6 +5497,16 @@ unsigned simt_core_cluster::get_n_active_cta() const
     return n;
 }
 
+bool simt_core_cluster::fully_occupied() const
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) {
+        kernel_info_t *kernel = m_core[i]->get_kernel();
+        if( !kernel || m_core[i]->get_n_active_cta() < m_config->max_cta(*kernel) ) 
+            return false;
+    }
+    return true;
+}
+
 unsigned simt_core_cluster::get_n_active_sms() const
 {
     unsigned n=0;
@@ -3448,7 +5515,7 @@ unsigned simt_core_cluster::get_n_active_sms() const
     return n;
 }
 
-unsigned simt_core_cluster::issue_block2core()
+unsigned simt_core_cluster::issue_block2core( unsigned long long *ff_insn, bool warm )
 {
     unsigned num_blocks_issued=0;
     for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) {
@@ -3462,7 +5529,11 @@ unsigned simt_core_cluster::issue_block2core()
         }
         kernel_info_t *kernel = m_core[core]->get_kernel();
         if( kernel && !kernel->no_more_ctas_to_run() && (m_core[core]->get_n_active_cta() < m_config->max_cta(*kernel)) ) {
-            m_core[core]->issue_block2core(*kernel);
+            unsigned cta_id = m_core[core]->issue_block2core(*kernel);
+            if( ff_insn ) 
+                *ff_insn += m_core[core]->functional_execute_cta(cta_id,warm);
+            else
+                m_core_active[core] = true;
             num_blocks_issued++;
             m_cta_issue_next_core=core; 
             break;
@@ -3477,11 +5548,31 @@ void simt_core_cluster::cache_flush()
         m_core[i]->cache_flush();
 }
 
+void simt_core_cluster::checkpoint( checkpoint_file &cp )
+{
+    for( unsigned i=0; i < m_config->n_simt_cores_per_cluster; i++ ) 
+        m_core[i]->checkpoint(cp);
+    cp.pod(m_cta_issue_next_core);
+    cp.mem_fetch_refs(m_response_fifo);
+    for( unsigned i=0; i < m_core_active.size(); i++ ) {
+        bool active = m_core_active[i];
+        cp.pod(active);
+        m_core_active[i] = active;
+    }
+    std::vector<unsigned> order(m_core_sim_order.begin(),m_core_sim_order.end());
+    cp.vector(order);
+    if( !cp.saving() ) 
+        m_core_sim_order.assign(order.begin(),order.end());
+}
+
 bool simt_core_cluster::icnt_injection_buffer_full(unsigned size, bool write)
 {
     unsigned request_size = size;
     if (!write) 
         request_size = READ_PACKET_SIZE;
+    // packets buffered this cycle will occupy the injection buffer as well
+    if (m_deferred_icnt_flits) 
+        request_size += m_deferred_icnt_flits * ::icnt_get_flit_size();
     return ! ::icnt_has_buffer(m_cluster_id, request_size);
 }
 
@@ -3514,11 +5605,19 @@ void simt_core_cluster::icnt_inject_request_packet(class mem_fetch *mf)
    }
    m_stats->m_outgoing_traffic_stats->record_traffic(mf, packet_size); 
    unsigned destination = mf->get_sub_partition_id();   //decide by addr
-   mf->set_status(IN_ICNT_TO_MEM,gpu_sim_cycle+gpu_tot_sim_cycle);
-   if (!mf->get_is_write() && !mf->isatomic())
-      ::icnt_push(m_cluster_id, m_config->mem2device(destination), (void*)mf, mf->get_ctrl_size() );
-   else 
-      ::icnt_push(m_cluster_id, m_config->mem2device(destination), (void*)mf, mf->size());
+   mf->set_status(IN_ICNT_TO_MEM,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
+   unsigned push_size = (!mf->get_is_write() && !mf->isatomic())? mf->get_ctrl_size() : mf->size();
+   if (m_defer_shared_updates) {
+      deferred_icnt_push p;
+      p.output = m_config->mem2device(destination);
+      p.mf = mf;
+      p.size = push_size;
+      m_deferred_icnt_push.push_back(p);
+      unsigned flit_size = ::icnt_get_flit_size();
+      m_deferred_icnt_flits += (push_size + flit_size - 1) / flit_size;
+      return;
+   }
+   ::icnt_push(m_cluster_id, m_config->mem2device(destination), (void*)mf, push_size);
 }
 
 void simt_core_cluster::icnt_cycle()
@@ -3532,18 +5631,25 @@ void simt_core_cluster::icnt_cycle()
             if( !m_core[cid]->fetch_unit_response_buffer_full() ) {
                 m_response_fifo.pop_front();
                 m_core[cid]->accept_fetch_response(mf);
+                m_core_active[cid] = true;
             }
         } else {
             // data response
             if( !m_core[cid]->ldst_unit_response_buffer_full() ) {
                 m_response_fifo.pop_front();
-                m_memory_stats->memlatstat_read_done(mf);
+                if( m_defer_shared_updates ) 
+                    m_deferred_read_done.push_back(mf);
+                else 
+                    m_memory_stats->memlatstat_read_done(mf);
                 m_core[cid]->accept_ldst_unit_response(mf);
+                m_core_active[cid] = true;
             }
         }
     }
     if( m_response_fifo.size() < m_config->n_simt_ejection_buffer_size ) {
+        m_gpu->icnt_lock();
         mem_fetch *mf = (mem_fetch*) ::icnt_pop(m_cluster_id);
+        m_gpu->icnt_unlock();
         if (!mf) 
             return;
         assert(mf->get_tpc() == m_cluster_id);
@@ -3558,7 +5664,7 @@ void simt_core_cluster::icnt_cycle()
         // - For write-ack, the packet only has control metadata
         unsigned int packet_size = (mf->get_is_write())? mf->get_ctrl_size() : mf->size(); 
         m_stats->m_incoming_traffic_stats->record_traffic(mf, packet_size); 
-        mf->set_status(IN_CLUSTER_TO_SHADER_QUEUE,gpu_sim_cycle+gpu_tot_sim_cycle);
+        mf->set_status(IN_CLUSTER_TO_SHADER_QUEUE,m_gpu->gpu_sim_cycle+m_gpu->gpu_tot_sim_cycle);
         //m_memory_stats->memlatstat_read_done(mf,m_shader_config->max_warps_per_shader);
         m_response_fifo.push_back(mf);
         m_stats->n_mem_to_simt[m_cluster_id] += mf->get_num_flits(false);
@@ -3655,6 +5761,8 @@ void shader_core_ctx::checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned
 {
     if(inst.isatomic())
            m_warp[inst.warp_id()].inc_n_atomic();
+        if( m_warp_trace_mode == WARP_TRACE_CAPTURE && (inst.is_load() || inst.is_store()) ) 
+            m_warp_trace[inst.warp_id()].addr.push_back(inst.get_addr(t)); // before local memory translation
         if (inst.space.is_local() && (inst.is_load() || inst.is_store())) {
             new_addr_type localaddrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
             unsigned num_addrs;
@@ -3662,7 +5770,12 @@ void shader_core_ctx::checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned
                    inst.data_size, (new_addr_type*) localaddrs );
             inst.set_addr(t, (new_addr_type*) localaddrs, num_addrs);
         }
-        if ( ptx_thread_done(tid) ) {
+        bool thread_done = m_warp_trace_mode == WARP_TRACE_REPLAY ? 
+                           ((m_warp_trace[inst.warp_id()].peek().exit_mask >> t) & 1) : 
+                           ptx_thread_done(tid);
+        if ( thread_done ) {
+            if( m_warp_trace_mode == WARP_TRACE_CAPTURE ) 
+                m_warp_trace[inst.warp_id()].inst.back().exit_mask |= 1u << t;
             m_warp[inst.warp_id()].set_completed(t);
             m_warp[inst.warp_id()].ibuffer_flush();
         }
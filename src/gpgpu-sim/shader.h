@@ -31,6 +31,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include <map>
@@ -53,6 +54,7 @@
 #include "stats.h"
 #include "gpu-cache.h"
 #include "traffic_breakdown.h"
+#include "warp_trace.h"
 
 
 
@@ -89,6 +91,13 @@ public:
    bool m_active; 
 };
 
+// Mid-kernel timing checkpoints: the dynamic part of an issued instruction,
+// restored onto a copy of the decoded instruction at its pc. Per-thread
+// addresses and the memory access queue are not saved (see
+// shader_core_ctx::checkpoint_inst() for instructions that still need them).
+void checkpoint_warp_inst( checkpoint_file &cp, warp_inst_t &inst );
+void checkpoint_mem_access( checkpoint_file &cp, mem_access_t &access );
+
 class shd_warp_t {
 public:
     shd_warp_t( class shader_core_ctx *shader, unsigned warp_size) 
@@ -112,16 +121,25 @@ public:
         m_last_fetch=0;
         m_next=0;
         m_inst_at_barrier=NULL;
+        m_n_committed=0;
+        m_last_issue_cycle=0;
+        m_n_loads=0;
+        m_avg_load_transactions=0;
     }
     void init( address_type start_pc,
                unsigned cta_id,
                unsigned wid,
                const std::bitset<MAX_WARP_SIZE> &active,
-               unsigned dynamic_warp_id )
+               unsigned dynamic_warp_id,
+               unsigned long long cycle )
     {
         m_cta_id=cta_id;
         m_warp_id=wid;
         m_dynamic_warp_id=dynamic_warp_id;
+        m_n_committed=0;
+        m_last_issue_cycle=cycle;
+        m_n_loads=0;
+        m_avg_load_transactions=0;
         m_next_pc=start_pc;
         assert( n_completed >= active.count() );
         assert( n_completed <= m_warp_size);
@@ -228,9 +246,25 @@ public:
 
     unsigned get_cta_id() const { return m_cta_id; }
 
+    // progress since init(): the cycle of the last issue and the instructions 
+    // committed (see shader_core_ctx::warp_inst_complete())
+    void issued( unsigned long long cycle ) { m_last_issue_cycle=cycle; }
+    void committed() { m_n_committed++; }
+    unsigned get_n_committed() const { return m_n_committed; }
+    unsigned long long get_last_issue_cycle() const { return m_last_issue_cycle; }
+    // running average of the memory transactions of the global/local loads
+    void record_load_transactions( unsigned n ) 
+    { 
+        m_avg_load_transactions = m_n_loads ? m_avg_load_transactions + (n - m_avg_load_transactions)/4 : n; 
+        m_n_loads++;
+    }
+    float get_avg_load_transactions() const { return m_avg_load_transactions; }
+
     unsigned get_dynamic_warp_id() const { return m_dynamic_warp_id; }
     unsigned get_warp_id() const { return m_warp_id; }
 
+    void checkpoint( checkpoint_file &cp );
+
 private:
     static const unsigned IBUFFER_SIZE=2;
     class shader_core_ctx *m_shader;
@@ -257,6 +291,10 @@ private:
                                    
     unsigned m_n_atomic;           // number of outstanding atomic operations 
     bool     m_membar;             // if true, warp is waiting at memory barrier
+    unsigned m_n_committed;
+    unsigned long long m_last_issue_cycle;
+    unsigned m_n_loads;
+    float m_avg_load_transactions;
 
     bool m_done_exit; // true once thread exit has been registered for threads in this warp
 
@@ -291,18 +329,6 @@ enum scheduler_prioritization_type
     SCHEDULER_PRIORITIZATION_YOUNGEST, // Youngest First
 };
 
-// Each of these corresponds to a string value in the gpgpsim.config file
-// For example - to specify the LRR scheudler the config must contain lrr
-enum concrete_scheduler
-{
-    CONCRETE_SCHEDULER_LRR = 0,
-    CONCRETE_SCHEDULER_CAWS,    /*cory*/
-    CONCRETE_SCHEDULER_GTO,
-    CONCRETE_SCHEDULER_TWO_LEVEL_ACTIVE,
-    CONCRETE_SCHEDULER_WARP_LIMITING,
-    NUM_CONCRETE_SCHEDULERS
-};
-
 class scheduler_unit { //this can be copied freely, so can be used in std containers.
 public:
     scheduler_unit(shader_core_stats* stats, shader_core_ctx* shader, 
@@ -314,11 +340,19 @@ public:
                    int id) 
         : m_supervised_warps(), m_stats(stats), m_shader(shader),
         m_scoreboard(scoreboard), m_simt_stack(simt), /*m_pipeline_reg(pipe_regs),*/ m_warp(warp),
-        m_sp_out(sp_out),m_sfu_out(sfu_out),m_mem_out(mem_out), m_id(id){}
+        m_sp_out(sp_out),m_sfu_out(sfu_out),m_mem_out(mem_out), m_id(id),
+        m_oldest_first_warps(), m_prioritized_order(PRIORITIZED_ORDER_NONE), m_prioritized_for(NULL){}
     virtual ~scheduler_unit(){}
     virtual void add_supervised_warp_id(int i) {
+        if ( m_supervised_index.size() <= (unsigned)i ) {
+            m_supervised_index.resize( i+1, -1 );
+        }
+        m_supervised_index[i] = m_supervised_warps.size();
         m_supervised_warps.push_back(&warp(i));
+        m_oldest_first_warps.push_back(&warp(i));
     }
+    // Called by the core when warp w is initialized with a new dynamic warp id
+    void warp_initialized( shd_warp_t *w );
     virtual void done_adding_supervised_warps() {
         m_last_supervised_issued = m_supervised_warps.end();
     }
@@ -355,16 +389,46 @@ public:
                             OrderingType age_ordering,
                             bool (*priority_func)(U lhs, U rhs) );
     static bool sort_warps_by_oldest_dynamic_id(shd_warp_t* lhs, shd_warp_t* rhs);
+    // Same result as order_lrr() on m_supervised_warps, rebuilt only when 
+    // the last issued warp changes
+    void order_lrr_supervised();
+    // Same result as order_by_priority() with ORDERING_GREEDY_THEN_PRIORITY_FUNC and
+    // sort_warps_by_oldest_dynamic_id on m_supervised_warps, without copying and
+    // sorting the list every cycle
+    void order_greedy_then_oldest( unsigned num_warps_to_add );
 
     // Derived classes can override this function to populate
     // m_supervised_warps with their scheduling policies
     virtual void order_warps() = 0;
 
+    // Used when skipping the cycles of a stalled core (-gpgpu_skip_stalled_cycles).
+    // True if order_warps() only rebuilds m_next_cycle_prioritized_warps from the
+    // warp state, i.e. calling it on a core whose state does not change is a no-op.
+    virtual bool order_warps_is_stateless() const { return true; }
+    // shader_cycle_distro entry cycle() increments when no warp can issue
+    unsigned stalled_cycle_distro();
+    // LRR (0) or GTO (1), selects the prefetch for the loads of the supervised warps
+    virtual int scheduler_policy_gto() const;
+    // scheduler state that outlives a grid
+    virtual void checkpoint( checkpoint_file &cp ) {}
+    // the warp orderings, saved by a checkpoint taken in the middle of a grid
+    virtual void checkpoint_warps( checkpoint_file &cp );
+    // called once the function units of the core have been created
+    virtual void function_units_created() {}
+
 protected:
     virtual void do_on_warp_issued( unsigned warp_id,
                                     unsigned num_issued,
                                     const std::vector< shd_warp_t* >::const_iterator& prioritized_iter );
+    // false holds back pI, a memory instruction of warp_id, for this cycle;
+    // the other instructions of the warp can still issue
+    virtual bool memory_inst_allowed( unsigned warp_id, const warp_inst_t *pI ) { return true; }
+    // w is waiting, or its next instruction reads the result of a long operation
+    bool stalled_on_long_op( shd_warp_t *w );
     inline int get_sid() const;
+    inline const class gpgpu_sim *get_gpu() const;
+    // warps are saved by their index in m_warp
+    void checkpoint_warp_list( checkpoint_file &cp, std::vector< shd_warp_t* > &warps );
 protected:
     shd_warp_t& warp(int i);
 
@@ -392,8 +456,86 @@ protected:
 
 
     int m_id;
+
+    // m_supervised_warps ordered by dynamic warp id. A warp only gets a new 
+    // (the largest) dynamic warp id when it is initialized, so it is moved to
+    // the back then. Exited and waiting warps are left in place: cycle() passes
+    // over them wherever they are in m_next_cycle_prioritized_warps.
+    std::vector< shd_warp_t* > m_oldest_first_warps;
+    // The order m_next_cycle_prioritized_warps currently holds and the last
+    // issued (LRR) or greedy warp it was built for. Orderings that change the 
+    // list in other ways reset this to PRIORITIZED_ORDER_NONE.
+    enum prioritized_order {
+        PRIORITIZED_ORDER_NONE = 0,
+        PRIORITIZED_ORDER_LRR,
+        PRIORITIZED_ORDER_GREEDY_THEN_OLDEST
+    };
+    prioritized_order m_prioritized_order;
+    shd_warp_t* m_prioritized_for;
+    // position of each warp_id in m_supervised_warps, -1 if not supervised
+    std::vector< int > m_supervised_index;
 };
 
+// Creates the scheduler units of a core from -gpgpu_scheduler. Each policy
+// registers a factory under the name its configuration string starts with 
+// (the part before the first ':') with a REGISTER_SCHEDULER line at file 
+// scope, and parses the rest of the string itself. The Makefile collects these
+// lines from every source file of this directory into register_schedulers()
+// (scheduler_list.cc in the object directory), so a policy in a new file needs
+// no edit anywhere else. The call from that generated function is also what 
+// makes the linker keep the file's object from libgpu_uarch_sim.a. A policy 
+// outside shader.cc should use the public accessors of shader_core_ctx rather 
+// than its internals.
+typedef scheduler_unit* (*scheduler_factory)( shader_core_stats* stats, shader_core_ctx* shader,
+                                              Scoreboard* scoreboard, simt_stack** simt,
+                                              std::vector<shd_warp_t>* warp,
+                                              register_set* sp_out,
+                                              register_set* sfu_out,
+                                              register_set* mem_out,
+                                              int id,
+                                              char* config_string );
+
+class scheduler_registry {
+public:
+    static void add( const char *name, scheduler_factory factory );
+    // aborts if no policy is registered under the name of config_string
+    static scheduler_unit* create( shader_core_stats* stats, shader_core_ctx* shader,
+                                   Scoreboard* scoreboard, simt_stack** simt,
+                                   std::vector<shd_warp_t>* warp,
+                                   register_set* sp_out,
+                                   register_set* sfu_out,
+                                   register_set* mem_out,
+                                   int id,
+                                   char* config_string );
+    static void print_names( FILE *fp );
+
+    template < class T >
+    static scheduler_unit* construct( shader_core_stats* stats, shader_core_ctx* shader,
+                                      Scoreboard* scoreboard, simt_stack** simt,
+                                      std::vector<shd_warp_t>* warp,
+                                      register_set* sp_out,
+                                      register_set* sfu_out,
+                                      register_set* mem_out,
+                                      int id,
+                                      char* config_string )
+    {
+        return new T( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id, config_string );
+    }
+
+private:
+    // registers every policy the first time a scheduler is looked up
+    static std::map< std::string, scheduler_factory > &factories();
+};
+
+// Must stay on one line of the form REGISTER_SCHEDULER( "<name>", <class> ); 
+// for the Makefile to find it.
+#define REGISTER_SCHEDULER( name, scheduler_class ) \
+    void register_scheduler_##scheduler_class() { scheduler_registry::add( name, scheduler_registry::construct< scheduler_class > ); }
+
+// calls the register_scheduler_<class>() of every REGISTER_SCHEDULER line, 
+// generated by the Makefile
+void register_schedulers();
+
 class lrr_scheduler : public scheduler_unit {
 public:
 	lrr_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
@@ -402,7 +544,8 @@ public:
                     register_set* sp_out,
                     register_set* sfu_out,
                     register_set* mem_out,
-                    int id )
+                    int id,
+                    char* config_string )
 	: scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ){}
 	virtual ~lrr_scheduler () {}
 	virtual void order_warps ();
@@ -411,6 +554,116 @@ public:
     }
 };
 /*cory*/
+// <mode> of the caws:<epoch>:<mode> scheduler configuration
+enum caws_epoch_mode {
+    CAWS_EPOCH_LOADS = 0,         // every <epoch> L1D loads of the core, one policy per core
+    CAWS_EPOCH_CYCLES,            // every <epoch> core cycles, one policy per core
+    CAWS_EPOCH_LOADS_PER_SCHED,   // every <epoch> L1D loads of the scheduler's warps, one policy per scheduler unit
+    CAWS_EPOCH_CYCLES_PER_SCHED,  // every <epoch> core cycles, one policy per scheduler unit
+    NUM_CAWS_EPOCH_MODES
+};
+
+enum caws_policy {
+    CAWS_POLICY_LRR = 0,
+    CAWS_POLICY_GTO,
+    CAWS_POLICY_THROTTLE, // GTO over the oldest <warp_limit> warps only, as warp_limiting
+    NUM_CAWS_POLICIES
+};
+
+// Selects the CAWS policy from the locality counts of each epoch. Another 
+// policy than the current one is only adopted once it has won more than 
+// <hysteresis> epochs in a row, so that one noisy epoch does not flip it.
+class caws_policy_engine {
+public:
+    caws_policy_engine();
+    // throttle: select CAWS_POLICY_THROTTLE when intra-warp misses dominate
+    void configure( unsigned hysteresis, bool throttle );
+    caws_policy epoch( long long intra, long long inter, long long miss_intra, long long miss_inter, bool verbose );
+    // the same from the hits LRR and GTO are estimated to get on <loads> 
+    // sampled loads (see caws_shadow_tags)
+    caws_policy epoch_hits( long long loads, long long lrr_hits, long long gto_hits, bool verbose );
+    caws_policy policy() const { return m_policy; }
+    // the policy the last epoch voted for, adopted or not
+    caws_policy last_winner() const { return m_last_winner; }
+    void checkpoint( checkpoint_file &cp );
+
+    // epochs won by GTO and by LRR
+    int gto_num;
+    int lrr_num;
+private:
+    // adopts winner once it has won more than m_hysteresis epochs in a row
+    caws_policy adopt( caws_policy winner );
+
+    caws_policy m_policy;
+    caws_policy m_candidate;
+    caws_policy m_last_winner;
+    unsigned m_confidence; // epochs in a row m_candidate has won
+    unsigned m_hysteresis;
+    bool m_throttle;
+};
+
+// L1D loads sampled by caws_shadow_tags and the hits each policy is 
+// estimated to get on them
+struct caws_shadow_counts {
+    caws_shadow_counts() { loads=0; lrr_hits=0; gto_hits=0; }
+    unsigned long long loads;
+    unsigned long long lrr_hits;
+    unsigned long long gto_hits;
+};
+
+// Estimates the L1D hits of LRR and of GTO for caws:...:<source> 1. Loads to
+// <sampled_sets> L1D sets are buffered, and every <window> loads replayed into
+// two shadow tag arrays (LRU, as associative as the L1D) in the order each 
+// policy would issue them: LRR takes the n-th load of every warp in round n,
+// by warp slot, GTO all the loads of the oldest warp first. Stalls are not 
+// modelled, so either order is only approximated.
+class caws_shadow_tags {
+public:
+    caws_shadow_tags();
+    // n_sets and assoc of the L1D
+    void configure( unsigned sampled_sets, unsigned window, unsigned n_sets, unsigned assoc, 
+                    unsigned n_warps, shader_core_stats *stats );
+    bool enabled() const { return m_window != 0; }
+    // an L1D load of warp_id (dynamic warp id age), issued under GTO or LRR
+    void access( unsigned set_index, new_addr_type tag, unsigned warp_id, unsigned age, bool hit, bool gto );
+    const caws_shadow_counts &counts() const { return m_counts; }
+    // the counts since the last call
+    caws_shadow_counts epoch_counts();
+    void checkpoint( checkpoint_file &cp );
+
+private:
+    struct shadow_load {
+        new_addr_type tag;
+        unsigned set;      // sampled set
+        unsigned warp_id;
+        unsigned age;
+        unsigned round;    // loads of the warp earlier in the window
+        bool hit;          // in the L1D
+        bool gto;
+    };
+    void replay();
+    bool shadow_access( std::vector<new_addr_type> &tags, std::vector<unsigned long long> &stamps, 
+                        unsigned set, new_addr_type tag );
+    static bool lrr_order( const shadow_load &a, const shadow_load &b );
+    static bool gto_order( const shadow_load &a, const shadow_load &b );
+
+    unsigned m_stride;        // every m_stride-th set of the L1D is sampled
+    unsigned m_sampled_sets;
+    unsigned m_assoc;
+    unsigned m_window;        // 0 disables the estimator
+    std::vector<shadow_load> m_loads;    // of the current window
+    std::vector<unsigned> m_warp_loads;  // by warp slot, loads in the current window
+    // by sampled set and way, a time stamp of 0 is an empty way
+    std::vector<new_addr_type> m_lrr_tag;
+    std::vector<new_addr_type> m_gto_tag;
+    std::vector<unsigned long long> m_lrr_stamp;
+    std::vector<unsigned long long> m_gto_stamp;
+    unsigned long long m_stamp;
+    caws_shadow_counts m_counts;
+    caws_shadow_counts m_epoch_start;
+    shader_core_stats *m_stats;
+};
+
 class caws_scheduler : public scheduler_unit {
 public:
 	caws_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
@@ -419,10 +672,13 @@ public:
                     register_set* sp_out,
                     register_set* sfu_out,
                     register_set* mem_out,
-                    int id )
-	: scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ){}
+                    int id,
+                    char* config_string );
 	virtual ~caws_scheduler () {}
 	virtual void order_warps ();
+    virtual bool order_warps_is_stateless() const;
+    virtual int scheduler_policy_gto() const;
+    virtual void checkpoint( checkpoint_file &cp );
     virtual void done_adding_supervised_warps() {
         m_last_supervised_issued = m_supervised_warps.begin();
     }
@@ -433,6 +689,31 @@ public:
                             unsigned num_warps_to_add,
                             OrderingType age_ordering,
                             bool (*priority_func)(U lhs, U rhs) );
+
+private:
+    bool per_sched() const { return m_epoch_mode >= CAWS_EPOCH_LOADS_PER_SCHED; }
+    bool epoch_in_cycles() const { return m_epoch_mode == CAWS_EPOCH_CYCLES || m_epoch_mode == CAWS_EPOCH_CYCLES_PER_SCHED; }
+    unsigned long long epoch_now() const;
+    bool epoch_done() const;
+    void per_sched_epoch();
+    caws_policy policy() const;
+    // epoch statistics of a policy selection that started from previous
+    void record_epoch( const caws_policy_engine &engine, caws_policy previous );
+    // the parity counts of the warps this scheduler supervises
+    void supervised_locality( unsigned long long &loads, warp_locality_counts &counts ) const;
+
+    unsigned m_epoch;
+    caws_epoch_mode m_epoch_mode;
+    unsigned long long m_epoch_start; // cycle or load count the current epoch started at
+    unsigned m_num_warps_to_limit;     // CAWS_POLICY_THROTTLE, 0 disables it
+    // CAWS_EPOCH_*_PER_SCHED: this scheduler's policy and its counters at the
+    // start of the epoch
+    caws_policy_engine m_policy_engine;
+    warp_locality_counts m_epoch_locality;
+    // select the policy from the shadow tag estimates instead of the 
+    // locality counts
+    bool m_shadow_source;
+    caws_shadow_counts m_epoch_shadow;
 };
 /*cory*/
 
@@ -444,7 +725,8 @@ public:
                     register_set* sp_out,
                     register_set* sfu_out,
                     register_set* mem_out,
-                    int id )
+                    int id,
+                    char* config_string )
 	: scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ){}
 	virtual ~gto_scheduler () {}
 	virtual void order_warps ();
@@ -481,6 +763,8 @@ public:
     }
 	virtual ~two_level_active_scheduler () {}
     virtual void order_warps();
+    // warps are demoted/promoted between the two levels every cycle
+    virtual bool order_warps_is_stateless() const { return false; }
 	void add_supervised_warp_id(int i) {
         if ( m_next_cycle_prioritized_warps.size() < m_max_active_warps ) {
             m_next_cycle_prioritized_warps.push_back( &warp(i) );
@@ -492,6 +776,8 @@ public:
         m_last_supervised_issued = m_supervised_warps.begin();
     }
 
+    virtual void checkpoint_warps( checkpoint_file &cp );
+
 protected:
     virtual void do_on_warp_issued( unsigned warp_id,
                                     unsigned num_issued,
@@ -526,6 +812,181 @@ protected:
     unsigned m_num_warps_to_limit;
 };
 
+// Cache-conscious wavefront scheduling: GTO, with the global and local loads
+// of the warps that lose the most L1D locality held back. Each miss that hits
+// the victim tags of the missing warp raises its lost-locality score by 
+// <k_throttle>, which then decays by one per cycle. Warps are admitted oldest
+// and highest score first until their scores add up to more than 
+// <base_score> times the number of live warps; the rest may not issue loads.
+class ccws_scheduler : public scheduler_unit {
+public:
+	ccws_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                    Scoreboard* scoreboard, simt_stack** simt,
+                    std::vector<shd_warp_t>* warp,
+                    register_set* sp_out,
+                    register_set* sfu_out,
+                    register_set* mem_out,
+                    int id,
+                    char* config_string );
+	virtual ~ccws_scheduler () {}
+	virtual void order_warps ();
+    virtual bool order_warps_is_stateless() const { return false; }
+    virtual void function_units_created();
+    virtual void checkpoint_warps( checkpoint_file &cp );
+    virtual void done_adding_supervised_warps() {
+        m_last_supervised_issued = m_supervised_warps.begin();
+    }
+
+protected:
+    virtual bool memory_inst_allowed( unsigned warp_id, const warp_inst_t *pI );
+
+private:
+    void update_load_allowed();
+
+    unsigned m_vta_entries;  // victim tags per warp
+    unsigned m_k_throttle;
+    unsigned m_base_score;
+    victim_tag_array *m_victim_tags;
+    std::vector<bool> m_load_allowed; // by warp_id
+    std::vector< std::pair<unsigned,shd_warp_t*> > m_scored_warps;
+};
+
+// Two-level scheduler with one fetch group per CTA. The warps of the active
+// CTA go first, greedy then oldest, followed by the other warps oldest first.
+// The active CTA is kept until every one of its warps is stalled on a long
+// operation; the oldest CTA with a warp that is not then becomes active.
+class cta_aware_scheduler : public scheduler_unit {
+public:
+	cta_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                          Scoreboard* scoreboard, simt_stack** simt,
+                          std::vector<shd_warp_t>* warp,
+                          register_set* sp_out,
+                          register_set* sfu_out,
+                          register_set* mem_out,
+                          int id,
+                          char* config_string )
+	: scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ),
+	  m_active_cta(NO_ACTIVE_CTA), m_active_cta_last_warp(0) {}
+	virtual ~cta_aware_scheduler () {}
+	virtual void order_warps ();
+    // the active CTA only changes when order_warps() sees its warps stalled
+    virtual bool order_warps_is_stateless() const { return false; }
+    virtual void checkpoint_warps( checkpoint_file &cp );
+    virtual void done_adding_supervised_warps() {
+        m_last_supervised_issued = m_supervised_warps.begin();
+    }
+
+private:
+    // A hardware CTA id is reused as soon as its CTA exits, so the active CTA 
+    // is also identified by the dynamic warp id of its youngest warp: the 
+    // warps of a CTA issued into the same slot later all have larger ones.
+    bool in_active_cta( const shd_warp_t *w ) const
+    {
+        return !w->done_exit() && w->get_cta_id() == m_active_cta && 
+               w->get_dynamic_warp_id() <= m_active_cta_last_warp;
+    }
+    static const unsigned NO_ACTIVE_CTA = (unsigned)-1;
+    unsigned m_active_cta; // hardware CTA id
+    unsigned m_active_cta_last_warp;
+};
+
+// Greedy then oldest, except that while warps of a CTA wait at a barrier the 
+// CTA's lagging warps go first: the warps that committed the fewest 
+// instructions compared to their most advanced sibling, then those that 
+// issued longest ago.
+class barrier_aware_scheduler : public scheduler_unit {
+public:
+	barrier_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                              Scoreboard* scoreboard, simt_stack** simt,
+                              std::vector<shd_warp_t>* warp,
+                              register_set* sp_out,
+                              register_set* sfu_out,
+                              register_set* mem_out,
+                              int id,
+                              char* config_string );
+	virtual ~barrier_aware_scheduler () {}
+	virtual void order_warps ();
+    virtual void done_adding_supervised_warps() {
+        m_last_supervised_issued = m_supervised_warps.begin();
+    }
+
+protected:
+    virtual void do_on_warp_issued( unsigned warp_id,
+                                    unsigned num_issued,
+                                    const std::vector< shd_warp_t* >::const_iterator& prioritized_iter );
+
+private:
+    struct lagging_warp {
+        unsigned deficit;            // committed instructions behind the CTA's most advanced warp
+        unsigned long long stalled;  // cycles since the warp last issued
+        shd_warp_t *warp;
+        bool operator<( const lagging_warp &rhs ) const;
+    };
+    std::vector<lagging_warp> m_lagging_warps;
+    std::vector<bool> m_boosted;            // by warp_id
+    std::vector<unsigned> m_cta_max_committed; // by hardware CTA id
+};
+
+// Loose round robin (the order the L1D prefetcher predicts trailing warps 
+// for), with the warps whose prefetch has filled moved to the front and those
+// whose prefetch is still in flight moved to the back, so that their next 
+// load neither merges into the pending prefetch nor finds its line evicted.
+class prefetch_aware_scheduler : public scheduler_unit {
+public:
+	prefetch_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                               Scoreboard* scoreboard, simt_stack** simt,
+                               std::vector<shd_warp_t>* warp,
+                               register_set* sp_out,
+                               register_set* sfu_out,
+                               register_set* mem_out,
+                               int id,
+                               char* config_string )
+	: scheduler_unit ( stats, shader, scoreboard, simt, warp, sp_out, sfu_out, mem_out, id ){}
+	virtual ~prefetch_aware_scheduler () {}
+	virtual void order_warps ();
+    virtual void done_adding_supervised_warps() {
+        m_last_supervised_issued = m_supervised_warps.end();
+    }
+
+private:
+    std::vector< shd_warp_t* > m_in_flight_warps;
+};
+
+enum divergence_aware_mode {
+    DIVERGENCE_AWARE_COALESCED_FIRST = 0, // L1D miss resources near full
+    DIVERGENCE_AWARE_GTO,
+    DIVERGENCE_AWARE_DIVERGENT_FIRST,     // L1D miss resources idle
+    NUM_DIVERGENCE_AWARE_MODES
+};
+
+// Orders warps by their running average of memory transactions per load:
+// well coalesced warps first while the L1D MSHRs or miss queue are at least
+// <busy_pct> percent full, divergent warps first while they are at most 
+// <idle_pct> percent full, and greedy then oldest in between.
+class divergence_aware_scheduler : public scheduler_unit {
+public:
+	divergence_aware_scheduler ( shader_core_stats* stats, shader_core_ctx* shader,
+                                 Scoreboard* scoreboard, simt_stack** simt,
+                                 std::vector<shd_warp_t>* warp,
+                                 register_set* sp_out,
+                                 register_set* sfu_out,
+                                 register_set* mem_out,
+                                 int id,
+                                 char* config_string );
+	virtual ~divergence_aware_scheduler () {}
+	virtual void order_warps ();
+    virtual void done_adding_supervised_warps() {
+        m_last_supervised_issued = m_supervised_warps.begin();
+    }
+
+private:
+    static bool sort_warps_by_fewest_transactions( shd_warp_t* lhs, shd_warp_t* rhs );
+    static bool sort_warps_by_most_transactions( shd_warp_t* lhs, shd_warp_t* rhs );
+
+    unsigned m_busy_pct;
+    unsigned m_idle_pct;
+};
+
 
 
 class opndcoll_rfu_t { // operand collector based register file unit
@@ -555,6 +1016,17 @@ public:
         process_banks();
    }
 
+   // all collector units are free (and hence no register reads are queued)
+   bool quiescent() const
+   {
+      for( unsigned n=0; n < m_cu.size(); n++ ) 
+         if( !m_cu[n]->is_free() ) 
+            return false;
+      return true;
+   }
+   // equivalent of step() while quiescent() and no instruction is ready to issue
+   void skip_cycle() { m_arbiter.skip_cycle(); }
+
    void dump( FILE *fp ) const
    {
       fprintf(fp,"\n");
@@ -568,6 +1040,9 @@ public:
 
    shader_core_ctx *shader_core() { return m_shader; }
 
+   // collector units, queued register reads and dispatch priorities
+   void checkpoint( checkpoint_file &cp );
+
 private:
 
    void process_banks()
@@ -778,6 +1253,14 @@ private:
          for( unsigned b=0; b < m_num_banks; b++ ) 
             m_allocated_bank[b].reset();
       }
+      // allocate_reads() with no queued requests only rotates the priority diagonal
+      void skip_cycle()
+      {
+         unsigned square = ( m_num_banks > m_num_collectors ) ? m_num_banks : m_num_collectors;
+         m_last_cu = ( m_last_cu + 1 ) % square;
+      }
+      // bank grants only live within a cycle, so only the queues are saved
+      void checkpoint( checkpoint_file &cp, std::vector<collector_unit_t *> &cus );
 
    private:
       unsigned m_num_banks;
@@ -852,6 +1335,8 @@ private:
       }
       void dispatch();
       bool is_free(){return m_free;}
+      // outputs: the distinct output ports, m_output_register is saved as an index into it
+      void checkpoint( checkpoint_file &cp, const port_vector_t &outputs );
 
    private:
       bool m_free;
@@ -888,6 +1373,7 @@ private:
          }
          return NULL;
       }
+      void checkpoint( checkpoint_file &cp );
 
    private:
       unsigned m_num_collectors;
@@ -947,10 +1433,15 @@ public:
 
    // assertions
    bool warp_waiting_at_barrier( unsigned warp_id ) const;
+   bool any_warp_waiting_at_barrier() const { return m_warp_at_barrier.any(); }
+   // some warps of the CTA wait at a barrier for the others
+   bool cta_waiting_at_barrier( unsigned cta_id ) const;
 
    // debug
    void dump();
 
+   void checkpoint( checkpoint_file &cp );
+
 private:
    unsigned m_max_cta_per_core;
    unsigned m_max_warps_per_core;
@@ -961,6 +1452,11 @@ private:
    warp_set_t m_warp_active;
    warp_set_t m_warp_at_barrier;
    shader_core_ctx *m_shader;
+   std::vector<unsigned long long> m_arrival_cycle; // of the warps in m_warp_at_barrier
+
+   void arrive( unsigned warp_id );
+   // release the warps of m_warp_at_barrier in warps
+   void release( warp_set_t warps );
 
 };
 
@@ -1007,6 +1503,13 @@ public:
         fprintf(fp,"%s dispatch= ", m_name.c_str() );
         m_dispatch_reg->print(fp);
     }
+
+    // no instruction in flight: cycle() would only advance internal timers
+    virtual bool quiescent() const { return m_dispatch_reg->empty(); }
+    // equivalent of cycle() on a quiescent unit
+    virtual void skip_cycle() { occupied >>=1; }
+    // instructions in flight, saved by a checkpoint taken in the middle of a grid
+    virtual void checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp );
 protected:
     std::string m_name;
     const shader_core_config *m_config;
@@ -1047,6 +1550,14 @@ public:
     {
         return simd_function_unit::can_issue(inst);
     }
+    virtual bool quiescent() const
+    {
+        for( unsigned stage=0; stage < m_pipeline_depth; stage++ ) 
+            if( !m_pipeline_reg[stage]->empty() ) 
+                return false;
+        return simd_function_unit::quiescent();
+    }
+    virtual void checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp );
     virtual void print(FILE *fp) const
     {
         simd_function_unit::print(fp);
@@ -1124,6 +1635,17 @@ public:
     void fill( mem_fetch *mf );
     void flush();
     void writeback();
+    void checkpoint( checkpoint_file &cp );
+    virtual void checkpoint_pipeline( shader_core_ctx *core, checkpoint_file &cp );
+    // functional access of a fast-forwarded CTA; returns true if it continues to the L2
+    bool warm_l1d( const warp_inst_t &inst, mem_fetch *mf );
+    // CTA size of the kernel being issued, which sets the warps the L1D 
+    // locality monitor counts as neighbours
+    void set_warps_per_cta( unsigned warps_per_cta )
+    {
+        if( m_L1D ) 
+            m_L1D->set_locality_warps_per_cta(warps_per_cta);
+    }
 
     // accessors
     virtual unsigned clock_multiplier() const;
@@ -1141,6 +1663,8 @@ public:
 
     virtual void active_lanes_in_pipeline();
     virtual bool stallable() const { return true; }
+    virtual bool quiescent() const;
+    virtual void skip_cycle();
     bool response_buffer_full() const;
     void print(FILE *fout) const;
     void print_cache_stats( FILE *fp, unsigned& dl1_accesses, unsigned& dl1_misses );
@@ -1151,6 +1675,22 @@ public:
     void get_L1C_sub_stats(struct cache_sub_stats &css) const;
     void get_L1T_sub_stats(struct cache_sub_stats &css) const;
 
+    unsigned get_L1D_miss_resource_utilization() const {
+        if(m_L1D)
+            return m_L1D->miss_resource_utilization();
+        return 0;
+    }
+    prefetch_target_state get_L1D_prefetch_target_state( unsigned warp_id ) const {
+        if(m_L1D)
+            return m_L1D->get_prefetch_target_state(warp_id);
+        return PREFETCH_TARGET_NONE;
+    }
+    victim_tag_array *enable_L1D_victim_tags( unsigned n_warps, unsigned entries_per_warp, 
+                                              unsigned base_score, unsigned k_throttle ) {
+        if(m_L1D)
+            return m_L1D->enable_victim_tags(n_warps,entries_per_warp,base_score,k_throttle);
+        return NULL;
+    }
     int get_L1D_inter_warp_locality() const{    
         if(m_L1D)
             return m_L1D->get_tag_array_inter_warp_locality();
@@ -1176,11 +1716,19 @@ public:
         //m_L1D->flush_L1Dcache_hit_num();
     }
     void update_warp_locality(){
-        if(m_L1D){
+        // nothing to collect without an L1D locality monitor
+        const warp_locality_counts *parity = m_L1D ? m_L1D->get_tag_array_parity_locality() : NULL;
+        if(parity){
             m_inter_warp_locality+=m_L1D->get_tag_array_inter_warp_locality();
             m_intra_warp_locality+=m_L1D->get_tag_array_intra_warp_locality();
             m_miss_inter_warp_locality+=m_L1D->get_tag_array_miss_inter_warp_locality();
             m_miss_intra_warp_locality+=m_L1D->get_tag_array_miss_intra_warp_locality();
+            for(int p=0;p<2;p++){
+                m_parity_locality[p].intra+=parity[p].intra;
+                m_parity_locality[p].inter+=parity[p].inter;
+                m_parity_locality[p].miss_intra+=parity[p].miss_intra;
+                m_parity_locality[p].miss_inter+=parity[p].miss_inter;
+            }
             m_L1D->flush_tag_array_inter_warp_locality();
         }
     }
@@ -1200,9 +1748,12 @@ public:
     int m_miss_intra_warp_locality;
     int m_miss_inter_warp_locality;
     int scheduler_policy_gto;
+    // L1D loads and locality counts by warp id parity, never flushed: 
+    // per-scheduler CAWS epochs take differences
+    unsigned long long m_parity_loads[2];
+    warp_locality_counts m_parity_locality[2];
 
-    cache_prefetch *m_cache_prefetch;
-    bool use_prefetch;
+    bool use_prefetch; // the L1D has a prefetcher
 protected:
     ldst_unit( mem_fetch_interface *icnt,
                shader_core_mem_fetch_allocator *mf_allocator,
@@ -1246,9 +1797,16 @@ protected:
    class mem_fetch_interface *m_icnt;
    shader_core_mem_fetch_allocator *m_mf_allocator;
    class shader_core_ctx *m_core;
+   class gpgpu_sim *m_gpu;
    unsigned m_sid;
    unsigned m_tpc;
 
+   // CAWS prefetching: the first global/local load issued by this core is the 
+   // parent instruction whose accesses are prefetched with every later load
+   bool m_caws_flag;
+   warp_inst_t m_parent_inst;
+   mem_access_t m_parent_inst_accessq;
+
    tex_cache *m_L1T; // texture cache
    read_only_cache *m_L1C; // constant cache
    l1_cache *m_L1D; // data cache
@@ -1337,6 +1895,33 @@ struct shader_core_config : public core_config
         m_L1T_config.init(m_L1T_config.m_config_string,FuncCachePreferNone);
         m_L1C_config.init(m_L1C_config.m_config_string,FuncCachePreferNone);
         m_L1D_config.init(m_L1D_config.m_config_string,FuncCachePreferNone);
+        l1d_locality_entries = 0;
+        l1d_locality_window = 0;
+        l1d_locality_leader_sets = 0;
+        if( strcmp(gpgpu_l1d_locality_monitor_string,"none") ) {
+            int ntok = sscanf(gpgpu_l1d_locality_monitor_string,"%u:%u:%u",&l1d_locality_entries,&l1d_locality_window,&l1d_locality_leader_sets);
+            if( ntok < 2 || l1d_locality_entries == 0 || l1d_locality_window == 0 ) {
+                printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_l1d_locality_monitor \"%s\", expected <entries>:<window>[:<leader_sets>] or none\n",
+                       gpgpu_l1d_locality_monitor_string);
+                abort();
+            }
+        }
+        l1d_prefetch_pcs = 0;
+        l1d_prefetch_records = 0;
+        if( strcmp(gpgpu_l1d_prefetcher_string,"none") ) {
+            int ntok = sscanf(gpgpu_l1d_prefetcher_string,"%u:%u",&l1d_prefetch_pcs,&l1d_prefetch_records);
+            if( ntok != 2 || l1d_prefetch_pcs == 0 ) {
+                printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_l1d_prefetcher \"%s\", expected <pcs>:<records> or none\n",
+                       gpgpu_l1d_prefetcher_string);
+                abort();
+            }
+        }
+        if( sscanf(gpgpu_caws_shadow_tags_string,"%u:%u",&caws_shadow_sets,&caws_shadow_window) != 2 
+            || caws_shadow_sets == 0 || caws_shadow_window == 0 ) {
+            printf("GPGPU-Sim uArch: ERROR ** invalid -gpgpu_caws_shadow_tags \"%s\", expected <sets>:<window>\n",
+                   gpgpu_caws_shadow_tags_string);
+            abort();
+        }
         gpgpu_cache_texl1_linesize = m_L1T_config.get_line_sz();
         gpgpu_cache_constl1_linesize = m_L1C_config.get_line_sz();
         m_valid = true;
@@ -1368,6 +1953,19 @@ struct shader_core_config : public core_config
     mutable cache_config m_L1T_config;
     mutable cache_config m_L1C_config;
     mutable l1d_cache_config m_L1D_config;
+    // the L1D locality monitor and prefetcher tables, 0 entries or pcs if left out
+    char *gpgpu_l1d_locality_monitor_string;
+    char *gpgpu_l1d_prefetcher_string;
+    char *gpgpu_caws_shadow_tags_string;
+    unsigned l1d_locality_entries;
+    unsigned l1d_locality_window;
+    unsigned l1d_locality_leader_sets; // 0 monitors every set
+    unsigned l1d_prefetch_pcs;
+    unsigned l1d_prefetch_records;
+    // the CAWS shadow tags, see caws_shadow_tags
+    unsigned caws_shadow_sets;
+    unsigned caws_shadow_window;
+    bool caws_verbose; // trace the CAWS epochs of shader 0
 
     bool gmem_skip_L1D; // on = global memory access always skip the L1 cache 
     
@@ -1413,6 +2011,7 @@ struct shader_core_config : public core_config
     unsigned ldst_unit_response_queue_size;
 
     int simt_core_sim_order; 
+    bool gpgpu_skip_idle_cores;
     
     unsigned mem2device(unsigned memid) const { return memid + n_simt_clusters; }
 };
@@ -1490,6 +2089,27 @@ struct shader_core_stats_pod {
     unsigned made_write_mfs;
     unsigned made_read_mfs;
 
+    // CAWS epochs by the policy in effect after the epoch, policy switches
+    // and epochs whose winner was held back by the hysteresis
+    unsigned caws_epoch_policy[NUM_CAWS_POLICIES];
+    unsigned caws_policy_switches;
+    unsigned caws_switches_held;
+    // loads sampled by the CAWS shadow tags, by the policy (LRR, GTO) they 
+    // were issued under, their L1D hits and the hits estimated for the policy
+    unsigned long long caws_shadow_loads[2];
+    unsigned long long caws_shadow_hits[2];
+    unsigned long long caws_shadow_predicted_hits[2];
+    // cycles a ready load was held back by the CCWS scheduler
+    unsigned ccws_throttled_loads;
+    // fetch groups the CTA-aware scheduler switched to
+    unsigned cta_aware_group_switches;
+    // warp cycles spent waiting at bar.sync and bar.red for the rest of the CTA
+    unsigned long long barrier_wait_cycles;
+    // instructions issued by the lagging warps the barrier-aware scheduler boosted
+    unsigned barrier_boosted_issues;
+    // scheduler cycles the divergence-aware scheduler spent in each mode
+    unsigned divergence_aware_cycles[NUM_DIVERGENCE_AWARE_MODES];
+
     unsigned *gpgpu_n_shmem_bank_access;
     long *n_simt_to_mem; // Interconnect power stats
     long *n_mem_to_simt;
@@ -1552,12 +2172,36 @@ public:
 
         m_shader_dynamic_warp_issue_distro.resize( config->num_shader() );
         m_shader_warp_slot_issue_distro.resize( config->num_shader() );
+        m_shader_warp_slot_loads.resize( config->num_shader() );
+        m_shader_warp_slot_load_transactions.resize( config->num_shader() );
+        m_parent = NULL;
+    }
+
+    // Shard used by one SIMT cluster when clusters are stepped on multiple host 
+    // threads. Per-shader arrays are shared with the parent (each core only 
+    // writes its own entry); counters shared by all cores are accumulated 
+    // privately and added to the parent by merge_shard().
+    shader_core_stats( shader_core_stats *parent )
+    {
+        m_config = parent->m_config;
+        m_parent = parent;
+        shader_core_stats_pod *pod = reinterpret_cast< shader_core_stats_pod * > ( this->shader_core_stats_pod_start );
+        const shader_core_stats_pod *parent_pod = reinterpret_cast< const shader_core_stats_pod * > ( parent->shader_core_stats_pod_start );
+        memcpy(pod,parent_pod,sizeof(shader_core_stats_pod));
+        shader_cycle_distro = (unsigned*) calloc(m_config->warp_size+3, sizeof(unsigned));
+        m_outgoing_traffic_stats = new traffic_breakdown("coretomem"); 
+        m_incoming_traffic_stats = new traffic_breakdown("memtocore"); 
+        clear_shard_counters();
     }
 
     ~shader_core_stats()
     {
         delete m_outgoing_traffic_stats; 
         delete m_incoming_traffic_stats; 
+        if( m_parent ) {
+            free(shader_cycle_distro);
+            return;
+        }
         free(m_num_sim_insn); 
         free(m_num_sim_winsn);
         free(m_n_diverge); 
@@ -1570,6 +2214,13 @@ public:
     }
 
     void event_warp_issued( unsigned s_id, unsigned warp_id, unsigned num_issued, unsigned dynamic_warp_id );
+    // a global/local load of warp_id generated n_transactions memory accesses
+    void event_warp_load( unsigned s_id, unsigned warp_id, unsigned n_transactions );
+
+    // add the counters accumulated by this shard to its parent and reset them
+    void merge_shard();
+
+    void checkpoint( checkpoint_file &cp );
 
     void visualizer_print( gzFile visualizer_file );
 
@@ -1585,8 +2236,21 @@ public:
         return m_shader_warp_slot_issue_distro;
     }
 
+    const std::vector< std::vector<unsigned> >& get_warp_slot_loads() const
+    {
+        return m_shader_warp_slot_loads;
+    }
+
+    const std::vector< std::vector<unsigned> >& get_warp_slot_load_transactions() const
+    {
+        return m_shader_warp_slot_load_transactions;
+    }
+
 private:
+    void clear_shard_counters();
+
     const shader_core_config *m_config;
+    shader_core_stats *m_parent; // non-NULL for a per-cluster shard
 
     traffic_breakdown *m_outgoing_traffic_stats; // core to memory partitions
     traffic_breakdown *m_incoming_traffic_stats; // memory partition to core 
@@ -1596,6 +2260,9 @@ private:
     std::vector<unsigned> m_last_shader_dynamic_warp_issue_distro;
     std::vector< std::vector<unsigned> > m_shader_warp_slot_issue_distro;
     std::vector<unsigned> m_last_shader_warp_slot_issue_distro;
+    // global/local loads and their memory transactions for each warp slot
+    std::vector< std::vector<unsigned> > m_shader_warp_slot_loads;
+    std::vector< std::vector<unsigned> > m_shader_warp_slot_load_transactions;
 
     friend class power_stat_t;
     friend class shader_core_ctx;
@@ -1608,11 +2275,12 @@ private:
 
 class shader_core_mem_fetch_allocator : public mem_fetch_allocator {
 public:
-    shader_core_mem_fetch_allocator( unsigned core_id, unsigned cluster_id, const memory_config *config )
+    shader_core_mem_fetch_allocator( unsigned core_id, unsigned cluster_id, const memory_config *config, class gpgpu_sim *gpu )
     {
     	m_core_id = core_id;
     	m_cluster_id = cluster_id;
     	m_memory_config = config;
+    	m_gpu = gpu;
     }
     mem_fetch *alloc( new_addr_type addr, mem_access_type type, unsigned size, bool wr ) const 
     {
@@ -1623,7 +2291,8 @@ public:
     				       -1, 
     				       m_core_id, 
     				       m_cluster_id,
-    				       m_memory_config);
+    				       m_memory_config,
+    				       m_gpu);
     	return mf;
     }
     
@@ -1637,6 +2306,7 @@ public:
                                       m_core_id, 
                                       m_cluster_id, 
                                       m_memory_config,
+                                      m_gpu,
                                       inst.cta_id());
         return mf;
     }
@@ -1645,6 +2315,7 @@ private:
     unsigned m_core_id;
     unsigned m_cluster_id;
     const memory_config *m_memory_config;
+    class gpgpu_sim *m_gpu;
 };
 
 class shader_core_ctx : public core_t {
@@ -1661,9 +2332,25 @@ public:
 // used by simt_core_cluster:
     // modifiers
     void cycle();
+    // A core is quiescent when cycle() would only update statistics and 
+    // round-robin state until a memory response or a new CTA arrives. 
+    // begin_skip() is called once the core is found quiescent, then 
+    // skip_cycle() replaces cycle() until the core is woken up.
+    bool quiescent();
+    void begin_skip();
+    void skip_cycle();
     void reinit(unsigned start_thread, unsigned end_thread, bool reset_not_completed );
-    void issue_block2core( class kernel_info_t &kernel );
+    unsigned issue_block2core( class kernel_info_t &kernel );
+    // Sampled simulation (-gpgpu_sample_*) and the grids ahead of a restored 
+    // checkpoint: runs a CTA just issued by issue_block2core() to completion 
+    // without timing, warming the L1D, the L2 and the L1D prefetcher with its 
+    // accesses if warm is set. Returns the number of thread instructions executed.
+    unsigned long long functional_execute_cta( unsigned cta_id, bool warm );
     void cache_flush();
+    void checkpoint( checkpoint_file &cp );
+    // an instruction issued by this core, with the per-thread addresses, the 
+    // memory accesses not yet sent and the dispatch delay left
+    void checkpoint_inst( checkpoint_file &cp, warp_inst_t &inst );
     void accept_fetch_response( mem_fetch *mf );
     void accept_ldst_unit_response( class mem_fetch * mf );
     void broadcast_barrier_reduction(unsigned cta_id, unsigned bar_id,warp_set_t warps);
@@ -1684,6 +2371,7 @@ public:
     unsigned isactive() const {if(m_n_active_cta>0) return 1; else return 0;}
     kernel_info_t *get_kernel() { return m_kernel; }
     unsigned get_sid() const {return m_sid;}
+    class gpgpu_sim *get_gpu() const { return m_gpu; }
 
 // used by functional simulation:
     // modifiers
@@ -1691,9 +2379,14 @@ public:
     
     // accessors
     virtual bool warp_waiting_at_barrier( unsigned warp_id ) const;
+    bool any_warp_waiting_at_barrier() const { return m_barriers.any_warp_waiting_at_barrier(); }
+    bool cta_waiting_at_barrier( unsigned cta_id ) const { return m_barriers.cta_waiting_at_barrier(cta_id); }
     void get_pdom_stack_top_info( unsigned tid, unsigned *pc, unsigned *rpc ) const;
 
 // used by pipeline timing model components:
+    // pc and active mask of the next instruction of a warp: the top of its 
+    // SIMT stack, or its next trace entry when replaying a warp trace
+    void get_next_inst_info( unsigned warp_id, unsigned *pc, active_mask_t *active_mask ) const;
     // modifiers
     void mem_instruction_stats(const warp_inst_t &inst);
     void decrement_atomic_count( unsigned wid, unsigned n );
@@ -1716,6 +2409,8 @@ public:
     void get_L1T_sub_stats(struct cache_sub_stats &css) const;
 
     void get_icnt_power_stats(long &n_simt_to_mem, long &n_mem_to_simt) const;
+
+// used by scheduler policies:
     /*cory*/
     int get_L1Dcache_hit_num(){
         if(m_ldst_unit)
@@ -1765,20 +2460,45 @@ public:
             return m_ldst_unit->scheduler_policy_gto; 
         return -1;
     }
+    unsigned long long get_parity_loads( unsigned parity ) const {
+        return m_ldst_unit->m_parity_loads[parity];
+    }
+    const warp_locality_counts &get_parity_locality( unsigned parity ) const {
+        return m_ldst_unit->m_parity_locality[parity];
+    }
+    // the policy of the scheduler unit supervising warp_id
+    int warp_scheduler_policy_gto( unsigned warp_id ){
+        return schedulers[warp_id % m_config->gpgpu_num_sched_per_core]->scheduler_policy_gto();
+    }
     void flush_stat(){
         if(m_ldst_unit){
             m_ldst_unit->flush_stat();
             m_ldst_unit->LDST_inst=0;
         }
     }
-    int gto_num;
-    int lrr_num;
+    // CAWS policy of the core (caws:<epoch>:0 and caws:<epoch>:1)
+    caws_policy_engine &caws_policy() { return m_caws_policy; }
+    caws_shadow_tags &caws_shadow() { return m_caws_shadow; }
+    unsigned warp_dynamic_id( unsigned warp_id ) const { return m_warp[warp_id].get_dynamic_warp_id(); }
+    // percentage of the L1D MSHRs or miss queue in use, 0 without an L1D
+    unsigned L1D_miss_resource_utilization() const {
+        return m_ldst_unit->get_L1D_miss_resource_utilization();
+    }
+    // the L1D prefetch issued on behalf of warp_id
+    prefetch_target_state prefetch_target( unsigned warp_id ) const {
+        return m_ldst_unit->get_L1D_prefetch_target_state( warp_id );
+    }
+    // NULL if the core has no L1D
+    victim_tag_array *enable_L1D_victim_tags( unsigned entries_per_warp, unsigned base_score, unsigned k_throttle ) {
+        return m_ldst_unit->enable_L1D_victim_tags( m_config->max_warps_per_shader, entries_per_warp, base_score, k_throttle );
+    }
     /*cory*/
 // debug:
     void display_simt_state(FILE *fout, int mask ) const;
     void display_pipeline( FILE *fout, int print_mem, int mask3bit ) const;
 
     void incload_stat() {m_stats->m_num_loadqueued_insn[m_sid]++;}
+    void inc_barrier_wait_stat( unsigned long long cycles ) { m_stats->barrier_wait_cycles += cycles; }
     void incstore_stat() {m_stats->m_num_storequeued_insn[m_sid]++;}
     void incialu_stat(unsigned active_count,double latency) {
 		if(m_config->gpgpu_clock_gated_lanes==false){
@@ -1895,7 +2615,9 @@ public:
     virtual void checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned t, unsigned tid);
     address_type next_pc( int tid ) const;
     void fetch();
+    void reclaim_warp( unsigned warp_id );
     void register_cta_thread_exit( unsigned cta_num );
+    void warm_caches( warp_inst_t &inst );
 
     void decode();
     
@@ -1904,20 +2626,26 @@ public:
     friend class TwoLevelScheduler;
     friend class LooseRoundRobbinScheduler;
     friend class ldst_unit;
-    friend class caws_scheduler;/*cory*/
 
 
     void issue_warp( register_set& warp, const warp_inst_t *pI, const active_mask_t &active_mask, unsigned warp_id );
     void func_exec_inst( warp_inst_t &inst );
+    void replay_warp_inst( warp_inst_t &inst );
+    void replay_simt_stack( unsigned warp_id, warp_inst_t *inst );
+    void rebuild_simt_stack( unsigned warp_id );
 
      // Returns numbers of addresses in translated_addrs
     unsigned translate_local_memaddr( address_type localaddr, unsigned tid, unsigned num_shader, unsigned datasize, new_addr_type* translated_addrs );
+    // distance between the translated addresses of consecutive local memory words
+    unsigned local_mem_word_stride( unsigned num_shader ) const;
+    void checkpoint_register_set( checkpoint_file &cp, register_set &regs );
 
     void read_operands();
     
     void execute();
     
     void writeback();
+    void sample_pipeline_duty_cycle();
     
     // used in display_pipeline():
     void dump_warp_state( FILE *fout ) const;
@@ -1976,6 +2704,20 @@ public:
     unsigned num_result_bus;
     std::vector< std::bitset<MAX_ALU_LATENCY>* > m_result_bus;
 
+    // shader_cycle_distro increments of one skipped cycle (see begin_skip())
+    unsigned m_skip_cycle_distro[3];
+
+    // last instruction of each warp in functional_execute_cta(), kept for 
+    // broadcast_barrier_reduction() like the pipeline registers in issue_warp()
+    std::vector<warp_inst_t> m_ff_inst;
+
+    // warp traces (-gpgpu_warp_trace): the instructions of each hardware warp, 
+    // and the trace file and grid CTA id of each hardware CTA slot
+    enum warp_trace_mode m_warp_trace_mode;
+    std::vector<warp_trace_stream> m_warp_trace;
+    class warp_trace_file *m_cta_trace_file[MAX_CTA_PER_SHADER];
+    unsigned m_cta_trace_id[MAX_CTA_PER_SHADER];
+
     // used for local address mapping with single kernel launch
     unsigned kernel_max_cta_per_shader;
     unsigned kernel_padded_threads_per_cta;
@@ -1984,6 +2726,9 @@ public:
     // is that the dynamic_warp_id is a running number unique to every warp
     // run on this shader, where the warp_id is the static warp slot.
     unsigned m_dynamic_warp_id;
+
+    caws_policy_engine m_caws_policy;
+    caws_shadow_tags m_caws_shadow;
 };
 
 class simt_core_cluster {
@@ -1999,8 +2744,12 @@ public:
     void icnt_cycle();
 
     void reinit();
-    unsigned issue_block2core();
+    // if ff_insn is given, the CTA is executed functionally to completion 
+    // (see shader_core_ctx::functional_execute_cta()) and its thread 
+    // instructions are added to *ff_insn
+    unsigned issue_block2core( unsigned long long *ff_insn = NULL, bool warm = true );
     void cache_flush();
+    void checkpoint( checkpoint_file &cp );
     bool icnt_injection_buffer_full(unsigned size, bool write);
     void icnt_inject_request_packet(class mem_fetch *mf);
 
@@ -2018,6 +2767,8 @@ public:
     void print_not_completed( FILE *fp ) const;
     unsigned get_n_active_cta() const;
     unsigned get_n_active_sms() const;
+    // every core runs as many CTAs of its kernel as it can hold
+    bool fully_occupied() const;
     gpgpu_sim *get_gpu() { return m_gpu; }
 
     void display_pipeline( unsigned sid, FILE *fout, int print_mem, int mask );
@@ -2031,17 +2782,58 @@ public:
 
     void get_icnt_stats(long &n_simt_to_mem, long &n_mem_to_simt) const;
 
+    // updates from this cluster's cores to state shared with other clusters
+    void inc_gpu_sim_insn( unsigned n );
+    void set_gpu_sim_insn_last_update( unsigned sid );
+    void cta_exit( unsigned sid, kernel_info_t *released_kernel );
+
+    // When clusters are stepped on multiple host threads (-gpgpu_sim_threads),
+    // the updates above, interconnect injection, memory latency stats, mem_fetch 
+    // uids and shared shader stats are buffered per cluster during icnt_cycle()
+    // and core_cycle(). gpgpu_sim calls merge_deferred() on every cluster in 
+    // cluster order after each phase, so results match a single-threaded run.
+    void merge_deferred();
+
+    // Skipping the cycles of a stalled cluster (-gpgpu_skip_stalled_cycles): 
+    // quiescent() holds while no response is waiting to be handed to a core 
+    // and every core is quiescent; skip_cycle() then replaces core_cycle().
+    bool quiescent();
+    void begin_skip();
+    void skip_cycle();
+    bool response_fifo_empty() const { return m_response_fifo.empty(); }
+
 private:
+    void release_kernel( unsigned sid, kernel_info_t *kernel );
+
     unsigned m_cluster_id;
     gpgpu_sim *m_gpu;
     const shader_core_config *m_config;
-    shader_core_stats *m_stats;
+    shader_core_stats *m_stats; // per-cluster shard of the gpu-wide stats when deferring
     memory_stats_t *m_memory_stats;
     shader_core_ctx **m_core;
 
     unsigned m_cta_issue_next_core;
     std::list<unsigned> m_core_sim_order;
     std::list<mem_fetch*> m_response_fifo;
+    // active-core bitmap (-gpgpu_skip_idle_cores): a core is cleared once it has 
+    // no CTA and is quiescent, and set again when it is issued a CTA or handed 
+    // a memory response. Cleared cores only get skip_cycle() in core_cycle().
+    std::vector<bool> m_core_active;
+
+    // deferred updates (see merge_deferred())
+    struct deferred_icnt_push {
+        unsigned output;
+        mem_fetch *mf;
+        unsigned size;
+    };
+    bool m_defer_shared_updates;
+    std::vector<deferred_icnt_push> m_deferred_icnt_push;
+    unsigned m_deferred_icnt_flits; // injection buffer space taken by m_deferred_icnt_push
+    std::vector<mem_fetch*> m_deferred_read_done;
+    std::vector<mem_fetch*> m_deferred_mf_uid;
+    std::vector< std::pair<unsigned,kernel_info_t*> > m_deferred_cta_exit;
+    unsigned long long m_deferred_sim_insn;
+    int m_deferred_last_update_sid; // -1 if no instruction completed
 };
 
 class shader_memory_interface : public mem_fetch_interface {
@@ -2082,5 +2874,6 @@ private:
 
 
 inline int scheduler_unit::get_sid() const { return m_shader->get_sid(); }
+inline const gpgpu_sim *scheduler_unit::get_gpu() const { return m_shader->get_gpu(); }
 
 #endif /* SHADER_H */
@@ -40,11 +40,11 @@
                                          || Trace::sampling_core == -1))
 
 // Intended to be called from inside components of a shader core.
-// Depends on a get_sid() function
+// Depends on get_sid() and get_gpu() functions
 #define SHADER_DPRINTF(x, ...) do {\
     if (SHADER_DTRACE(x)) {\
         printf( SHADER_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
+                get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle,\
                 Trace::trace_streams_str[Trace::x],\
                 get_sid() );\
         printf(__VA_ARGS__);\
@@ -52,11 +52,11 @@
 } while (0)
 
 // Intended to be called from inside a scheduler_unit.
-// Depends on a m_id member
+// Depends on a m_id member and a get_gpu() function
 #define SCHED_DPRINTF(...) do {\
     if (SHADER_DTRACE(WARP_SCHEDULER)) {\
         printf( SCHED_PRINT_STR,\
-                gpu_sim_cycle + gpu_tot_sim_cycle,\
+                get_gpu()->gpu_sim_cycle + get_gpu()->gpu_tot_sim_cycle,\
                 Trace::trace_streams_str[Trace::WARP_SCHEDULER],\
                 get_sid(),\
                 m_id );\
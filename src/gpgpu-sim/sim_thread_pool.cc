@@ -0,0 +1,146 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "sim_thread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+sim_thread_pool::sim_thread_pool( unsigned n_threads )
+{
+    assert( n_threads > 0 );
+    m_n_threads = n_threads;
+    m_generation = 0;
+    m_n_busy = 0;
+    m_shutdown = false;
+    m_fn = NULL;
+    m_ctx = NULL;
+    m_n_items = 0;
+    pthread_mutex_init(&m_lock,NULL);
+    pthread_cond_init(&m_start_cond,NULL);
+    pthread_cond_init(&m_done_cond,NULL);
+
+    // thread 0 is the caller of parallel_for()
+    m_threads.resize(m_n_threads);
+    m_args.resize(m_n_threads);
+    for( unsigned t=1; t < m_n_threads; t++ ) {
+        m_args[t].pool = this;
+        m_args[t].tid = t;
+        if( pthread_create(&m_threads[t],NULL,worker_main,(void*)&m_args[t]) ) {
+            printf("GPGPU-Sim uArch: ERROR ** could not create simulation thread %u\n", t);
+            abort();
+        }
+    }
+}
+
+sim_thread_pool::~sim_thread_pool()
+{
+    pthread_mutex_lock(&m_lock);
+    m_shutdown = true;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_lock);
+    for( unsigned t=1; t < m_n_threads; t++ )
+        pthread_join(m_threads[t],NULL);
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_start_cond);
+    pthread_mutex_destroy(&m_lock);
+}
+
+void sim_thread_pool::run_slice( unsigned tid )
+{
+    for( unsigned i=tid; i < m_n_items; i += m_n_threads )
+        m_fn(m_ctx,i);
+}
+
+// A parallel_for() is issued every simulated core cycle, so waiting threads 
+// poll briefly before blocking on a condition variable to avoid paying for a 
+// wakeup on every cycle.
+#define SIM_THREAD_POOL_SPIN 4000
+
+void *sim_thread_pool::worker_main( void *arg )
+{
+    worker_arg *a = (worker_arg*) arg;
+    sim_thread_pool *pool = a->pool;
+    volatile unsigned long long *generation = &pool->m_generation;
+    unsigned long long seen = 0;
+    while( 1 ) {
+        for( unsigned spin=0; spin < SIM_THREAD_POOL_SPIN && *generation == seen; spin++ ) 
+            ;
+        if( *generation == seen ) {
+            pthread_mutex_lock(&pool->m_lock);
+            while( !pool->m_shutdown && pool->m_generation == seen )
+                pthread_cond_wait(&pool->m_start_cond,&pool->m_lock);
+            pthread_mutex_unlock(&pool->m_lock);
+        }
+        __sync_synchronize(); // task is published before the generation changes
+        if( pool->m_shutdown ) 
+            break;
+        seen = *generation;
+
+        pool->run_slice(a->tid);
+
+        if( __sync_sub_and_fetch(&pool->m_n_busy,1) == 0 ) {
+            // the caller checks m_n_busy while holding m_lock before waiting
+            pthread_mutex_lock(&pool->m_lock);
+            pthread_cond_signal(&pool->m_done_cond);
+            pthread_mutex_unlock(&pool->m_lock);
+        }
+    }
+    return NULL;
+}
+
+void sim_thread_pool::parallel_for( unsigned n, task_fn fn, void *ctx )
+{
+    if( m_n_threads == 1 || n <= 1 ) {
+        for( unsigned i=0; i < n; i++ )
+            fn(ctx,i);
+        return;
+    }
+    pthread_mutex_lock(&m_lock);
+    m_fn = fn;
+    m_ctx = ctx;
+    m_n_items = n;
+    m_n_busy = m_n_threads-1;
+    __sync_synchronize();
+    m_generation++;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_lock);
+
+    run_slice(0);
+
+    volatile unsigned *n_busy = &m_n_busy;
+    for( unsigned spin=0; spin < SIM_THREAD_POOL_SPIN && *n_busy > 0; spin++ ) 
+        ;
+    if( *n_busy > 0 ) {
+        pthread_mutex_lock(&m_lock);
+        while( *n_busy > 0 )
+            pthread_cond_wait(&m_done_cond,&m_lock);
+        pthread_mutex_unlock(&m_lock);
+    }
+    __sync_synchronize(); // make the workers' results visible to the caller
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SIM_THREAD_POOL_H
+#define SIM_THREAD_POOL_H
+
+#include <pthread.h>
+#include <vector>
+
+/// Persistent pool of host threads used to step independent timing model
+/// components (e.g. SIMT clusters) concurrently within one simulated cycle.
+///
+/// Work is split statically: thread t runs indices t, t+n, t+2n, ... so the
+/// assignment of components to threads never changes between cycles.
+/// The calling thread acts as thread 0 and parallel_for() only returns once
+/// every index has been processed, so it doubles as a barrier.
+class sim_thread_pool {
+public:
+    typedef void (*task_fn)( void *ctx, unsigned index );
+
+    sim_thread_pool( unsigned n_threads );
+    ~sim_thread_pool();
+
+    /// Run fn(ctx,i) for every i in [0,n) and wait for all of them to finish
+    void parallel_for( unsigned n, task_fn fn, void *ctx );
+
+    unsigned num_threads() const { return m_n_threads; }
+
+private:
+    struct worker_arg {
+        sim_thread_pool *pool;
+        unsigned tid;
+    };
+    static void *worker_main( void *arg );
+    void run_slice( unsigned tid );
+
+    unsigned m_n_threads;
+    std::vector<pthread_t> m_threads;
+    std::vector<worker_arg> m_args;
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_start_cond;
+    pthread_cond_t m_done_cond;
+    unsigned long long m_generation; // bumped for each parallel_for() call
+    unsigned m_n_busy;               // workers still running the current task
+    bool m_shutdown;
+
+    // current task
+    task_fn m_fn;
+    void *m_ctx;
+    unsigned m_n_items;
+};
+
+#endif
@@ -266,6 +266,13 @@ private:
    static int s_ids;
 };
 
+// each simulator instance owns its loggers; the functions below act on the
+// state most recently bound on the calling thread
+class stat_tool_state;
+stat_tool_state *stat_tool_create();
+void stat_tool_bind( stat_tool_state *state );
+void stat_tool_destroy( stat_tool_state *state );
+
 void try_snap_shot (unsigned long long  current_cycle);
 void set_spill_interval (unsigned long long  interval);
 void spill_log_to_file (FILE *fout, int final, unsigned long long  current_cycle);
@@ -1,5 +1,6 @@
 #include "traffic_breakdown.h" 
 #include "mem_fetch.h" 
+#include "checkpoint.h" 
 
 void traffic_breakdown::print(FILE* fout)
 {
@@ -21,6 +22,52 @@ void traffic_breakdown::record_traffic(class mem_fetch * mf, unsigned int size)
    m_stats[classify_memfetch(mf)][size] += 1; 
 }
 
+void traffic_breakdown::merge(traffic_breakdown &other) 
+{
+   for (traffic_stat_t::iterator i_stat = other.m_stats.begin(); i_stat != other.m_stats.end(); i_stat++) {
+      for (traffic_class_t::iterator i_class = i_stat->second.begin(); i_class != i_stat->second.end(); i_class++) {
+         if (i_class->second == 0) continue; 
+         m_stats[i_stat->first][i_class->first] += i_class->second; 
+         i_class->second = 0; // keep the entry so the next merge does not reallocate it 
+      }
+   }
+}
+
+void traffic_breakdown::checkpoint(checkpoint_file &cp) 
+{
+   cp.section(m_network_name.c_str()); 
+   size_t n_stat = m_stats.size(); 
+   cp.pod(n_stat); 
+   if (cp.saving()) {
+      for (traffic_stat_t::iterator i_stat = m_stats.begin(); i_stat != m_stats.end(); i_stat++) {
+         std::string name = i_stat->first; 
+         cp.string(name); 
+         std::vector<mf_packet_size> sizes; 
+         std::vector<unsigned int> counts; 
+         for (traffic_class_t::iterator i_class = i_stat->second.begin(); i_class != i_stat->second.end(); i_class++) {
+            sizes.push_back(i_class->first); 
+            counts.push_back(i_class->second); 
+         }
+         cp.vector(sizes); 
+         cp.vector(counts); 
+      }
+   } else {
+      m_stats.clear(); 
+      for (size_t i = 0; i < n_stat; i++) {
+         std::string name; 
+         cp.string(name); 
+         std::vector<mf_packet_size> sizes; 
+         std::vector<unsigned int> counts; 
+         cp.vector(sizes); 
+         cp.vector(counts); 
+         assert(sizes.size() == counts.size()); 
+         traffic_class_t &tc = m_stats[name]; 
+         for (size_t j = 0; j < sizes.size(); j++) 
+            tc[sizes[j]] = counts[j]; 
+      }
+   }
+}
+
 std::string traffic_breakdown::classify_memfetch(class mem_fetch * mf)
 {
    std::string traffic_name; 
@@ -18,6 +18,12 @@ public:
    // record the amount and type of traffic introduced by this mem_fetch object 
    void record_traffic(class mem_fetch * mf, unsigned int size); 
 
+   // add the traffic recorded by another breakdown to this one and zero its counts 
+   void merge(traffic_breakdown &other); 
+
+   // save/restore the recorded traffic 
+   void checkpoint(class checkpoint_file &cp); 
+
 protected:
 
    std::string m_network_name; 
@@ -0,0 +1,196 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "warp_trace.h"
+#include "checkpoint.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WARP_TRACE_MAGIC 0x57545232 /* "WTR2" */
+
+warp_trace_file::warp_trace_file( const char *filename, bool capture, const kernel_info_t &kernel, unsigned warp_size,
+                                  unsigned long long start_cycle )
+{
+    m_filename = filename;
+    m_capture = capture;
+    m_next_cta = 0;
+    m_n_ctas = kernel.num_blocks();
+    m_kernel_name = kernel.name();
+    m_start_cycle = start_cycle;
+    m_fp = gzopen(filename, capture?"wb":"rb");
+    if( m_fp == NULL ) {
+        printf("GPGPU-Sim uArch: ERROR ** could not open warp trace \"%s\" for %s\n",
+               filename, capture?"writing":"reading");
+        abort();
+    }
+    check(WARP_TRACE_MAGIC,WARP_TRACE_MAGIC,"format");
+    // the trace is only valid for the kernel launch it was captured from
+    std::string name = kernel.name();
+    std::vector<char> found_name(name.begin(),name.end());
+    vector(found_name);
+    if( !m_capture && std::string(found_name.begin(),found_name.end()) != name ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace \"%s\" was captured from kernel \'%s\', not \'%s\'\n",
+               filename, std::string(found_name.begin(),found_name.end()).c_str(), name.c_str());
+        abort();
+    }
+    check(warp_size,warp_size,"warp size");
+    check(kernel.threads_per_cta(),kernel.threads_per_cta(),"threads per CTA");
+    check(kernel.num_blocks(),kernel.num_blocks(),"number of CTAs");
+    printf("GPGPU-Sim uArch: %s warp trace \"%s\" for kernel \'%s\'\n",
+           capture?"capturing":"replaying", filename, name.c_str());
+}
+
+warp_trace_file::~warp_trace_file()
+{
+    if( m_capture && !m_pending.empty() ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace \"%s\": CTA %u never completed\n", m_filename.c_str(), m_next_cta);
+        abort();
+    }
+    if( gzclose(m_fp) != Z_OK )
+        fail("close");
+}
+
+void warp_trace_file::finish( unsigned long long cycle )
+{
+    if( m_next_cta != m_n_ctas || !m_pending.empty() )
+        return; // stopped early (-gpgpu_max_cta), no cycle count
+    unsigned long long cycles = cycle - m_start_cycle;
+    unsigned long long captured = cycles;
+    pod(captured);
+    if( !m_capture ) {
+        printf("GPGPU-Sim uArch: warp trace replay of kernel \'%s\': %llu cycles, execution-driven capture: %llu cycles (%+.2f%%)\n",
+               m_kernel_name.c_str(), cycles, captured, captured? 100.0 * ((double)cycles - captured) / captured : 0.0);
+    }
+}
+
+unsigned warp_trace_file::cta_id( const kernel_info_t &kernel, const dim3 &ctaid )
+{
+    dim3 grid = kernel.get_grid_dim();
+    return ctaid.x + grid.x*(ctaid.y + grid.y*ctaid.z);
+}
+
+void warp_trace_file::fail( const char *what )
+{
+    printf("GPGPU-Sim uArch: ERROR ** warp trace \"%s\": %s failed\n", m_filename.c_str(), what);
+    abort();
+}
+
+void warp_trace_file::raw( void *data, size_t size )
+{
+    if( size == 0 )
+        return;
+    if( m_capture ) {
+        if( gzwrite(m_fp,data,size) != (int)size )
+            fail("write");
+    } else {
+        if( gzread(m_fp,data,size) != (int)size )
+            fail("read (truncated trace?)");
+    }
+}
+
+void warp_trace_file::check( unsigned expected, unsigned found, const char *what )
+{
+    pod(found);
+    if( found != expected ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace \"%s\": %s is %u, expected %u\n",
+               m_filename.c_str(), what, found, expected);
+        abort();
+    }
+}
+
+void warp_trace_file::write_cta( unsigned cta_id, warp_trace_stream *warps, unsigned n_warps )
+{
+    assert( m_capture );
+    assert( cta_id >= m_next_cta && m_pending.find(cta_id) == m_pending.end() );
+    std::vector<warp_trace_stream> &cta = m_pending[cta_id];
+    cta.resize(n_warps);
+    for( unsigned w=0; w < n_warps; w++ ) {
+        cta[w].inst.swap(warps[w].inst);
+        cta[w].addr.swap(warps[w].addr);
+        warps[w].clear();
+    }
+    flush_pending();
+}
+
+void warp_trace_file::flush_pending()
+{
+    while( !m_pending.empty() && m_pending.begin()->first == m_next_cta ) {
+        std::vector<warp_trace_stream> &cta = m_pending.begin()->second;
+        unsigned n_warps = cta.size();
+        pod(m_next_cta);
+        pod(n_warps);
+        for( unsigned w=0; w < n_warps; w++ ) {
+            vector(cta[w].inst);
+            vector(cta[w].addr);
+        }
+        m_pending.erase(m_pending.begin());
+        m_next_cta++;
+    }
+}
+
+void warp_trace_file::read_cta( unsigned cta_id, warp_trace_stream *warps, unsigned n_warps )
+{
+    assert( !m_capture );
+    if( cta_id != m_next_cta ) {
+        printf("GPGPU-Sim uArch: ERROR ** warp trace \"%s\": CTA %u issued, the trace continues with CTA %u\n",
+               m_filename.c_str(), cta_id, m_next_cta);
+        abort();
+    }
+    check(cta_id,cta_id,"CTA id");
+    check(n_warps,n_warps,"warps per CTA");
+    for( unsigned w=0; w < n_warps; w++ ) {
+        warps[w].clear();
+        vector(warps[w].inst);
+        vector(warps[w].addr);
+    }
+    m_next_cta++;
+}
+
+// Only the read position is saved: a restore reopens the trace and skips the 
+// CTAs that were issued before the checkpoint.
+void warp_trace_file::checkpoint( checkpoint_file &cp )
+{
+    assert( !m_capture );
+    cp.pod(m_start_cycle);
+    unsigned next_cta = m_next_cta;
+    cp.pod(next_cta);
+    if( cp.saving() )
+        return;
+    while( m_next_cta < next_cta ) {
+        check(m_next_cta,m_next_cta,"CTA id");
+        unsigned n_warps;
+        pod(n_warps);
+        warp_trace_stream skipped;
+        for( unsigned w=0; w < n_warps; w++ ) {
+            vector(skipped.inst);
+            vector(skipped.addr);
+        }
+        m_next_cta++;
+    }
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, Wilson W.L. Fung, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WARP_TRACE_H
+#define WARP_TRACE_H
+
+#include "../abstract_hardware_model.h"
+
+#include <zlib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// -gpgpu_warp_trace
+enum warp_trace_mode {
+    WARP_TRACE_OFF = 0,
+    WARP_TRACE_CAPTURE,  // execute functionally and record each warp's instructions
+    WARP_TRACE_REPLAY    // feed the warps from a captured trace, no functional execution
+};
+
+// One dynamic warp instruction. The static part (opcode class, operands and
+// latencies) is decoded from the program on replay exactly as it is in an
+// execution-driven run; only what the functional model produces is recorded.
+struct warp_trace_inst {
+    address_type pc;
+    unsigned op;              // op_type, checked against the decoded instruction on replay
+    unsigned active_mask;
+    unsigned exit_mask;       // threads that finished with this instruction
+    unsigned data_size;
+    unsigned char space;      // memory space, resolved per thread for generic accesses
+    unsigned char space_bank;
+    unsigned char memory_op;
+    unsigned char atomic;
+};
+
+// The instructions and memory addresses of one warp, consumed in order
+struct warp_trace_stream {
+    warp_trace_stream() { clear(); }
+    void clear()
+    {
+        inst.clear();
+        addr.clear();
+        next_inst = 0;
+        next_addr = 0;
+    }
+    bool done() const { return next_inst == inst.size(); }
+    const warp_trace_inst &peek() const { return inst[next_inst]; }
+
+    std::vector<warp_trace_inst> inst;
+    std::vector<new_addr_type> addr; // one per active thread of each load and store, 
+                                     // local addresses before translation
+    unsigned next_inst;
+    unsigned next_addr;
+};
+
+// Compressed trace of one kernel launch, holding every CTA of the grid in
+// increasing CTA id order. CTAs are issued in that order in every timing
+// configuration, so replay reads the file sequentially and only keeps the
+// CTAs that are resident on a core in memory. Capture sees CTAs finish out
+// of order and holds each one back until all lower ids have been written.
+// A complete trace ends with the cycles the execution-driven run took from
+// the first CTA issue to the end of the kernel, which replay reports its own
+// cycles against.
+class warp_trace_file {
+public:
+    warp_trace_file( const char *filename, bool capture, const kernel_info_t &kernel, unsigned warp_size,
+                     unsigned long long start_cycle );
+    ~warp_trace_file();
+
+    // called when the kernel is done, at gpu_tot_sim_cycle + gpu_sim_cycle
+    void finish( unsigned long long cycle );
+
+    // the warps are taken from (capture) or loaded into (replay) warps[0..n_warps-1]
+    void write_cta( unsigned cta_id, warp_trace_stream *warps, unsigned n_warps );
+    void read_cta( unsigned cta_id, warp_trace_stream *warps, unsigned n_warps );
+
+    // linear CTA id used as the trace key
+    static unsigned cta_id( const kernel_info_t &kernel, const dim3 &ctaid );
+
+    // replay position for a timing checkpoint taken in the middle of the kernel
+    void checkpoint( class checkpoint_file &cp );
+
+private:
+    void raw( void *data, size_t size );
+    template<class T> void pod( T &v ) { raw(&v,sizeof(T)); }
+    template<class T> void vector( std::vector<T> &v )
+    {
+        unsigned n = v.size();
+        pod(n);
+        v.resize(n);
+        if( n )
+            raw(&v[0],n*sizeof(T));
+    }
+    void check( unsigned expected, unsigned found, const char *what );
+    void flush_pending();
+    void fail( const char *what );
+
+    gzFile m_fp;
+    bool m_capture;
+    std::string m_filename;
+    unsigned m_next_cta; // next CTA id to write or read
+    unsigned m_n_ctas;
+    std::string m_kernel_name;
+    unsigned long long m_start_cycle;
+    std::map< unsigned, std::vector<warp_trace_stream> > m_pending;
+};
+
+#endif